@@ -0,0 +1,344 @@
+/*
+    Copyright 2024 I. Laurentiu
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Memory efficiency benchmark.
+//
+// Measures how much memory vvectors actually cost: resident memory (from /proc/self/statm),
+// capacity slack (allocated but unused element slots), header bytes (metadata + allocator),
+// the separately allocated handle from vec_new_ and the overhead malloc adds on top of what we asked for.
+//
+// Usage: ./bin/bench_memory
+
+#define _POSIX_C_SOURCE 200809L
+// Capacity is only exposed through the debug functions.
+#define LIBVVECTOR_ENABLE_DEBUG_FN
+#include "vvector.h"
+
+#include <malloc.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define SMALL_NR_VECTORS 100000
+#define SMALL_NR_ELEMENTS 10
+
+#define HUGE_NR_VECTORS 4
+#define HUGE_NR_ELEMENTS (4 * 1024 * 1024)
+
+#define DRAIN_NR_ELEMENTS (4 * 1024 * 1024)
+#define DRAIN_KEEP_ELEMENTS (DRAIN_NR_ELEMENTS / 100)
+
+/* Allocators */
+
+/**
+ * @brief Bookkeeping for the counting allocator.
+ *
+ * Tracks what vvector asked for versus what malloc actually handed out.
+ */
+struct count_ctx {
+    ptrdiff_t requested;    /**< Live bytes requested by the library. */
+    ptrdiff_t usable;       /**< Live bytes malloc actually reserved for those requests. */
+    ptrdiff_t nr_calls;     /**< Number of malloc/realloc calls. */
+};
+
+void * count_malloc(ptrdiff_t size, void * ctx){
+    struct count_ctx * c = ctx;
+
+    void * ptr = malloc(size);
+    if (!ptr) return 0;
+
+    c->requested += size;
+    c->usable += malloc_usable_size(ptr);
+    c->nr_calls++;
+
+    return ptr;
+}
+
+void count_free(void * ptr, ptrdiff_t size, void * ctx){
+    struct count_ctx * c = ctx;
+
+    if (!ptr) return;
+
+    c->requested -= size;
+    c->usable -= malloc_usable_size(ptr);
+
+    free(ptr);
+}
+
+void * count_realloc(void * ptr, ptrdiff_t new_size, ptrdiff_t old_size, void * ctx){
+    struct count_ctx * c = ctx;
+
+    ptrdiff_t old_usable = (ptr) ? (ptrdiff_t) malloc_usable_size(ptr) : 0;
+
+    void * new_ptr = realloc(ptr, new_size);
+    if (!new_ptr) return 0;
+
+    c->requested += new_size - old_size;
+    c->usable += (ptrdiff_t) malloc_usable_size(new_ptr) - old_usable;
+    c->nr_calls++;
+
+    return new_ptr;
+}
+
+/* Growth policies */
+
+enum growth_policy {
+    GROW_PUSH,      /**< vvectorPushBack only, the library grows one page at a time. */
+    GROW_RESERVE,   /**< A single vvectorReserve for the final length, then vvectorPushBack. */
+    GROW_DOUBLE,    /**< The caller reserves 'length' more elements whenever the vector is full. */
+    GROW_SHRINK,    /**< Like GROW_DOUBLE up to twice the length, truncated to the length, then vvectorShrinkToFit. */
+};
+
+static const char * policy_names[] = {"push", "reserve", "double", "shrink"};
+
+/* Measurements */
+
+/**
+ * @brief Sum of everything we know about a set of vvectors.
+ */
+struct mem_report {
+    ptrdiff_t payload;      /**< length * element_size. */
+    ptrdiff_t header;       /**< Metadata, plus the allocator copy if present. */
+    ptrdiff_t slack;        /**< Allocated element slots which are not in use. */
+    ptrdiff_t handle;       /**< The pointer sized allocation made by vec_new_. */
+    ptrdiff_t malloc_over;  /**< malloc_usable_size() minus the bytes requested. */
+};
+
+/**
+ * @brief Read the resident set size of this process.
+ *
+ * @return Resident bytes, or -1 on error.
+ */
+static ptrdiff_t read_rss(void){
+    FILE * f = fopen("/proc/self/statm", "r");
+    if (!f) return -1;
+
+    long size = 0;
+    long resident = 0;
+    int nr_read = fscanf(f, "%ld %ld", &size, &resident);
+    fclose(f);
+
+    if (nr_read != 2) return -1;
+
+    return (ptrdiff_t) resident * sysconf(_SC_PAGESIZE);
+}
+
+/**
+ * @brief Number of bytes in front of the first element of 'vec'.
+ */
+static ptrdiff_t header_size(vvector vec){
+    if (vvector_debug_get_element_size(vec) < 0) return 3 * sizeof(ptrdiff_t) + sizeof(struct vvectorAlloc);
+
+    return 3 * sizeof(ptrdiff_t);
+}
+
+/**
+ * @brief Account one vvector in 'report'.
+ *
+ * Only valid for vvectors using malloc underneath, which is true for every allocator in this file.
+ */
+static void measure(vvector vec, struct mem_report * report){
+    ptrdiff_t capacity = vvector_debug_get_capacity(vec);
+    ptrdiff_t raw_element_size = vvector_debug_get_element_size(vec);
+
+    ptrdiff_t element_size = (raw_element_size < 0) ? -raw_element_size : raw_element_size;
+    ptrdiff_t header = header_size(vec);
+    ptrdiff_t payload = vvectorGetLength(vec) * element_size;
+
+    report->payload += payload;
+    report->header += header;
+    report->slack += capacity - header - payload;
+    report->handle += sizeof(uint8_t *);
+    report->malloc_over += (ptrdiff_t) malloc_usable_size(*vec) - capacity;
+    report->malloc_over += (ptrdiff_t) malloc_usable_size(vec) - (ptrdiff_t) sizeof(uint8_t *);
+}
+
+/**
+ * @brief Append 'count' ints to 'vec' following 'policy'.
+ *
+ * @return 0 on success, non-zero on error.
+ */
+static int grow(vvector vec, ptrdiff_t count, enum growth_policy policy){
+    int error = 0;
+
+    if (policy == GROW_RESERVE) {
+        error = vvectorReserve(vec, count);
+        if (error) return error;
+    }
+
+    // Overshoot, so there is something to give back.
+    ptrdiff_t nr_pushed = (policy == GROW_SHRINK) ? 2 * count : count;
+
+    for (ptrdiff_t i = 0; i < nr_pushed; i++) {
+        if (policy == GROW_DOUBLE || policy == GROW_SHRINK) {
+            ptrdiff_t length = vvectorGetLength(vec);
+            ptrdiff_t slots = (vvector_debug_get_capacity(vec) - header_size(vec)) / (ptrdiff_t) sizeof(int);
+
+            if (length >= slots) {
+                error = vvectorReserve(vec, (length) ? length : 1);
+                if (error) return error;
+            }
+        }
+
+        int value = (int) i;
+        error = vvectorPushBack(vec, &value);
+        if (error) return error;
+    }
+
+    if (policy == GROW_SHRINK) {
+        error = vvectorResizeUninit(vec, count);
+        if (!error) error = vvectorShrinkToFit(vec);
+        if (error) return error;
+    }
+
+    return 0;
+}
+
+static void print_header(void){
+    printf("%-10s %-8s %-8s %12s %12s %12s %12s %12s %12s %8s\n",
+           "scenario", "policy", "alloc", "payload", "header", "slack", "handle", "malloc_over", "rss_delta", "bytes/el");
+}
+
+static void print_row(const char * scenario, enum growth_policy policy, const char * alloc_name,
+                      struct mem_report * report, ptrdiff_t rss_delta, ptrdiff_t nr_elements){
+    ptrdiff_t total = report->payload + report->header + report->slack + report->handle + report->malloc_over;
+
+    printf("%-10s %-8s %-8s %12td %12td %12td %12td %12td %12td %8.2f\n",
+           scenario, policy_names[policy], alloc_name,
+           report->payload, report->header, report->slack, report->handle, report->malloc_over,
+           rss_delta, (double) total / (double) nr_elements);
+}
+
+/**
+ * @brief Free the first 'nr_vectors' vvectors of 'vectors', then the array itself.
+ */
+static int free_vectors(vvector * vectors, ptrdiff_t nr_vectors){
+    int error = 0;
+
+    for (ptrdiff_t v = 0; v < nr_vectors; v++) {
+        int err = vvectorFree(vectors[v]);
+        if (!error) error = err;
+    }
+    free(vectors);
+
+    return error;
+}
+
+/**
+ * @brief Create 'nr_vectors' vvectors holding 'nr_elements' ints each, report, then free them.
+ *
+ * With 'drain_to' >= 0, each vector is drained down to 'drain_to' elements after growing.
+ * The report is then taken once before and once after vvectorShrinkToFit.
+ */
+static int run(const char * scenario, ptrdiff_t nr_vectors, ptrdiff_t nr_elements, ptrdiff_t drain_to,
+               enum growth_policy policy, int use_counting_alloc){
+    struct count_ctx ctx = {0, 0, 0};
+    struct vvectorAlloc alloc = {count_malloc, count_free, count_realloc, &ctx};
+    const char * alloc_name = (use_counting_alloc) ? "counting" : "default";
+
+    vvector * vectors = malloc(nr_vectors * sizeof(vvector));
+    if (!vectors) return 1;
+
+    malloc_trim(0);
+    ptrdiff_t rss_before = read_rss();
+
+    for (ptrdiff_t v = 0; v < nr_vectors; v++) {
+        vectors[v] = vvectorNew(int, (use_counting_alloc) ? &alloc : 0);
+        if (!vectors[v]) {
+            free_vectors(vectors, v);
+            return 1;
+        }
+
+        int error = grow(vectors[v], nr_elements, policy);
+        if (error) {
+            free_vectors(vectors, v + 1);
+            return error;
+        }
+    }
+
+    ptrdiff_t final_length = nr_elements;
+
+    if (drain_to >= 0) {
+        struct mem_report grown = {0, 0, 0, 0, 0};
+        for (ptrdiff_t v = 0; v < nr_vectors; v++) {
+            measure(vectors[v], &grown);
+        }
+        print_row(scenario, policy, alloc_name, &grown, read_rss() - rss_before, nr_vectors * nr_elements);
+
+        for (ptrdiff_t v = 0; v < nr_vectors; v++) {
+            while (vvectorGetLength(vectors[v]) > drain_to) {
+                int error = vvectorRemoveBack(vectors[v]);
+                if (error) {
+                    free_vectors(vectors, nr_vectors);
+                    return error;
+                }
+            }
+        }
+
+        struct mem_report drained = {0, 0, 0, 0, 0};
+        for (ptrdiff_t v = 0; v < nr_vectors; v++) {
+            measure(vectors[v], &drained);
+        }
+        print_row("drained", policy, alloc_name, &drained, read_rss() - rss_before, nr_vectors * drain_to);
+
+        for (ptrdiff_t v = 0; v < nr_vectors; v++) {
+            int error = vvectorShrinkToFit(vectors[v]);
+            if (error) {
+                free_vectors(vectors, nr_vectors);
+                return error;
+            }
+        }
+        malloc_trim(0);
+
+        scenario = "shrunk";
+        final_length = drain_to;
+    }
+
+    struct mem_report report = {0, 0, 0, 0, 0};
+    for (ptrdiff_t v = 0; v < nr_vectors; v++) {
+        measure(vectors[v], &report);
+    }
+    print_row(scenario, policy, alloc_name, &report, read_rss() - rss_before, nr_vectors * final_length);
+
+    if (use_counting_alloc) {
+        printf("%-10s %-8s %-8s requested=%td usable=%td calls=%td\n", "", "", "", ctx.requested, ctx.usable, ctx.nr_calls);
+    }
+
+    int error = free_vectors(vectors, nr_vectors);
+    malloc_trim(0);
+
+    return error;
+}
+
+int main(){
+    printf("All sizes are in bytes. Elements are ints. bytes/el counts everything but RSS.\n\n");
+    print_header();
+
+    for (int use_counting_alloc = 0; use_counting_alloc <= 1; use_counting_alloc++) {
+        for (enum growth_policy p = GROW_PUSH; p <= GROW_SHRINK; p++) {
+            if (run("small", SMALL_NR_VECTORS, SMALL_NR_ELEMENTS, -1, p, use_counting_alloc)) return 1;
+        }
+        for (enum growth_policy p = GROW_PUSH; p <= GROW_SHRINK; p++) {
+            if (run("huge", HUGE_NR_VECTORS, HUGE_NR_ELEMENTS, -1, p, use_counting_alloc)) return 1;
+        }
+        for (enum growth_policy p = GROW_PUSH; p <= GROW_SHRINK; p++) {
+            if (run("drain", 1, DRAIN_NR_ELEMENTS, DRAIN_KEEP_ELEMENTS, p, use_counting_alloc)) return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,481 @@
+/*
+    Copyright 2024 I. Laurentiu
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Trace replay tool.
+//
+// Re-executes a trace recorded by a library built with LIBVVECTOR_ENABLE_TRACE (see vvectorTraceStart)
+// against whatever vvector build this tool is linked with, and reports timing per operation.
+// Values are not recorded, so written and inserted elements are filled with zeros, and the indices of gathers and scatters
+// are replaced by consecutive indices wrapping around the vvector.
+//
+// Usage: ./bin/replay <trace file> [--custom-alloc]
+//   --custom-alloc    Create every vvector with a (default filled) vvectorAlloc, exercising the custom allocator path.
+
+#define _POSIX_C_SOURCE 200809L
+#include "vvector.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const char * op_names[VVECTOR_TRACE_NR_OPS] = {
+    "?", "new", "free", "reserve", "shrink", "get_at", "write_at", "insert_at", "remove_at",
+    "append", "gather", "scatter", "scatter_s", "resize", "resize_u", "resize_z", "clear", "swap", "move", "splice", "adopt"
+};
+
+static volatile uint8_t replay_sink;
+
+/* vec_id -> vvector map */
+
+/**
+ * @brief Open addressing map from recorded vec_ids to the vvectors created during replay.
+ */
+struct vec_map {
+    uint64_t * keys;    /**< 0 marks an empty slot. */
+    vvector * values;
+    ptrdiff_t capacity; /**< Always a power of two. */
+    ptrdiff_t count;    /**< Occupied slots, including tombstones. */
+};
+
+static ptrdiff_t map_slot(struct vec_map * map, uint64_t key){
+    // Handles are heap pointers, so the low bits carry little information.
+    uint64_t hash = key * 0x9E3779B97F4A7C15u;
+    ptrdiff_t mask = map->capacity - 1;
+    ptrdiff_t i = (ptrdiff_t) (hash >> 32) & mask;
+
+    while (map->keys[i] && map->keys[i] != key) {
+        i = (i + 1) & mask;
+    }
+
+    return i;
+}
+
+static int map_grow(struct vec_map * map){
+    struct vec_map bigger = {0, 0, map->capacity * 2, 0};
+
+    bigger.keys = calloc(bigger.capacity, sizeof(uint64_t));
+    bigger.values = calloc(bigger.capacity, sizeof(vvector));
+    if (!bigger.keys || !bigger.values) return 1;
+
+    for (ptrdiff_t i = 0; i < map->capacity; i++) {
+        // Tombstones (key set, value NULL) are dropped here.
+        if (!map->keys[i] || !map->values[i]) continue;
+
+        ptrdiff_t slot = map_slot(&bigger, map->keys[i]);
+        bigger.keys[slot] = map->keys[i];
+        bigger.values[slot] = map->values[i];
+        bigger.count++;
+    }
+
+    free(map->keys);
+    free(map->values);
+    *map = bigger;
+
+    return 0;
+}
+
+/**
+ * @brief Returns the slot for 'key', inserting it if it is not present.
+ *
+ * @return The slot, or -1 if out of memory.
+ */
+static ptrdiff_t map_insert(struct vec_map * map, uint64_t key){
+    if (2 * (map->count + 1) > map->capacity) {
+        if (map_grow(map)) return -1;
+    }
+
+    ptrdiff_t slot = map_slot(map, key);
+    if (!map->keys[slot]) {
+        map->keys[slot] = key;
+        map->values[slot] = 0;
+        map->count++;
+    }
+
+    return slot;
+}
+
+/**
+ * @brief Returns the vvector recorded as 'key', creating it if the trace started after it was created.
+ *
+ * @return The vvector, or NULL if out of memory. 'nr_unknown' is incremented for every vvector created here.
+ */
+static vvector map_get(struct vec_map * map, uint64_t key, int32_t element_size, struct vvectorAlloc * alloc, ptrdiff_t * nr_unknown){
+    ptrdiff_t slot = map_insert(map, key);
+    if (slot < 0) return 0;
+
+    if (!map->values[slot]) {
+        map->values[slot] = vec_new_(element_size, alloc);
+        (*nr_unknown)++;
+    }
+
+    return map->values[slot];
+}
+
+/* Scratch buffers */
+
+/**
+ * @brief A zero filled buffer which only grows, for the values and indices of bulk operations.
+ */
+struct scratch {
+    uint8_t * data;
+    ptrdiff_t size;
+};
+
+/**
+ * @return At least 'size' zeroed bytes, or NULL if out of memory.
+ */
+static void * scratch_get(struct scratch * scratch, ptrdiff_t size){
+    if (size > scratch->size) {
+        uint8_t * bigger = calloc(size, 1);
+        if (!bigger) return 0;
+
+        free(scratch->data);
+        scratch->data = bigger;
+        scratch->size = size;
+    }
+
+    return scratch->data;
+}
+
+/**
+ * @brief 'n' consecutive indices into a vvector of 'length' elements, wrapping around.
+ *
+ * @return The indices, or NULL if out of memory or 'length' is 0.
+ */
+static ptrdiff_t * wrapped_indices(struct scratch * scratch, ptrdiff_t n, ptrdiff_t length){
+    if (length <= 0) return 0;
+
+    ptrdiff_t * indices = scratch_get(scratch, (n > 0 ? n : 1) * (ptrdiff_t) sizeof(ptrdiff_t));
+    if (!indices) return 0;
+
+    for (ptrdiff_t i = 0; i < n; i++) {
+        indices[i] = i % length;
+    }
+
+    return indices;
+}
+
+/* Trace loading */
+
+/**
+ * @brief A record and its position in the trace file, used to sort stably with qsort.
+ */
+struct sort_item {
+    struct vvectorTraceRecord record;
+    ptrdiff_t position;
+};
+
+static int compare_items(const void * a, const void * b){
+    const struct sort_item * ia = a;
+    const struct sort_item * ib = b;
+
+    if (ia->record.timestamp != ib->record.timestamp) return (ia->record.timestamp < ib->record.timestamp) ? -1 : 1;
+
+    return (ia->position > ib->position) - (ia->position < ib->position);
+}
+
+/**
+ * @brief Read a whole trace file and sort it by time.
+ *
+ * @return The records, or NULL on error. Their number is stored in 'count'.
+ */
+static struct vvectorTraceRecord * load_trace(const char * path, ptrdiff_t * count){
+    FILE * f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "Could not open %s\n", path);
+        return 0;
+    }
+
+    struct vvectorTraceHeader header;
+    if (fread(&header, sizeof(header), 1, f) != 1 || header.magic != VVECTOR_TRACE_MAGIC) {
+        fprintf(stderr, "%s is not a vvector trace\n", path);
+        fclose(f);
+        return 0;
+    }
+
+    if (header.version != VVECTOR_TRACE_VERSION || header.record_size != sizeof(struct vvectorTraceRecord)) {
+        fprintf(stderr, "%s: unsupported trace version %u\n", path, header.version);
+        fclose(f);
+        return 0;
+    }
+
+    ptrdiff_t capacity = 1024;
+    ptrdiff_t length = 0;
+    struct vvectorTraceRecord * records = malloc(capacity * sizeof(struct vvectorTraceRecord));
+
+    while (records) {
+        length += fread(&records[length], sizeof(struct vvectorTraceRecord), capacity - length, f);
+        if (length < capacity) break;
+
+        capacity *= 2;
+        struct vvectorTraceRecord * bigger = realloc(records, capacity * sizeof(struct vvectorTraceRecord));
+        if (!bigger) free(records);
+        records = bigger;
+    }
+    fclose(f);
+
+    if (!records) {
+        fprintf(stderr, "Out of memory\n");
+        return 0;
+    }
+
+    // Threads flush their buffers independently; a thread's records are in order, but threads are interleaved in batches.
+    // A stable sort on timestamp restores the global order.
+    struct sort_item * items = malloc(length * sizeof(struct sort_item));
+    if (!items) {
+        free(records);
+        fprintf(stderr, "Out of memory\n");
+        return 0;
+    }
+
+    for (ptrdiff_t i = 0; i < length; i++) {
+        items[i].record = records[i];
+        items[i].position = i;
+    }
+
+    qsort(items, length, sizeof(struct sort_item), compare_items);
+
+    for (ptrdiff_t i = 0; i < length; i++) {
+        records[i] = items[i].record;
+    }
+    free(items);
+
+    *count = length;
+    return records;
+}
+
+static uint64_t now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+int main(int argc, char ** argv){
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <trace file> [--custom-alloc]\n", argv[0]);
+        return 1;
+    }
+
+    int use_custom_alloc = (argc > 2 && strcmp(argv[2], "--custom-alloc") == 0);
+    struct vvectorAlloc alloc = {0, 0, 0, 0};
+
+    ptrdiff_t nr_records = 0;
+    struct vvectorTraceRecord * records = load_trace(argv[1], &nr_records);
+    if (!records) return 1;
+
+    // Scratch value for writes and inserts.
+    int32_t max_element_size = 1;
+    for (ptrdiff_t i = 0; i < nr_records; i++) {
+        if (records[i].element_size > max_element_size) max_element_size = records[i].element_size;
+    }
+    uint8_t * value = calloc(max_element_size, 1);
+
+    // Values of appends and scatters, output of gathers, and indices. Scattered values stay zero.
+    struct scratch values = {0, 0};
+    struct scratch output = {0, 0};
+    struct scratch indices = {0, 0};
+
+    struct vec_map map = {0, 0, 1024, 0};
+    map.keys = calloc(map.capacity, sizeof(uint64_t));
+    map.values = calloc(map.capacity, sizeof(vvector));
+    if (!value || !map.keys || !map.values) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    uint64_t op_count[VVECTOR_TRACE_NR_OPS] = {0};
+    uint64_t op_time[VVECTOR_TRACE_NR_OPS] = {0};
+    ptrdiff_t nr_failed = 0;
+    ptrdiff_t nr_unknown = 0;
+    uint8_t checksum = 0;
+
+    uint64_t start = now_ns();
+
+    for (ptrdiff_t i = 0; i < nr_records; i++) {
+        const struct vvectorTraceRecord * r = &records[i];
+
+        if (r->op == 0 || r->op >= VVECTOR_TRACE_NR_OPS) {
+            nr_unknown++;
+            continue;
+        }
+
+        ptrdiff_t slot = map_insert(&map, r->vec_id);
+        if (slot < 0) {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+
+        // The trace may have started after this vvector was created. Create it now.
+        if (!map.values[slot] && r->op != VVECTOR_TRACE_NEW && r->op != VVECTOR_TRACE_ADOPT) {
+            map.values[slot] = vec_new_(r->element_size, (use_custom_alloc) ? &alloc : 0);
+            nr_unknown++;
+        }
+
+        vvector vec = map.values[slot];
+        vvector other = 0;
+        int error = 0;
+
+        if (r->op == VVECTOR_TRACE_SWAP || r->op == VVECTOR_TRACE_MOVE || r->op == VVECTOR_TRACE_SPLICE) {
+            other = map_get(&map, r->other_id, r->element_size, (use_custom_alloc) ? &alloc : 0, &nr_unknown);
+            if (!other) {
+                fprintf(stderr, "Out of memory\n");
+                return 1;
+            }
+
+            // 'map' may have grown.
+            vec = map.values[map_insert(&map, r->vec_id)];
+        }
+
+        // Buffers are prepared outside of the timed region.
+        ptrdiff_t * batch_indices = 0;
+        uint8_t * batch_values = 0;
+        uint8_t * batch_output = 0;
+
+        if (r->op >= VVECTOR_TRACE_APPEND && r->op <= VVECTOR_TRACE_SCATTER_SORTED) {
+            batch_values = scratch_get(&values, (r->index > 0 ? r->index : 1) * (ptrdiff_t) r->element_size);
+            batch_output = scratch_get(&output, (r->index > 0 ? r->index : 1) * (ptrdiff_t) r->element_size);
+            if (r->op != VVECTOR_TRACE_APPEND) batch_indices = wrapped_indices(&indices, r->index, vvectorGetLength(vec));
+
+            if (!batch_values || !batch_output) {
+                fprintf(stderr, "Out of memory\n");
+                return 1;
+            }
+        }
+
+        uint64_t op_start = now_ns();
+
+        switch (r->op) {
+            case VVECTOR_TRACE_NEW:
+                if (vec) vvectorFree(vec);
+                vec = vec_new_(r->element_size, (use_custom_alloc) ? &alloc : 0);
+                map.values[slot] = vec;
+                error = (vec == 0);
+                break;
+            case VVECTOR_TRACE_ADOPT:
+                // The adopted contents are not recorded, zeroes stand in for them.
+                if (vec) vvectorFree(vec);
+                vec = vec_new_(r->element_size, (use_custom_alloc) ? &alloc : 0);
+                map.values[slot] = vec;
+                error = (vec == 0) || vvectorResizeZeroed(vec, r->index);
+                break;
+            case VVECTOR_TRACE_FREE:
+                error = vvectorFree(vec);
+                // Leave a tombstone, the handle address may be reused by a later NEW.
+                map.values[slot] = 0;
+                break;
+            case VVECTOR_TRACE_RESERVE:
+                error = vvectorReserve(vec, r->index);
+                break;
+            case VVECTOR_TRACE_SHRINK:
+                error = vvectorShrinkToFit(vec);
+                break;
+            case VVECTOR_TRACE_GET_AT: {
+                uint8_t * element = vvectorGetAt(vec, r->index);
+                if (element) checksum ^= *element;
+                else error = 1;
+                break;
+            }
+            case VVECTOR_TRACE_WRITE_AT:
+                error = vvectorWriteValueAt(vec, r->index, value);
+                break;
+            case VVECTOR_TRACE_INSERT_AT:
+                error = vvectorInsertValueAt(vec, r->index, value);
+                break;
+            case VVECTOR_TRACE_REMOVE_AT:
+                error = vvectorRemoveAt(vec, r->index);
+                break;
+            case VVECTOR_TRACE_APPEND:
+                error = vvectorAppend(vec, batch_values, r->index, VVECTOR_COPY_AUTO);
+                break;
+            case VVECTOR_TRACE_GATHER:
+                error = vvectorGather(vec, batch_indices, (batch_indices) ? r->index : 0, batch_output);
+                if (!batch_indices && r->index > 0) error = 1;
+                break;
+            case VVECTOR_TRACE_SCATTER:
+                error = vvectorScatter(vec, batch_indices, batch_values, (batch_indices) ? r->index : 0);
+                if (!batch_indices && r->index > 0) error = 1;
+                break;
+            case VVECTOR_TRACE_SCATTER_SORTED:
+                error = vvectorScatterSorted(vec, batch_indices, batch_values, (batch_indices) ? r->index : 0);
+                if (!batch_indices && r->index > 0) error = 1;
+                break;
+            case VVECTOR_TRACE_RESIZE:
+                error = vvectorResize(vec, r->index, value);
+                break;
+            case VVECTOR_TRACE_RESIZE_UNINIT:
+                error = vvectorResizeUninit(vec, r->index);
+                break;
+            case VVECTOR_TRACE_RESIZE_ZEROED:
+                error = vvectorResizeZeroed(vec, r->index);
+                break;
+            case VVECTOR_TRACE_CLEAR:
+                error = vvectorClear(vec);
+                break;
+            case VVECTOR_TRACE_SWAP:
+                error = vvectorSwap(vec, other);
+                break;
+            case VVECTOR_TRACE_MOVE:
+                error = vvectorMove(vec, other);
+                break;
+            case VVECTOR_TRACE_SPLICE:
+                error = vvectorSplice(vec, r->index, other, r->other_index, r->other_index + r->count);
+                break;
+        }
+
+        op_time[r->op] += now_ns() - op_start;
+        op_count[r->op]++;
+
+        if (error) nr_failed++;
+    }
+
+    uint64_t elapsed = now_ns() - start;
+
+    printf("Replayed %td records in %.3f ms", nr_records, elapsed / 1e6);
+    if (nr_records > 0) {
+        printf(" (recorded over %.3f ms)", (records[nr_records - 1].timestamp - records[0].timestamp) / 1e6);
+    }
+    printf("\n%-10s %12s %14s %10s\n", "op", "count", "total_ms", "ns/op");
+
+    for (int op = 1; op < VVECTOR_TRACE_NR_OPS; op++) {
+        if (!op_count[op]) continue;
+
+        printf("%-10s %12lu %14.3f %10.1f\n", op_names[op], (unsigned long) op_count[op],
+               op_time[op] / 1e6, (double) op_time[op] / (double) op_count[op]);
+    }
+
+    if (nr_failed) printf("%td operations failed during replay.\n", nr_failed);
+    if (nr_unknown) printf("%td records referred to unknown vvectors or operations.\n", nr_unknown);
+
+    // Keeps the reads from being optimized away.
+    replay_sink = checksum;
+
+    for (ptrdiff_t i = 0; i < map.capacity; i++) {
+        if (map.values[i]) vvectorFree(map.values[i]);
+    }
+    free(map.keys);
+    free(map.values);
+    free(records);
+    free(value);
+    free(values.data);
+    free(output.data);
+    free(indices.data);
+
+    return 0;
+}
@@ -0,0 +1,119 @@
+// Runs the joins with allocators which fail after a growing number of calls, until one run succeeds.
+// Every failing run must return an error and leave nothing behind; 'make test SANITIZE=1' also catches overflows.
+#include "vvector.h"
+#include "vvector_join.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* An allocator which fails once its budget of calls is used up. */
+
+struct failing_ctx {
+    ptrdiff_t calls_left;
+    ptrdiff_t live;     /**< Allocations not freed yet. */
+};
+
+static void * failing_malloc(ptrdiff_t size, void * ctx){
+    struct failing_ctx * f = ctx;
+    if (f->calls_left-- <= 0) return 0;
+
+    void * ptr = malloc(size);
+    if (ptr) f->live++;
+
+    return ptr;
+}
+
+static void failing_free(void * ptr, ptrdiff_t size, void * ctx){
+    (void) size;
+    struct failing_ctx * f = ctx;
+    if (ptr) f->live--;
+
+    free(ptr);
+}
+
+static void * failing_realloc(void * ptr, ptrdiff_t new_size, ptrdiff_t old_size, void * ctx){
+    (void) old_size;
+    struct failing_ctx * f = ctx;
+    if (f->calls_left-- <= 0) return 0;
+
+    return realloc(ptr, new_size);
+}
+
+typedef int (*join_fn)(vvector, const struct vvectorJoinKey *, vvector, const struct vvectorJoinKey *,
+                       int, vvector, vvector, struct vvectorAlloc *);
+
+/**
+ * @brief Run 'join' with growing budgets. Both inputs are sorted, with runs of equal keys so the output outgrows its first chunks.
+ *
+ * Budgets step by 1 at first, then by a sixteenth, which still hits failures in every phase of a large join.
+ *
+ * @return  0 if every run either failed cleanly or matched the expected pairs.
+ */
+static int check_join(const char * name, join_fn join, int nr_threads, int64_t nr_rows){
+    struct vvectorJoinKey key = {0, sizeof(int64_t), 1, 0, 0};
+    vvector left = vvectorNew(int64_t, 0);
+    vvector right = vvectorNew(int64_t, 0);
+    if (!left || !right) return 1;
+
+    for (int64_t i = 0; i < nr_rows; i++) {
+        int64_t l = i / 4;
+        int64_t r = i / 8;
+        if (vvectorPushBack(left, &l) || vvectorPushBack(right, &r)) return 1;
+    }
+
+    // Every right key appears 8 times on the right and 4 times on the left.
+    ptrdiff_t expected = (ptrdiff_t) (nr_rows / 8) * 4 * 8;
+    int failures = 0;
+    int runs = 0;
+
+    for (ptrdiff_t budget = 0; ; budget += 1 + budget / 16) {
+        runs++;
+
+        struct failing_ctx ctx = {budget, 0};
+        struct vvectorAlloc alloc = {failing_malloc, failing_free, failing_realloc, &ctx};
+
+        // The outputs use the failing allocator too, so appending to them can fail as well.
+        vvector left_indices = vvectorNew(ptrdiff_t, &alloc);
+        vvector right_indices = vvectorNew(ptrdiff_t, &alloc);
+
+        int err = (left_indices && right_indices) ? join(left, &key, right, &key, nr_threads, left_indices, right_indices, &alloc) : 1;
+        ptrdiff_t found = err ? 0 : vvectorGetLength(left_indices);
+
+        if (left_indices) vvectorFree(left_indices);
+        if (right_indices) vvectorFree(right_indices);
+
+        if (ctx.live != 0) {
+            printf("%s: %td allocations leaked with a budget of %td\n", name, ctx.live, budget);
+            failures++;
+        }
+
+        if (!err) {
+            if (found != expected) {
+                printf("%s: %td pairs instead of %td\n", name, found, expected);
+                failures++;
+            }
+            break;
+        }
+    }
+
+    printf("%s, %d thread(s): %d runs, %d failures\n", name, nr_threads, runs, failures);
+
+    vvectorFree(left);
+    vvectorFree(right);
+
+    return failures;
+}
+
+int main(){
+    int failures = 0;
+
+    // Joins use one thread per 65536 rows, so the larger inputs run the threaded paths.
+    failures += check_join("vvectorHashJoin", vvectorHashJoin, 1, 20000);
+    failures += check_join("vvectorHashJoin", vvectorHashJoin, 4, 1 << 17);
+    failures += check_join("vvectorMergeJoin", vvectorMergeJoin, 1, 20000);
+    failures += check_join("vvectorMergeJoin", vvectorMergeJoin, 4, 1 << 17);
+
+    return failures ? 1 : 0;
+}
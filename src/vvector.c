@@ -13,20 +13,39 @@
    See the License for the specific language governing permissions and
    limitations under the License.
 */
+#ifdef LIBVVECTOR_ENABLE_TRACE
+    // clock_gettime(), open(), write()
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
 #include "vvector.h"
+#include "vvector_dispatch.h"
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef LIBVVECTOR_ENABLE_TRACE
+    #include <fcntl.h>
+    #include <time.h>
+    #include <unistd.h>
+#endif
+
 /// @file vvector.c
 
 #define NR_ELEM_IN_PAGE 32
 
+#define DEFAULT_PREFETCH_DISTANCE 16
+
+#define FILL_CHUNK_SIZE 4096 /**< Bytes of pattern built up before it is copied in bulk. @see pattern_fill */
+
+#define VALUE_COPY_ON_STACK 256 /**< Elements up to this size which alias the vvector are copied on the stack. @see copy_aliased_value */
+
 #define VEC_ENOMEM 0        /**< Returned by functions which return pointers. */
 #define VEC_ENOVEC 1        /**< Indicates that the provided vector argument is NULL. */
 #define VEC_EBADINDEX 2     /**< Indicates that the provided index argument is not valid. */
 #define VEC_ENOVALUE 3      /**< Indicates that the provided data pointer argument is NULL. */
+#define VEC_EMISMATCH 4     /**< Indicates that two vector arguments store elements of different sizes. */
 
 #define VEC_ESEVERE 99      /**< Indicates an error which should typically never occur. If returned, terminate the program immediately. */
 
@@ -87,6 +106,16 @@ void * vvector_lib_realloc(void * ptr, ptrdiff_t new_size, ptrdiff_t old_size, v
     return realloc(ptr, new_size);
 }
 
+/**
+ * @internal
+ * @brief Default library implementation of calloc. Only used when the vvector's allocators are all library defaults.
+ *
+ * @param size Number of bytes to allocate. They are all set to zero.
+ */
+static void * vvector_lib_calloc(ptrdiff_t size){
+    return calloc(1, size);
+}
+
 /* Helper functions */
 
 /**
@@ -255,6 +284,27 @@ static const struct vvectorAlloc * get_alloc(vvector vec){
     }
 }
 
+/**
+ * @internal
+ * @brief Check whether two vvectors were created with the same allocator: both with the defaults,
+ *        or both with custom allocators with the same functions and context.
+ *
+ * @param   a   First vvector.
+ * @param   b   Second vvector.
+ * @return  Returns 1 if the allocators are the same, 0 otherwise.
+ */
+static int same_alloc(vvector a, vvector b){
+    const struct vvectorAlloc * alloc_a = get_alloc(a);
+    const struct vvectorAlloc * alloc_b = get_alloc(b);
+
+    if (!alloc_a || !alloc_b) {
+        return alloc_a == alloc_b;
+    }
+
+    return alloc_a->malloc_fn == alloc_b->malloc_fn && alloc_a->free_fn == alloc_b->free_fn &&
+           alloc_a->realloc_fn == alloc_b->realloc_fn && alloc_a->ctx == alloc_b->ctx;
+}
+
 /**
  * @internal
  * @brief Logic control function which returns 1 if the vvector's capacity is too small to hold another element.
@@ -305,6 +355,19 @@ static int index_is_invalid(vvector vec, ptrdiff_t index){
     return 0;
 }
 
+/**
+ * @internal
+ * @brief Returns the number of elements which can still be added to the vvector without reallocating.
+ *
+ * @param   vec     The target vvector.
+ * @return  The number of unused element slots.
+ */
+static ptrdiff_t nr_free_slots(vvector vec){
+    ptrdiff_t element_mem = vec_get_capacity(vec) - getLengthOfMetadata(vec);
+
+    return (element_mem / vec_get_element_size(vec)) - vvectorGetLength(vec);
+}
+
 /**
  * @internal
  * @brief Helper function which a pointer to data stored just past the vvector's metadata, aka the space reserved for elements. 
@@ -387,6 +450,244 @@ static vvector_realloc_fn get_realloc(vvector vec){
     return alloc->realloc_fn;
 }
 
+/**
+ * @internal
+ * @brief Add room for 'n' more elements. Shared by vvectorReserve and the functions which grow a vvector,
+ *        so that only explicit reservations are traced.
+ *
+ * @param   vec     The target vvector.
+ * @param   n       Number of elements, not negative.
+ * @return  0 on success, non-zero on failure.
+ */
+static int reserve(vvector vec, ptrdiff_t n){
+    // Get metadata now to update it later.
+    struct vvectorMetadata_ meta = get_meta(vec);
+
+    ptrdiff_t vec_capacity = vec_get_capacity(vec);
+    ptrdiff_t vec_element_size = vec_get_element_size(vec);
+
+    // Get the ctx pointer or lack thereof
+    void * ctx = 0;
+    if (has_custom_alloc(vec)){
+        const struct vvectorAlloc * alloc = get_alloc(vec);
+        ctx = alloc->ctx;
+    } else {
+        ctx = 0;
+    }
+
+    // Add the required amount of memory, in addition to the memory already used.
+    ptrdiff_t new_capacity = length_to_pages(n, NR_ELEM_IN_PAGE) * vec_element_size * NR_ELEM_IN_PAGE + vec_capacity;
+
+    // On failure the old buffer is still valid, keep it.
+    uint8_t * data = get_realloc(vec)(*vec, new_capacity, vec_capacity, ctx);
+    if (!data) return VEC_ENOVEC;
+    *vec = data;
+
+    // Update metadata
+    meta.capacity = new_capacity;
+    memcpy(*vec, &meta, sizeof(struct vvectorMetadata_));
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Make sure at least 'count' more elements fit in the vvector without reallocating.
+ *
+ * @param   vec     The target vvector.
+ * @param   count   The number of elements which have to fit.
+ * @return  0 on success, non-zero on failure.
+ */
+static int reserve_free_slots(vvector vec, ptrdiff_t count){
+    ptrdiff_t free_slots = nr_free_slots(vec);
+
+    if (free_slots >= count) return 0;
+
+    return reserve(vec, count - free_slots);
+}
+
+// << TRACE >>
+
+#ifdef LIBVVECTOR_ENABLE_TRACE
+
+#define TRACE_BUFFER_RECORDS 4096
+
+/**
+ * @internal
+ * @struct trace_buffer_
+ * @brief A thread's private buffer of trace records.
+ *
+ * Buffers are linked into a global list when a thread records its first operation, and are only freed by vvectorTraceStop().
+ */
+struct trace_buffer_ {
+    struct trace_buffer_ * next;
+    ptrdiff_t count;
+    uint16_t thread;
+    struct vvectorTraceRecord records[TRACE_BUFFER_RECORDS];
+};
+
+static int trace_active = 0;                        /**< Non-zero while recording. Accessed atomically. */
+static int trace_fd = -1;
+static uint64_t trace_epoch = 0;                    /**< Timestamp of vvectorTraceStart(). */
+static uint32_t trace_generation = 0;               /**< Bumped by every vvectorTraceStop(), invalidates thread buffers. */
+static uint32_t trace_nr_threads = 0;               /**< Accessed atomically. */
+static struct trace_buffer_ * trace_buffers = 0;    /**< List of every thread's buffer. Accessed atomically. */
+
+static __thread struct trace_buffer_ * trace_local = 0;
+static __thread uint32_t trace_local_generation = 0;
+
+/**
+ * @internal
+ * @brief Monotonic time in nanoseconds.
+ */
+static uint64_t trace_now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * @internal
+ * @brief Write out and empty a trace buffer.
+ *
+ * The trace file is opened with O_APPEND, so concurrent flushes from different threads never overlap.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+static int trace_flush(struct trace_buffer_ * buffer){
+    const uint8_t * data = (const uint8_t *) buffer->records;
+    ptrdiff_t remaining = buffer->count * sizeof(struct vvectorTraceRecord);
+
+    buffer->count = 0;
+
+    while (remaining > 0) {
+        ssize_t written = write(trace_fd, data, remaining);
+        if (written <= 0) return 1;
+
+        data += written;
+        remaining -= written;
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Returns the calling thread's buffer, creating and registering it if needed.
+ *
+ * @return The buffer, or NULL if out of memory.
+ */
+static struct trace_buffer_ * trace_get_local(void){
+    uint32_t generation = __atomic_load_n(&trace_generation, __ATOMIC_ACQUIRE);
+
+    if (trace_local && trace_local_generation == generation) return trace_local;
+
+    struct trace_buffer_ * buffer = vvector_lib_malloc(sizeof(struct trace_buffer_), 0);
+    if (!buffer) return 0;
+
+    buffer->count = 0;
+    buffer->thread = (uint16_t) __atomic_fetch_add(&trace_nr_threads, 1, __ATOMIC_RELAXED);
+
+    // Lock-free push onto the global list.
+    buffer->next = __atomic_load_n(&trace_buffers, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&trace_buffers, &buffer->next, buffer, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        // 'buffer->next' now holds the current head, try again.
+    }
+
+    trace_local = buffer;
+    trace_local_generation = generation;
+
+    return buffer;
+}
+
+/**
+ * @internal
+ * @brief Record one operation on 'vec'. Does nothing unless a trace is running.
+ *
+ * @warning 'vec' must be a valid vvector.
+ */
+static void trace_record(enum vvectorTraceOp op, vvector vec, ptrdiff_t index, vvector other, ptrdiff_t other_index, ptrdiff_t count){
+    if (!__atomic_load_n(&trace_active, __ATOMIC_ACQUIRE)) return;
+
+    struct trace_buffer_ * buffer = trace_get_local();
+    if (!buffer) return;
+
+    struct vvectorTraceRecord * record = &buffer->records[buffer->count];
+
+    record->timestamp = trace_now() - trace_epoch;
+    record->vec_id = (uint64_t) (uintptr_t) vec;
+    record->other_id = (uint64_t) (uintptr_t) other;
+    record->index = index;
+    record->other_index = other_index;
+    record->count = count;
+    record->element_size = (int32_t) vec_get_element_size(vec);
+    record->thread = buffer->thread;
+    record->op = (uint8_t) op;
+    record->reserved = 0;
+
+    buffer->count++;
+    if (buffer->count == TRACE_BUFFER_RECORDS) trace_flush(buffer);
+}
+
+int vvectorTraceStart(const char * path){
+    if (!path) return VEC_ENOVALUE;
+
+    if (__atomic_load_n(&trace_active, __ATOMIC_ACQUIRE)) return 1;
+
+    trace_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (trace_fd < 0) return 1;
+
+    struct vvectorTraceHeader header = {VVECTOR_TRACE_MAGIC, VVECTOR_TRACE_VERSION, sizeof(struct vvectorTraceRecord), 0};
+    if (write(trace_fd, &header, sizeof(header)) != (ssize_t) sizeof(header)) {
+        close(trace_fd);
+        trace_fd = -1;
+        return 1;
+    }
+
+    trace_epoch = trace_now();
+    __atomic_store_n(&trace_active, 1, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+int vvectorTraceStop(void){
+    if (!__atomic_load_n(&trace_active, __ATOMIC_ACQUIRE)) return 1;
+
+    __atomic_store_n(&trace_active, 0, __ATOMIC_RELEASE);
+
+    int error = 0;
+
+    struct trace_buffer_ * buffer = __atomic_exchange_n(&trace_buffers, 0, __ATOMIC_ACQ_REL);
+    while (buffer) {
+        struct trace_buffer_ * next = buffer->next;
+
+        if (trace_flush(buffer)) error = 1;
+        vvector_lib_free(buffer, sizeof(struct trace_buffer_), 0);
+
+        buffer = next;
+    }
+
+    // Every thread's 'trace_local' now points at freed memory.
+    __atomic_fetch_add(&trace_generation, 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&trace_nr_threads, 0, __ATOMIC_RELAXED);
+
+    if (close(trace_fd)) error = 1;
+    trace_fd = -1;
+
+    return error;
+}
+
+#define TRACE(op, vec, index) trace_record((op), (vec), (index), 0, 0, 0)
+#define TRACE_PAIR(op, vec, index, other, other_index, count) trace_record((op), (vec), (index), (other), (other_index), (count))
+
+#else
+
+#define TRACE(op, vec, index) ((void) 0)
+#define TRACE_PAIR(op, vec, index, other, other_index, count) ((void) 0)
+
+#endif // LIBVVECTOR_ENABLE_TRACE
+
 // << LOGIC CONTROL >> 
 
 ptrdiff_t vvectorGetLength(vvector vec){
@@ -397,6 +698,18 @@ ptrdiff_t vvectorGetLength(vvector vec){
     return meta.length;
 }
 
+ptrdiff_t vvectorGetCapacity(vvector vec){
+    if (!vec || !*vec) return 0;
+
+    return vvectorGetLength(vec) + nr_free_slots(vec);
+}
+
+ptrdiff_t vvectorGetElementSize(vvector vec){
+    if (!vec || !*vec) return 0;
+
+    return vec_get_element_size(vec);
+}
+
 int vvectorIsEmpty(vvector vec){
     if (!vec || !*vec) {
         // The hope here is somebody does
@@ -413,6 +726,24 @@ int vvectorIsEmpty(vvector vec){
     return 0;
 }
 
+int vvectorUsesAllocator(vvector vec, const struct vvectorAlloc * allocator){
+    if (!vec || !*vec) return 0;
+
+    const struct vvectorAlloc * alloc = get_alloc(vec);
+
+    if (!alloc || !allocator) {
+        return !alloc && !allocator;
+    }
+
+    // Missing functions were replaced by the library's at creation, see 'vec_new_'.
+    vvector_malloc_fn malloc_fn = (allocator->malloc_fn) ? allocator->malloc_fn : vvector_lib_malloc;
+    vvector_free_fn free_fn = (allocator->free_fn) ? allocator->free_fn : vvector_lib_free;
+    vvector_realloc_fn realloc_fn = (allocator->realloc_fn) ? allocator->realloc_fn : vvector_lib_realloc;
+
+    return alloc->malloc_fn == malloc_fn && alloc->free_fn == free_fn &&
+           alloc->realloc_fn == realloc_fn && alloc->ctx == allocator->ctx;
+}
+
 // << MEMORY FUNCTIONS >> 
 
 /**
@@ -439,8 +770,9 @@ static int add_page_if_needed(vvector vec){
         ctx = 0;
     }
 
-    *vec = get_realloc(vec)(*vec, vec_capacity + NR_ELEM_IN_PAGE * vec_element_size, vec_capacity, ctx);
-    if (!*vec) return 1;
+    uint8_t * data = get_realloc(vec)(*vec, vec_capacity + NR_ELEM_IN_PAGE * vec_element_size, vec_capacity, ctx);
+    if (!data) return 1;
+    *vec = data;
 
     // Updating the metadata.
     struct vvectorMetadata_ meta = get_meta(vec);
@@ -456,6 +788,8 @@ int vvectorShrinkToFit(vvector vec){
         return VEC_ENOVEC;
     }
 
+    TRACE(VVECTOR_TRACE_SHRINK, vec, 0);
+
     // Get metadata to update later.
     struct vvectorMetadata_ meta = get_meta(vec);
 
@@ -478,8 +812,9 @@ int vvectorShrinkToFit(vvector vec){
         ctx = 0;
     }
 
-    *vec = get_realloc(vec)(*vec, new_size, vec_capacity, ctx);
-    if (!*vec) return 1;
+    uint8_t * data = get_realloc(vec)(*vec, new_size, vec_capacity, ctx);
+    if (!data) return 1;
+    *vec = data;
 
     // Update metadata
     meta.capacity = new_size;
@@ -498,97 +833,411 @@ int vvectorReserve(vvector vec, ptrdiff_t n){
         return 1;
     }
 
-    // Get metadata now to update it later.
-    struct vvectorMetadata_ meta = get_meta(vec);
+    TRACE(VVECTOR_TRACE_RESERVE, vec, n);
 
-    ptrdiff_t vec_capacity = vec_get_capacity(vec);
-    ptrdiff_t vec_element_size = vec_get_element_size(vec);
+    return reserve(vec, n);
+}
 
-    // Get the ctx pointer or lack thereof
-    void * ctx = 0;
-    if (has_custom_alloc(vec)){
-        const struct vvectorAlloc * alloc = get_alloc(vec);
-        ctx = alloc->ctx;
-    } else {
-        ctx = 0;
+/**
+ * @internal
+ * @brief Set 'count' elements starting at 'dst' to copies of 'value'.
+ *
+ * Works for any element size: the pattern is doubled with memcpy until it fills FILL_CHUNK_SIZE bytes,
+ * then that chunk, which stays hot in L1, is copied over the rest. Every copy is a large, vectorized memcpy.
+ *
+ * @param   dst             Start of the elements to fill.
+ * @param   value           Pointer to one element. Must not point into the filled range.
+ * @param   element_size    Size of an element in bytes.
+ * @param   count           Number of elements to fill.
+ */
+static void pattern_fill(uint8_t * dst, const void * value, ptrdiff_t element_size, ptrdiff_t count){
+    ptrdiff_t total = count * element_size;
+
+    if (total == 0) {
+        return;
     }
 
-    // Add the required amount of memory, in addition to the memory already used.
-    ptrdiff_t new_capacity = length_to_pages(n, NR_ELEM_IN_PAGE) * vec_element_size * NR_ELEM_IN_PAGE + vec_capacity;
+    if (element_size == 1) {
+        memset(dst, *(const uint8_t *) value, total);
+        return;
+    }
 
-    *vec = get_realloc(vec)(*vec, new_capacity, vec_capacity, ctx);
-    if (!*vec) return VEC_ENOVEC;
+    memcpy(dst, value, element_size);
 
-    // Update metadata
-    meta.capacity = new_capacity;
-    memcpy(*vec, &meta, sizeof(struct vvectorMetadata_));
+    // Grow the pattern while it is small, keeping whole elements.
+    ptrdiff_t filled = element_size;
+    while (filled < total && filled < FILL_CHUNK_SIZE) {
+        ptrdiff_t n = (filled <= total - filled) ? filled : total - filled;
+        memcpy(&(dst[filled]), dst, n);
+        filled += n;
+    }
 
-    return 0;
+    // 'filled' is a multiple of element_size, so copying it repeatedly keeps the pattern aligned.
+    ptrdiff_t chunk = filled;
+    while (filled < total) {
+        ptrdiff_t n = (chunk <= total - filled) ? chunk : total - filled;
+        memcpy(&(dst[filled]), dst, n);
+        filled += n;
+    }
 }
 
-// << CREATE AND DESTROY >> 
+/**
+ * @internal
+ * @struct value_copy_
+ * @brief Where 'copy_aliased_value' put an element.
+ */
+struct value_copy_ {
+    const void * value;                     /**< The element to use: the caller's, or the copy. */
+    uint8_t stack[VALUE_COPY_ON_STACK];
+    void * heap;                            /**< Copy of a large element, from the vvector's allocator. */
+    ptrdiff_t heap_size;
+};
 
-vvector vec_new_(ptrdiff_t sizeof_type, struct vvectorAlloc * allocator){
-    // Shouldn't really happen, but if it does handle it.
-    if (sizeof_type < 0) return 0;
+/**
+ * @internal
+ * @brief Copy 'value' aside if it points into the buffer of 'vec', e.g. vvectorGetBack(vec),
+ *        since growing the vvector may free the buffer and shifting elements may overwrite it.
+ *
+ * @param   vec     The target vvector.
+ * @param   value   Pointer to one element.
+ * @param   copy    Receives the element to use. Release it with 'release_value_copy'.
+ * @return  0 on success, non-zero if out of memory.
+ */
+static int copy_aliased_value(vvector vec, const void * value, struct value_copy_ * copy){
+    uintptr_t start = (uintptr_t) *vec;
+    uintptr_t address = (uintptr_t) value;
+    ptrdiff_t vec_element_size = vec_get_element_size(vec);
 
-    struct vvectorMetadata_ meta;
-    meta.element_size = sizeof_type;
-    meta.length = 0;
+    copy->value = value;
+    copy->heap = 0;
+    copy->heap_size = 0;
 
-    if (!allocator) {
-        meta.capacity = sizeof(struct vvectorMetadata_);
+    if (address < start || address >= start + (uintptr_t) vec_get_capacity(vec)) {
+        return 0;
+    }
 
-        uint8_t * new_vector_data = vvector_lib_malloc(meta.capacity, 0);
-        if (!new_vector_data) return VEC_ENOMEM;
+    if (vec_element_size <= VALUE_COPY_ON_STACK) {
+        memcpy(copy->stack, value, vec_element_size);
+        copy->value = copy->stack;
+        return 0;
+    }
 
-        memcpy(new_vector_data, &meta, sizeof(struct vvectorMetadata_));
+    const struct vvectorAlloc * alloc = get_alloc(vec);
+    copy->heap = get_malloc(vec)(vec_element_size, (alloc) ? alloc->ctx : 0);
+    if (!copy->heap) return VEC_ENOVEC;
 
-        uint8_t ** vector_handle = vvector_lib_malloc(sizeof(uint8_t *), 0);
-        if (!vector_handle) return VEC_ENOMEM;
+    copy->heap_size = vec_element_size;
+    memcpy(copy->heap, value, vec_element_size);
+    copy->value = copy->heap;
 
-        *vector_handle = new_vector_data;
+    return 0;
+}
 
-        return vector_handle;
-    } else {
-        // !!! Hack: A negative element_size value represents that there are custom allocators present.
-        meta.element_size = -sizeof_type;
+static void release_value_copy(vvector vec, struct value_copy_ * copy){
+    if (!copy->heap) return;
 
-        // If a function pointer is missing, use defaults.
-        struct vvectorAlloc a;
-        a.malloc_fn = (allocator->malloc_fn) ? allocator->malloc_fn : vvector_lib_malloc;
-        a.free_fn = (allocator->free_fn) ? allocator->free_fn : vvector_lib_free;
-        a.realloc_fn = (allocator->realloc_fn) ? allocator->realloc_fn : vvector_lib_realloc;
-        a.ctx = allocator->ctx;
+    const struct vvectorAlloc * alloc = get_alloc(vec);
+    get_free(vec)(copy->heap, copy->heap_size, (alloc) ? alloc->ctx : 0);
+}
 
-        meta.capacity = sizeof(struct vvectorMetadata_) + sizeof(struct vvectorAlloc);
+/**
+ * @internal
+ * @brief Shared implementation of vvectorResize and vvectorResizeUninit.
+ *
+ * @param   vec         The target vvector.
+ * @param   length      The new number of elements.
+ * @param   fill_value  Value for new elements, or NULL to leave them uninitialized.
+ * @return  0 on success, non-zero on failure.
+ */
+static int resize(vvector vec, ptrdiff_t length, void * fill_value){
+    ptrdiff_t vec_length = vvectorGetLength(vec);
 
-        uint8_t * new_vector_data = a.malloc_fn(meta.capacity, a.ctx);
-        if (!new_vector_data) return VEC_ENOMEM;
+    if (length > vec_length) {
+        struct value_copy_ fill;
 
+        // 'fill_value' may point into the buffer which the reservation frees.
+        if (fill_value && copy_aliased_value(vec, fill_value, &fill)) return VEC_ENOVEC;
 
-        // Metadata first, then the allocator. This order is very important.
-        memcpy(new_vector_data, &meta, sizeof(struct vvectorMetadata_));
-        memcpy(&(new_vector_data[sizeof(struct vvectorMetadata_)]), &a, sizeof(struct vvectorAlloc));
+        int err = reserve_free_slots(vec, length - vec_length);
 
-        uint8_t ** vector_handle = a.malloc_fn(sizeof(uint8_t *), a.ctx);
-        if (!vector_handle) return VEC_ENOMEM;
+        if (!err && fill_value) {
+            ptrdiff_t vec_element_size = vec_get_element_size(vec);
+            uint8_t * start_of_data = get_start_of_data(vec);
 
-        *vector_handle = new_vector_data;
+            pattern_fill(&(start_of_data[vec_length * vec_element_size]), fill.value, vec_element_size, length - vec_length);
+        }
 
-        return vector_handle;
+        if (fill_value) release_value_copy(vec, &fill);
+        if (err) return err;
     }
-}
 
-int vvectorFree(vvector vec){
-    if (!vec || !*vec) return VEC_ENOVEC;
+    // Update metadata.
+    struct vvectorMetadata_ meta = get_meta(vec);
 
-    ptrdiff_t vec_capacity = vec_get_capacity(vec);
+    meta.length = length;
+    memcpy(*vec, &meta, sizeof(meta));
 
-    const struct vvectorAlloc * alloc = get_alloc(vec);
+    return 0;
+}
 
-    // Custom allocators might not be present, so check if alloc is NULL.
-    void * ctx = (alloc) ? alloc->ctx : 0;
+/**
+ * @internal
+ * @brief Checks if the vvector's memory comes straight from the C library's heap,
+ * meaning it can be swapped for a calloc()'d block.
+ *
+ * @param   vec     The target vvector.
+ * @return  1 if the vvector uses the library's default realloc and free, 0 otherwise.
+ */
+static int uses_lib_heap(vvector vec){
+    return (get_realloc(vec) == vvector_lib_realloc && get_free(vec) == vvector_lib_free);
+}
+
+/**
+ * @internal
+ * @brief Grow the vvector to 'length' zeroed elements by moving it into a fresh calloc()'d block.
+ *
+ * @warning Only valid if uses_lib_heap(vec) and 'length' is larger than the current length.
+ *
+ * @param   vec         The target vvector.
+ * @param   length      The new number of elements.
+ * @return  0 on success, non-zero on failure.
+ */
+static int grow_into_calloc(vvector vec, ptrdiff_t length){
+    ptrdiff_t vec_length = vvectorGetLength(vec);
+    ptrdiff_t vec_element_size = vec_get_element_size(vec);
+    ptrdiff_t metadata_size = getLengthOfMetadata(vec);
+
+    ptrdiff_t new_capacity = metadata_size + length_to_pages(length, NR_ELEM_IN_PAGE) * NR_ELEM_IN_PAGE * vec_element_size;
+
+    uint8_t * fresh = vvector_lib_calloc(new_capacity);
+    if (!fresh) return VEC_ENOVEC;
+
+    // Metadata, allocator and live elements. Everything past them is already zero.
+    memcpy(fresh, *vec, metadata_size + vec_length * vec_element_size);
+
+    vvector_lib_free(*vec, vec_get_capacity(vec), 0);
+    *vec = fresh;
+
+    // Update metadata.
+    struct vvectorMetadata_ meta = get_meta(vec);
+
+    meta.capacity = new_capacity;
+    meta.length = length;
+    memcpy(*vec, &meta, sizeof(meta));
+
+    return 0;
+}
+
+int vvectorResizeZeroed(vvector vec, ptrdiff_t length){
+    if (!vec || !*vec) {
+        return VEC_ENOVEC;
+    }
+
+    if (length < 0) {
+        return VEC_EBADINDEX;
+    }
+
+    TRACE(VVECTOR_TRACE_RESIZE_ZEROED, vec, length);
+
+    ptrdiff_t vec_length = vvectorGetLength(vec);
+    ptrdiff_t new_elements = length - vec_length;
+
+    // Only worth it if most of the result is new: the live elements get copied, while realloc might not copy at all.
+    if (new_elements > nr_free_slots(vec) && new_elements > vec_length && uses_lib_heap(vec)) {
+        return grow_into_calloc(vec, length);
+    }
+
+    int err = resize(vec, length, 0);
+    if (err) return err;
+
+    if (new_elements > 0) {
+        ptrdiff_t vec_element_size = vec_get_element_size(vec);
+        uint8_t * start_of_data = get_start_of_data(vec);
+
+        memset(&(start_of_data[vec_length * vec_element_size]), 0, new_elements * vec_element_size);
+    }
+
+    return 0;
+}
+
+int vvectorResize(vvector vec, ptrdiff_t length, void * fill_value){
+    if (!vec || !*vec) {
+        return VEC_ENOVEC;
+    }
+
+    if (length < 0) {
+        return VEC_EBADINDEX;
+    }
+
+    if (!fill_value) {
+        return VEC_ENOVALUE;
+    }
+
+    TRACE(VVECTOR_TRACE_RESIZE, vec, length);
+
+    return resize(vec, length, fill_value);
+}
+
+int vvectorResizeUninit(vvector vec, ptrdiff_t length){
+    if (!vec || !*vec) {
+        return VEC_ENOVEC;
+    }
+
+    if (length < 0) {
+        return VEC_EBADINDEX;
+    }
+
+    TRACE(VVECTOR_TRACE_RESIZE_UNINIT, vec, length);
+
+    return resize(vec, length, 0);
+}
+
+// << CREATE AND DESTROY >> 
+
+vvector vec_new_(ptrdiff_t sizeof_type, struct vvectorAlloc * allocator){
+    // Shouldn't really happen, but if it does handle it.
+    if (sizeof_type < 0) return 0;
+
+    struct vvectorMetadata_ meta;
+    meta.element_size = sizeof_type;
+    meta.length = 0;
+
+    if (!allocator) {
+        meta.capacity = sizeof(struct vvectorMetadata_);
+
+        uint8_t * new_vector_data = vvector_lib_malloc(meta.capacity, 0);
+        if (!new_vector_data) return VEC_ENOMEM;
+
+        memcpy(new_vector_data, &meta, sizeof(struct vvectorMetadata_));
+
+        uint8_t ** vector_handle = vvector_lib_malloc(sizeof(uint8_t *), 0);
+        if (!vector_handle) {
+            vvector_lib_free(new_vector_data, meta.capacity, 0);
+            return VEC_ENOMEM;
+        }
+
+        *vector_handle = new_vector_data;
+
+        TRACE(VVECTOR_TRACE_NEW, vector_handle, 0);
+
+        return vector_handle;
+    } else {
+        // !!! Hack: A negative element_size value represents that there are custom allocators present.
+        meta.element_size = -sizeof_type;
+
+        // If a function pointer is missing, use defaults.
+        struct vvectorAlloc a;
+        a.malloc_fn = (allocator->malloc_fn) ? allocator->malloc_fn : vvector_lib_malloc;
+        a.free_fn = (allocator->free_fn) ? allocator->free_fn : vvector_lib_free;
+        a.realloc_fn = (allocator->realloc_fn) ? allocator->realloc_fn : vvector_lib_realloc;
+        a.ctx = allocator->ctx;
+
+        meta.capacity = sizeof(struct vvectorMetadata_) + sizeof(struct vvectorAlloc);
+
+        uint8_t * new_vector_data = a.malloc_fn(meta.capacity, a.ctx);
+        if (!new_vector_data) return VEC_ENOMEM;
+
+
+        // Metadata first, then the allocator. This order is very important.
+        memcpy(new_vector_data, &meta, sizeof(struct vvectorMetadata_));
+        memcpy(&(new_vector_data[sizeof(struct vvectorMetadata_)]), &a, sizeof(struct vvectorAlloc));
+
+        uint8_t ** vector_handle = a.malloc_fn(sizeof(uint8_t *), a.ctx);
+        if (!vector_handle) {
+            a.free_fn(new_vector_data, meta.capacity, a.ctx);
+            return VEC_ENOMEM;
+        }
+
+        *vector_handle = new_vector_data;
+
+        TRACE(VVECTOR_TRACE_NEW, vector_handle, 0);
+
+        return vector_handle;
+    }
+}
+
+vvector vec_new_zeroed_(ptrdiff_t sizeof_type, ptrdiff_t length, struct vvectorAlloc * allocator){
+    if (length < 0) return 0;
+
+    vvector vec = vec_new_(sizeof_type, allocator);
+    if (!vec) return VEC_ENOMEM;
+
+    if (vvectorResizeZeroed(vec, length)) {
+        vvectorFree(vec);
+        return VEC_ENOMEM;
+    }
+
+    return vec;
+}
+
+vvector vvectorAdopt(void * ptr, ptrdiff_t length, ptrdiff_t element_size, struct vvectorAlloc * allocator){
+    if (element_size <= 0 || length < 0) return 0;
+
+    if (!ptr) {
+        if (length) return 0;
+
+        return vec_new_(element_size, allocator);
+    }
+
+    struct vvectorMetadata_ meta;
+    meta.element_size = element_size;
+    meta.length = length;
+
+    // If a function pointer is missing, use defaults.
+    struct vvectorAlloc a = {vvector_lib_malloc, vvector_lib_free, vvector_lib_realloc, 0};
+    ptrdiff_t metadata_size = sizeof(struct vvectorMetadata_);
+
+    if (allocator) {
+        // !!! Hack: A negative element_size value represents that there are custom allocators present.
+        meta.element_size = -element_size;
+
+        a.malloc_fn = (allocator->malloc_fn) ? allocator->malloc_fn : vvector_lib_malloc;
+        a.free_fn = (allocator->free_fn) ? allocator->free_fn : vvector_lib_free;
+        a.realloc_fn = (allocator->realloc_fn) ? allocator->realloc_fn : vvector_lib_realloc;
+        a.ctx = allocator->ctx;
+
+        metadata_size += sizeof(struct vvectorAlloc);
+    }
+
+    // Capacity always holds whole pages, the paging logic relies on it.
+    meta.capacity = metadata_size + length_to_pages(length, NR_ELEM_IN_PAGE) * NR_ELEM_IN_PAGE * element_size;
+
+    // Allocate the handle first: once 'ptr' is reallocated, failing would lose the caller's data.
+    uint8_t ** vector_handle = a.malloc_fn(sizeof(uint8_t *), a.ctx);
+    if (!vector_handle) return VEC_ENOMEM;
+
+    uint8_t * data = a.realloc_fn(ptr, meta.capacity, length * element_size, a.ctx);
+    if (!data) {
+        a.free_fn(vector_handle, sizeof(uint8_t *), a.ctx);
+        return VEC_ENOMEM;
+    }
+
+    memmove(&(data[metadata_size]), data, length * element_size);
+
+    // Metadata first, then the allocator. This order is very important.
+    memcpy(data, &meta, sizeof(struct vvectorMetadata_));
+    if (allocator) {
+        memcpy(&(data[sizeof(struct vvectorMetadata_)]), &a, sizeof(struct vvectorAlloc));
+    }
+
+    *vector_handle = data;
+
+    TRACE(VVECTOR_TRACE_ADOPT, vector_handle, length);
+
+    return vector_handle;
+}
+
+int vvectorFree(vvector vec){
+    if (!vec || !*vec) return VEC_ENOVEC;
+
+    TRACE(VVECTOR_TRACE_FREE, vec, 0);
+
+    ptrdiff_t vec_capacity = vec_get_capacity(vec);
+
+    const struct vvectorAlloc * alloc = get_alloc(vec);
+
+    // Custom allocators might not be present, so check if alloc is NULL.
+    void * ctx = (alloc) ? alloc->ctx : 0;
 
     // Store the free_fn function pointer and THEN use it. Avoids use-after-free.
     vvector_free_fn free_fn = get_free(vec);
@@ -601,6 +1250,43 @@ int vvectorFree(vvector vec){
     return 0;
 }
 
+void * vvectorRelease(vvector vec, ptrdiff_t * length){
+    if (!vec || !*vec) return 0;
+
+    TRACE(VVECTOR_TRACE_FREE, vec, 0);
+
+    ptrdiff_t vec_capacity = vec_get_capacity(vec);
+    ptrdiff_t vec_length = vvectorGetLength(vec);
+    ptrdiff_t vec_element_size = vec_get_element_size(vec);
+    ptrdiff_t metadata_size = getLengthOfMetadata(vec);
+
+    const struct vvectorAlloc * alloc = get_alloc(vec);
+    void * ctx = (alloc) ? alloc->ctx : 0;
+
+    // Store the function pointers and THEN use them. The allocator lives in the memory being moved.
+    vvector_free_fn free_fn = get_free(vec);
+    vvector_realloc_fn realloc_fn = get_realloc(vec);
+
+    uint8_t * data = *vec;
+    *vec = 0;
+    free_fn(vec, sizeof(void *), ctx);
+
+    if (length) *length = vec_length;
+
+    if (vec_length == 0) {
+        free_fn(data, vec_capacity, ctx);
+        return 0;
+    }
+
+    ptrdiff_t data_size = vec_length * vec_element_size;
+    memmove(data, &(data[metadata_size]), data_size);
+
+    uint8_t * shrunk = realloc_fn(data, data_size, vec_capacity, ctx);
+
+    // Shrinking failed, but the elements are in place.
+    return (shrunk) ? shrunk : data;
+}
+
 /* Get functions */
 
 void * vvectorGetAt(vvector vec, ptrdiff_t index){
@@ -616,6 +1302,8 @@ void * vvectorGetAt(vvector vec, ptrdiff_t index){
         return 0;
     }
 
+    TRACE(VVECTOR_TRACE_GET_AT, vec, index);
+
     uint8_t * start_of_data = get_start_of_data(vec);
 
     return &(start_of_data[vec_element_size * index]);
@@ -651,6 +1339,120 @@ void * vvectorGetFront(vvector vec){
     return vvectorGetAt(vec, 0);
 }
 
+ptrdiff_t vvectorFind(vvector vec, void * value){
+    if (!vec || !*vec) {
+        return -1;
+    }
+
+    if (!value) {
+        return -1;
+    }
+
+    ptrdiff_t vec_length = vvectorGetLength(vec);
+    ptrdiff_t vec_element_size = vec_get_element_size(vec);
+    uint8_t * start_of_data = get_start_of_data(vec);
+
+    // Elements are only aligned to 8 bytes, so the kernels use unaligned loads.
+    if (vec_element_size == sizeof(uint32_t)) {
+        uint32_t needle;
+        memcpy(&needle, value, sizeof(needle));
+
+        return vvector_kernels_.find_u32((const uint32_t *) start_of_data, vec_length, needle);
+    }
+
+    if (vec_element_size == sizeof(uint64_t)) {
+        uint64_t needle;
+        memcpy(&needle, value, sizeof(needle));
+
+        return vvector_kernels_.find_u64((const uint64_t *) start_of_data, vec_length, needle);
+    }
+
+    for (ptrdiff_t i = 0; i < vec_length; i++) {
+        if (memcmp(&(start_of_data[i * vec_element_size]), value, vec_element_size) == 0) return i;
+    }
+
+    return -1;
+}
+
+static ptrdiff_t prefetch_distance = DEFAULT_PREFETCH_DISTANCE;
+
+/**
+ * @internal
+ * @brief Check a whole batch of indices at once.
+ *
+ * @warning This function does not check its arguments for validity!
+ *
+ * @param   vec     The target vvector.
+ * @param   indices Array of 'n' indices.
+ * @param   n       Number of indices.
+ * @return  1 if any index is outside of [0, vvectorGetLength(vec)), 0 otherwise.
+ */
+static int batch_has_invalid_index(vvector vec, const ptrdiff_t * indices, ptrdiff_t n){
+    ptrdiff_t vec_length = vvectorGetLength(vec);
+    int invalid = 0;
+
+    // No early exit, so the loop has no branches and vectorizes.
+    for (ptrdiff_t i = 0; i < n; i++) {
+        invalid |= ((uint64_t) indices[i] >= (uint64_t) vec_length);
+    }
+
+    return invalid;
+}
+
+int vvectorGather(vvector vec, const ptrdiff_t * indices, ptrdiff_t n, void * out){
+    if (!vec || !*vec) {
+        return VEC_ENOVEC;
+    }
+
+    if (n < 0 || (n > 0 && !indices)) {
+        return VEC_EBADINDEX;
+    }
+
+    if (n > 0 && !out) {
+        return VEC_ENOVALUE;
+    }
+
+    if (batch_has_invalid_index(vec, indices, n)) {
+        return VEC_EBADINDEX;
+    }
+
+    TRACE(VVECTOR_TRACE_GATHER, vec, n);
+
+    ptrdiff_t vec_element_size = vec_get_element_size(vec);
+    uint8_t * start_of_data = get_start_of_data(vec);
+    uint8_t * dst = out;
+    ptrdiff_t distance = prefetch_distance;
+
+    switch (vec_element_size) {
+        case 4:
+            vvector_kernels_.gather_u32((const uint32_t *) start_of_data, indices, n, out, distance);
+            return 0;
+        case 8:
+            vvector_kernels_.gather_u64((const uint64_t *) start_of_data, indices, n, out, distance);
+            return 0;
+        case 16:
+            for (ptrdiff_t i = 0; i < n; i++) {
+                if (i + distance < n) __builtin_prefetch(&(start_of_data[indices[i + distance] * 16]));
+                memcpy(&(dst[i * 16]), &(start_of_data[indices[i] * 16]), 16);
+            }
+            return 0;
+        default:
+            for (ptrdiff_t i = 0; i < n; i++) {
+                if (i + distance < n) __builtin_prefetch(&(start_of_data[indices[i + distance] * vec_element_size]));
+                memcpy(&(dst[i * vec_element_size]), &(start_of_data[indices[i] * vec_element_size]), vec_element_size);
+            }
+            return 0;
+    }
+}
+
+void vvectorSetPrefetchDistance(ptrdiff_t distance){
+    prefetch_distance = (distance < 0) ? 0 : distance;
+}
+
+ptrdiff_t vvectorGetPrefetchDistance(void){
+    return prefetch_distance;
+}
+
 /* Add & Write functions */
 // Overwrite, no realloc.
 
@@ -669,6 +1471,8 @@ int vvectorWriteValueAt(vvector vec, ptrdiff_t index, void * value){
         return VEC_ENOVALUE;
     }
 
+    TRACE(VVECTOR_TRACE_WRITE_AT, vec, index);
+
     uint8_t * start_of_data = get_start_of_data(vec);
 
     memcpy(&(start_of_data[index * vec_element_size]), value, vec_element_size);
@@ -676,6 +1480,161 @@ int vvectorWriteValueAt(vvector vec, ptrdiff_t index, void * value){
     return 0;
 }
 
+/**
+ * @internal
+ * @brief An index paired with the position of its value in the caller's 'values' array.
+ */
+struct scatter_item_ {
+    ptrdiff_t index;
+    ptrdiff_t position;
+};
+
+/**
+ * @internal
+ * @brief Stable LSD radix sort of 'items' by index, 11 bits per pass.
+ *
+ * @param   items       The items to sort.
+ * @param   scratch     Space for 'n' more items.
+ * @param   n           Number of items.
+ * @param   max_index   Largest possible index, limits the number of passes.
+ * @return  Either 'items' or 'scratch', whichever holds the sorted result.
+ */
+static struct scatter_item_ * sort_scatter_items(struct scatter_item_ * items, struct scatter_item_ * scratch, ptrdiff_t n, ptrdiff_t max_index){
+    ptrdiff_t counts[1 << 11];
+
+    for (int shift = 0; shift < 64 && (max_index >> shift) > 0; shift += 11) {
+        memset(counts, 0, sizeof(counts));
+
+        for (ptrdiff_t i = 0; i < n; i++) {
+            counts[(items[i].index >> shift) & 0x7FF]++;
+        }
+
+        ptrdiff_t sum = 0;
+        for (ptrdiff_t d = 0; d < (1 << 11); d++) {
+            ptrdiff_t count = counts[d];
+            counts[d] = sum;
+            sum += count;
+        }
+
+        for (ptrdiff_t i = 0; i < n; i++) {
+            scratch[counts[(items[i].index >> shift) & 0x7FF]++] = items[i];
+        }
+
+        struct scatter_item_ * tmp = items;
+        items = scratch;
+        scratch = tmp;
+    }
+
+    return items;
+}
+
+/**
+ * @internal
+ * @brief Does the writes for the scatter functions, with fixed size copies for common element sizes.
+ *
+ * @warning This function does not check its arguments for validity!
+ *
+ * @param   vec     The target vvector.
+ * @param   indices Array of 'n' indices. Ignored if 'items' is not NULL.
+ * @param   items   Optional: 'n' index/position pairs, to write in a different order than 'values'.
+ * @param   values  Array of 'n' elements.
+ * @param   n       Number of elements to write.
+ */
+static void scatter_rows(vvector vec, const ptrdiff_t * indices, const struct scatter_item_ * items, const uint8_t * values, ptrdiff_t n){
+    ptrdiff_t vec_element_size = vec_get_element_size(vec);
+    uint8_t * start_of_data = get_start_of_data(vec);
+    ptrdiff_t distance = prefetch_distance;
+
+    // The switch lets the compiler turn memcpy into single moves for common sizes.
+    #define SCATTER_LOOP(SIZE) \
+        for (ptrdiff_t i = 0; i < n; i++) { \
+            ptrdiff_t index = (items) ? items[i].index : indices[i]; \
+            ptrdiff_t position = (items) ? items[i].position : i; \
+            if (i + distance < n) { \
+                ptrdiff_t ahead = (items) ? items[i + distance].index : indices[i + distance]; \
+                __builtin_prefetch(&(start_of_data[ahead * (SIZE)]), 1); \
+            } \
+            memcpy(&(start_of_data[index * (SIZE)]), &(values[position * (SIZE)]), (SIZE)); \
+        }
+
+    switch (vec_element_size) {
+        case 4: SCATTER_LOOP(4) break;
+        case 8: SCATTER_LOOP(8) break;
+        case 16: SCATTER_LOOP(16) break;
+        default: SCATTER_LOOP(vec_element_size) break;
+    }
+
+    #undef SCATTER_LOOP
+}
+
+int vvectorScatter(vvector vec, const ptrdiff_t * indices, void * values, ptrdiff_t n){
+    if (!vec || !*vec) {
+        return VEC_ENOVEC;
+    }
+
+    if (n < 0 || (n > 0 && !indices)) {
+        return VEC_EBADINDEX;
+    }
+
+    if (n > 0 && !values) {
+        return VEC_ENOVALUE;
+    }
+
+    if (batch_has_invalid_index(vec, indices, n)) {
+        return VEC_EBADINDEX;
+    }
+
+    TRACE(VVECTOR_TRACE_SCATTER, vec, n);
+
+    scatter_rows(vec, indices, 0, values, n);
+
+    return 0;
+}
+
+int vvectorScatterSorted(vvector vec, const ptrdiff_t * indices, void * values, ptrdiff_t n){
+    if (!vec || !*vec) {
+        return VEC_ENOVEC;
+    }
+
+    if (n < 0 || (n > 0 && !indices)) {
+        return VEC_EBADINDEX;
+    }
+
+    if (n > 0 && !values) {
+        return VEC_ENOVALUE;
+    }
+
+    if (batch_has_invalid_index(vec, indices, n)) {
+        return VEC_EBADINDEX;
+    }
+
+    TRACE(VVECTOR_TRACE_SCATTER_SORTED, vec, n);
+
+    if (n == 0) {
+        return 0;
+    }
+
+    const struct vvectorAlloc * alloc = get_alloc(vec);
+    void * ctx = (alloc) ? alloc->ctx : 0;
+
+    ptrdiff_t scratch_size = 2 * n * sizeof(struct scatter_item_);
+    struct scatter_item_ * items = get_malloc(vec)(scratch_size, ctx);
+    if (!items) return VEC_ENOVEC;
+
+    for (ptrdiff_t i = 0; i < n; i++) {
+        items[i].index = indices[i];
+        items[i].position = i;
+    }
+
+    struct scatter_item_ * sorted = sort_scatter_items(items, &items[n], n, vvectorGetLength(vec) - 1);
+
+    scatter_rows(vec, 0, sorted, values, n);
+
+    get_free(vec)(items, scratch_size, ctx);
+
+    return 0;
+}
+
 /* Insert, calls realloc. */
 
 int vvectorInsertValueAt(vvector vec, ptrdiff_t index, void * value){
@@ -683,12 +1642,10 @@ int vvectorInsertValueAt(vvector vec, ptrdiff_t index, void * value){
         return VEC_ENOVEC;
     }
 
-    add_page_if_needed(vec);
-
     ptrdiff_t vec_length = vvectorGetLength(vec);
     ptrdiff_t vec_element_size = vec_get_element_size(vec);
 
-    if (index > vvectorGetLength(vec)){
+    if (index < 0 || index > vec_length){
         return VEC_EBADINDEX;
     }
 
@@ -696,11 +1653,27 @@ int vvectorInsertValueAt(vvector vec, ptrdiff_t index, void * value){
         return VEC_ENOVALUE;
     }
 
+    TRACE(VVECTOR_TRACE_INSERT_AT, vec, index);
+
+    // 'value' may point into the buffer, which growing frees and shifting overwrites.
+    struct value_copy_ copy;
+    if (copy_aliased_value(vec, value, &copy)) {
+        return VEC_ENOVEC;
+    }
+
+    // Grow only once the call is known to succeed.
+    if (add_page_if_needed(vec)) {
+        release_value_copy(vec, &copy);
+        return VEC_ENOVEC;
+    }
+
     uint8_t * start_of_data = get_start_of_data(vec);
 
     memmove(&(start_of_data[(index + 1) * vec_element_size]), &(start_of_data[index * vec_element_size]), (vec_length - index) * vec_element_size);
-    memmove(&(start_of_data[index * vec_element_size]), value, vec_element_size);
-    
+    memcpy(&(start_of_data[index * vec_element_size]), copy.value, vec_element_size);
+
+    release_value_copy(vec, &copy);
+
     // Update metadata.
     struct vvectorMetadata_ meta = get_meta(vec);
 
@@ -725,6 +1698,99 @@ int vvectorPushBack(vvector vec, void * value){
     return 0;
 }
 
+/* Bulk functions */
+
+/**
+ * @internal
+ * @brief memcpy() which uses non-temporal stores when 'mode' asks for it.
+ *
+ * @param   dst     Destination. Must not overlap 'src'.
+ * @param   src     Source.
+ * @param   n       Number of bytes to copy.
+ * @param   mode    @see vvectorCopyMode
+ */
+static void bulk_copy(void * dst, const void * src, ptrdiff_t n, enum vvectorCopyMode mode){
+    int stream = (mode == VVECTOR_COPY_STREAM);
+
+    if (mode == VVECTOR_COPY_AUTO && vvector_stream_threshold_ >= 0 && n >= vvector_stream_threshold_) {
+        stream = 1;
+    }
+
+    if (stream) {
+        vvector_kernels_.stream_copy(dst, src, n);
+    } else {
+        memcpy(dst, src, n);
+    }
+}
+
+int vvectorAppend(vvector vec, void * values, ptrdiff_t count, enum vvectorCopyMode mode){
+    if (!vec || !*vec) {
+        return VEC_ENOVEC;
+    }
+
+    if (count < 0) {
+        return VEC_EBADINDEX;
+    }
+
+    if (count == 0) {
+        return 0;
+    }
+
+    if (!values) {
+        return VEC_ENOVALUE;
+    }
+
+    TRACE(VVECTOR_TRACE_APPEND, vec, count);
+
+    int err = reserve_free_slots(vec, count);
+    if (err) return err;
+
+    ptrdiff_t vec_length = vvectorGetLength(vec);
+    ptrdiff_t vec_element_size = vec_get_element_size(vec);
+    uint8_t * start_of_data = get_start_of_data(vec);
+
+    bulk_copy(&(start_of_data[vec_length * vec_element_size]), values, count * vec_element_size, mode);
+
+    // Update metadata.
+    struct vvectorMetadata_ meta = get_meta(vec);
+
+    meta.length += count;
+    memcpy(*vec, &meta, sizeof(meta));
+
+    return 0;
+}
+
+vvector vvectorClone(vvector vec, enum vvectorCopyMode mode){
+    if (!vec || !*vec) {
+        return 0;
+    }
+
+    // vec_new_ copies the allocator, but wants a non-const pointer.
+    struct vvectorAlloc alloc;
+    const struct vvectorAlloc * vec_alloc = get_alloc(vec);
+    if (vec_alloc) alloc = *vec_alloc;
+
+    vvector clone = vec_new_(vec_get_element_size(vec), (vec_alloc) ? &alloc : 0);
+    if (!clone) return VEC_ENOMEM;
+
+    if (vvectorIsEmpty(vec)) return clone;
+
+    if (vvectorAppend(clone, get_start_of_data(vec), vvectorGetLength(vec), mode)) {
+        vvectorFree(clone);
+        return VEC_ENOMEM;
+    }
+
+    return clone;
+}
+
+void vvectorSetStreamThreshold(ptrdiff_t bytes){
+    vvector_stream_threshold_ = bytes;
+}
+
+ptrdiff_t vvectorGetStreamThreshold(void){
+    return vvector_stream_threshold_;
+}
+
 /* Remove/Delete functions */
 // Remove, doesn't call realloc.
 
@@ -740,6 +1806,8 @@ int vvectorRemoveAt(vvector vec, ptrdiff_t index){
         return VEC_EBADINDEX;
     }
 
+    TRACE(VVECTOR_TRACE_REMOVE_AT, vec, index);
+
     uint8_t * start_of_data = get_start_of_data(vec);
 
     memmove(&(start_of_data[index * vec_element_size]), &(start_of_data[(index + 1) * vec_element_size]), (vec_length - index - 1) * vec_element_size);
@@ -769,6 +1837,127 @@ int vvectorRemoveBack(vvector vec){
     return 0;
 }
 
+int vvectorClear(vvector vec){
+    if (!vec || !*vec) {
+        return VEC_ENOVEC;
+    }
+
+    TRACE(VVECTOR_TRACE_CLEAR, vec, 0);
+
+    // Update metadata.
+    struct vvectorMetadata_ meta = get_meta(vec);
+
+    meta.length = 0;
+    memcpy(*vec, &meta, sizeof(meta));
+
+    return 0;
+}
+
+/* Exchange functions */
+
+/**
+ * @internal
+ * @brief Exchange the buffers of two vvectors. Metadata and allocators live in the buffers, so this swaps everything.
+ */
+static void swap_buffers(vvector a, vvector b){
+    uint8_t * tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+int vvectorSwap(vvector a, vvector b){
+    if (!a || !*a || !b || !*b) {
+        return VEC_ENOVEC;
+    }
+
+    // Each handle was allocated by its vvector's allocator, which must also free it, so buffers can only trade places
+    // between vvectors of the same allocator.
+    if (!same_alloc(a, b)) {
+        return VEC_EMISMATCH;
+    }
+
+    TRACE_PAIR(VVECTOR_TRACE_SWAP, a, 0, b, 0, 0);
+
+    swap_buffers(a, b);
+
+    return 0;
+}
+
+int vvectorMove(vvector dst, vvector src){
+    if (!dst || !*dst || !src || !*src) {
+        return VEC_ENOVEC;
+    }
+
+    if (dst == src) {
+        return 0;
+    }
+
+    if (!same_alloc(dst, src)) {
+        return VEC_EMISMATCH;
+    }
+
+    TRACE_PAIR(VVECTOR_TRACE_MOVE, dst, 0, src, 0, 0);
+
+    swap_buffers(dst, src);
+
+    // Update metadata.
+    struct vvectorMetadata_ meta = get_meta(src);
+
+    meta.length = 0;
+    memcpy(*src, &meta, sizeof(meta));
+
+    return 0;
+}
+
+int vvectorSplice(vvector dst, ptrdiff_t dst_index, vvector src, ptrdiff_t first, ptrdiff_t last){
+    if (!dst || !*dst || !src || !*src || dst == src) {
+        return VEC_ENOVEC;
+    }
+
+    ptrdiff_t dst_length = vvectorGetLength(dst);
+    ptrdiff_t src_length = vvectorGetLength(src);
+    ptrdiff_t vec_element_size = vec_get_element_size(src);
+
+    if (vec_get_element_size(dst) != vec_element_size) {
+        return VEC_EMISMATCH;
+    }
+
+    if (first < 0 || first > last || last > src_length || dst_index < 0 || dst_index > dst_length) {
+        return VEC_EBADINDEX;
+    }
+
+    TRACE_PAIR(VVECTOR_TRACE_SPLICE, dst, dst_index, src, first, last - first);
+
+    ptrdiff_t count = last - first;
+    if (count == 0) {
+        return 0;
+    }
+
+    int err = reserve_free_slots(dst, count);
+    if (err) return err;
+
+    uint8_t * dst_data = get_start_of_data(dst);
+    uint8_t * src_data = get_start_of_data(src);
+
+    // Open a gap in 'dst', fill it, then close the hole left in 'src'.
+    memmove(&(dst_data[(dst_index + count) * vec_element_size]), &(dst_data[dst_index * vec_element_size]), (dst_length - dst_index) * vec_element_size);
+    memcpy(&(dst_data[dst_index * vec_element_size]), &(src_data[first * vec_element_size]), count * vec_element_size);
+    memmove(&(src_data[first * vec_element_size]), &(src_data[last * vec_element_size]), (src_length - last) * vec_element_size);
+
+    // Update metadata.
+    struct vvectorMetadata_ meta = get_meta(dst);
+
+    meta.length += count;
+    memcpy(*dst, &meta, sizeof(meta));
+
+    meta = get_meta(src);
+
+    meta.length -= count;
+    memcpy(*src, &meta, sizeof(meta));
+
+    return 0;
+}
+
 // << Debug >>
 
 /// This returns the RAW element size, which is either negative or positive. @see vec_get_element_size().
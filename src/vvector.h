@@ -132,6 +132,57 @@ vvector vec_new_(ptrdiff_t sizeof_type, struct vvectorAlloc * allocator);
  */
 #define vvectorNew(TYPE, vvectorAlloc_pointer) vec_new_(sizeof(TYPE), vvectorAlloc_pointer)
 
+/**
+ * @brief   Internal function to create a zero filled vector. Use 'vvectorNewZeroed'.
+ *
+ * @param   sizeof_type The returned value of the sizeof() operator applied on the datatype you wish the vvector to store.
+ * @param   length      The number of zeroed elements the vvector starts with.
+ * @param   allocator   Pass a 'vvectorAlloc' struct pointer to use your own allocator, or NULL for defaults. @see vvectorAlloc.
+ * @return  The returned vvector or NULL.
+ *
+ * @see vvectorNewZeroed
+ */
+vvector vec_new_zeroed_(ptrdiff_t sizeof_type, ptrdiff_t length, struct vvectorAlloc * allocator);
+
+/**
+ * @brief Create a new vvector holding 'length' elements whose bytes are all zero.
+ *
+ * @code
+ * // A histogram with 1 << 30 counters. Memory is only used for the buckets which get touched.
+ * vvector counters = vvectorNewZeroed(uint64_t, 1 << 30, 0);
+ * @endcode
+ *
+ * With the default allocator the memory comes from calloc, which hands out fresh, already zero pages from the kernel
+ * for large sizes. Those pages cost nothing until they are first written or read. @see vvectorResizeZeroed
+ *
+ * @param TYPE                  The type to be stored in the vvector.
+ * @param length                The number of zeroed elements the vvector starts with.
+ * @param vvectorAlloc_pointer  Pass a 'vvectorAlloc' struct pointer to use your own allocator, or NULL for defaults. @see vvectorAlloc.
+ */
+#define vvectorNewZeroed(TYPE, length, vvectorAlloc_pointer) vec_new_zeroed_(sizeof(TYPE), length, vvectorAlloc_pointer)
+
+/**
+ * @brief Turn an existing array into a vvector, taking ownership of it.
+ *
+ * @code
+ * int * numbers = malloc(100 * sizeof(int));
+ * // ... fill numbers ...
+ * vvector vec = vvectorAdopt(numbers, 100, sizeof(int), 0);
+ * // 'numbers' now belongs to 'vec' and must not be used or free()'d.
+ * @endcode
+ *
+ * The array is grown in place with the allocator's realloc to make room for the vvector's metadata in front of the
+ * elements, which are then moved up with a single memmove. No second buffer is allocated.
+ * 'ptr' must have been allocated by 'allocator' (or by malloc if 'allocator' is NULL).
+ *
+ * @param   ptr             The array to adopt. On success it must no longer be used. On failure it is left untouched.
+ * @param   length          Number of elements in the array.
+ * @param   element_size    Size of an element in bytes.
+ * @param   allocator       Pass a 'vvectorAlloc' struct pointer to use your own allocator, or NULL for defaults. @see vvectorAlloc.
+ * @return  The new vvector or NULL.
+ */
+vvector vvectorAdopt(void * ptr, ptrdiff_t length, ptrdiff_t element_size, struct vvectorAlloc * allocator);
+
 /**
  * @brief Free a previously created vvector.
  * 
@@ -140,6 +191,19 @@ vvector vec_new_(ptrdiff_t sizeof_type, struct vvectorAlloc * allocator);
  */
 int vvectorFree(vvector vec);
 
+/**
+ * @brief Free a vvector's handle and metadata, handing its elements back as a plain array.
+ *
+ * The counterpart of 'vvectorAdopt'. The elements are moved to the start of the vvector's memory with a single
+ * memmove, which is then shrunk to exactly 'length * element_size' bytes. No second buffer is allocated.
+ * The caller owns the returned array and must release it with the vvector's free function (free() by default).
+ *
+ * @param   vec     Vector to be released. It must not be used afterwards.
+ * @param   length  Optional: Receives the number of elements in the returned array.
+ * @return  The array, or NULL on error or if the vvector was empty (it is still released).
+ */
+void * vvectorRelease(vvector vec, ptrdiff_t * length);
+
 // Shrink and Grow
 
 /**
@@ -159,6 +223,44 @@ int vvectorReserve(vvector vec, ptrdiff_t count);
  */
 int vvectorShrinkToFit(vvector vec);
 
+/**
+ * @brief Change the length of the vvector to 'length'.
+ *
+ * New elements are copies of the data pointed to by 'fill_value'. Shrinking only drops elements from the back,
+ * the memory is kept (@see vvectorShrinkToFit).
+ *
+ * @param   vec         The target vvector.
+ * @param   length      The new number of elements.
+ * @param   fill_value  Pointer to the value new elements are set to, may point into 'vec', e.g. vvectorGetBack(vec).
+ * @return  0 on success, a positive, non-zero value on error.
+ */
+int vvectorResize(vvector vec, ptrdiff_t length, void * fill_value);
+
+/**
+ * @brief Change the length of the vvector to 'length', leaving new elements uninitialized.
+ *
+ * For callers which overwrite the new elements in bulk right after, e.g. through 'vvectorGetAt(vec, old_length)'.
+ * Shrinking behaves like 'vvectorResize'.
+ *
+ * @param   vec         The target vvector.
+ * @param   length      The new number of elements.
+ * @return  0 on success, a positive, non-zero value on error.
+ */
+int vvectorResizeUninit(vvector vec, ptrdiff_t length);
+
+/**
+ * @brief Change the length of the vvector to 'length', setting every byte of new elements to zero.
+ *
+ * If the vvector uses the default allocator and mostly new memory is needed, the elements are moved into a fresh
+ * calloc()'d block instead of being reallocated and memset. Large calloc blocks are fresh pages from the kernel,
+ * which are only zeroed when first touched. Custom allocators get a regular reserve and memset.
+ *
+ * @param   vec         The target vvector.
+ * @param   length      The new number of elements.
+ * @return  0 on success, a positive, non-zero value on error.
+ */
+int vvectorResizeZeroed(vvector vec, ptrdiff_t length);
+
 // Get values
 
 /**
@@ -186,6 +288,57 @@ void * vvectorGetBack(vvector vec);
  */
 void * vvectorGetFront(vvector vec);
 
+/**
+ * @brief Find the first element whose bytes are equal to the data pointed to by 'value'.
+ *
+ * Elements are compared bytewise, like memcmp. 4 and 8 byte elements use the best SIMD kernel this CPU supports.
+ *
+ * @param   vec     Target vvector.
+ * @param   value   Pointer to the value to search for.
+ * @return  Returns the index of the first matching element, or -1 if there is none or on error.
+ */
+ptrdiff_t vvectorFind(vvector vec, void * value);
+
+/**
+ * @brief Copy the elements at 'indices' into 'out', one after another.
+ *
+ * Faster than calling 'vvectorGetAt' in a loop for random indices into a large vvector: upcoming elements are
+ * prefetched (@see vvectorSetPrefetchDistance) so many cache misses are in flight at once. 4 and 8 byte elements use
+ * AVX2 gathers where available, 4, 8 and 16 byte elements use fixed size copies.
+ *
+ * Every index is checked before anything is copied.
+ *
+ * @code
+ * ptrdiff_t indices[3] = {7, 2, 7};
+ * int out[3];
+ * int error = vvectorGather(int_vector, indices, 3, out);
+ * @endcode
+ *
+ * @param   vec     Target vvector.
+ * @param   indices Array of 'n' indices, each in [0, vvectorGetLength(vec)).
+ * @param   n       Number of elements to copy.
+ * @param   out     Buffer for 'n' elements, aligned for the element type.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorGather(vvector vec, const ptrdiff_t * indices, ptrdiff_t n, void * out);
+
+/**
+ * @brief Set how many indices ahead 'vvectorGather' and 'vvectorScatter' prefetch.
+ *
+ * The default is 16. Larger distances help when the vvector is far bigger than the cache. 0 disables prefetching.
+ * This setting is global and not thread safe.
+ *
+ * @param   distance    Number of indices.
+ */
+void vvectorSetPrefetchDistance(ptrdiff_t distance);
+
+/**
+ * @brief Get how many indices ahead 'vvectorGather' and 'vvectorScatter' prefetch.
+ *
+ * @return  The current distance.
+ */
+ptrdiff_t vvectorGetPrefetchDistance(void);
+
 // Add values
 
 /**
@@ -198,6 +351,36 @@ void * vvectorGetFront(vvector vec);
  */
 int vvectorWriteValueAt(vvector vec, ptrdiff_t index, void * value);
 
+/**
+ * @brief Replace the elements at 'indices' with consecutive elements read from 'values'.
+ *
+ * The batch counterpart of 'vvectorWriteValueAt': element i of 'values' is written at 'indices[i]'.
+ * Every index is checked before anything is written, and upcoming targets are prefetched for writing
+ * (@see vvectorSetPrefetchDistance). If an index appears more than once, the last write wins.
+ *
+ * @param   vec     Target vvector.
+ * @param   indices Array of 'n' indices, each in [0, vvectorGetLength(vec)).
+ * @param   values  Array of 'n' elements.
+ * @param   n       Number of elements to write.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorScatter(vvector vec, const ptrdiff_t * indices, void * values, ptrdiff_t n);
+
+/**
+ * @brief Like 'vvectorScatter', but the writes are first sorted by index.
+ *
+ * Writing in index order turns random writes into a forward sweep, which is faster for large batches
+ * (roughly, more than a few thousand writes into a vvector bigger than the cache).
+ * The sort is stable, so the last write to an index still wins. Uses the vvector's allocator for 2 * n * 16 bytes of scratch memory.
+ *
+ * @param   vec     Target vvector.
+ * @param   indices Array of 'n' indices, each in [0, vvectorGetLength(vec)).
+ * @param   values  Array of 'n' elements.
+ * @param   n       Number of elements to write.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorScatterSorted(vvector vec, const ptrdiff_t * indices, void * values, ptrdiff_t n);
+
 /**
  * @brief Add an element at the back of the vvector.
  * 
@@ -216,11 +399,65 @@ int vvectorPushBack(vvector vec, void * value);
  *
  * @param   vec     Target vvector.
  * @param   index   Target index.
- * @param   value   Pointer to the value which is to be added to the vector.
+ * @param   value   Pointer to the value which is to be added to the vector, may point into 'vec'.
  * @return  Returns 0 on success or a positive, non-zero value on error.
  */
 int vvectorInsertValueAt(vvector vec, ptrdiff_t index, void * value);
 
+// Bulk operations
+
+/**
+ * @brief How bulk operations copy element data.
+ *
+ * Non-temporal (streaming) stores write around the cache, so copying hundreds of MB does not evict
+ * the working set of other threads. They are slower when the data is read again soon after.
+ */
+enum vvectorCopyMode {
+    VVECTOR_COPY_AUTO = 0,  /**< Stream copies of at least 'vvectorGetStreamThreshold()' bytes, cache the rest. */
+    VVECTOR_COPY_CACHED,    /**< Always use a regular memcpy. */
+    VVECTOR_COPY_STREAM,    /**< Always use non-temporal stores. */
+};
+
+/**
+ * @brief Add 'count' elements, read from the array 'values', at the back of the vvector.
+ *
+ * Memory is reserved once for all elements, which are then copied with a single bulk copy.
+ *
+ * @param   vec     Target vvector.
+ * @param   values  Pointer to 'count' contiguous elements. Must not point into 'vec'.
+ * @param   count   Number of elements to add.
+ * @param   mode    How to copy the elements. @see vvectorCopyMode
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorAppend(vvector vec, void * values, ptrdiff_t count, enum vvectorCopyMode mode);
+
+/**
+ * @brief Create a new vvector holding a copy of every element in 'vec'.
+ *
+ * The clone uses the same allocators (and context pointer) as 'vec'.
+ *
+ * @param   vec     The vvector to copy.
+ * @param   mode    How to copy the elements. @see vvectorCopyMode
+ * @return  The new vvector or NULL.
+ */
+vvector vvectorClone(vvector vec, enum vvectorCopyMode mode);
+
+/**
+ * @brief Set the size in bytes from which VVECTOR_COPY_AUTO copies use non-temporal stores.
+ *
+ * Defaults to the size of the CPU's last level cache. This setting is global and not thread safe.
+ *
+ * @param   bytes   The new threshold. Negative values disable streaming in VVECTOR_COPY_AUTO mode.
+ */
+void vvectorSetStreamThreshold(ptrdiff_t bytes);
+
+/**
+ * @brief Get the size in bytes from which VVECTOR_COPY_AUTO copies use non-temporal stores.
+ *
+ * @return  The current threshold.
+ */
+ptrdiff_t vvectorGetStreamThreshold(void);
+
 // Remove values
 
 /**
@@ -242,6 +479,68 @@ int vvectorRemoveAt(vvector vec, ptrdiff_t index);
  */
 int vvectorRemoveBack(vvector vec);
 
+/**
+ * @brief Remove every element. The memory is kept for reuse (@see vvectorShrinkToFit).
+ *
+ * @param   vec     Target vvector.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorClear(vvector vec);
+
+// Exchange contents
+
+/**
+ * @brief Exchange the contents of two vvectors in O(1), without copying any elements.
+ *
+ * Only the buffers are swapped. Each buffer keeps its own element size, so it moves along with the contents.
+ * Both vvectors must use the same allocator (the defaults, or the same functions and context), since each handle
+ * is freed by the allocator which created it.
+ *
+ * @code
+ * // Double buffering: fill 'back' while reading 'front', then flip.
+ * vvectorSwap(front, back);
+ * vvectorClear(back);
+ * @endcode
+ *
+ * @param   a   First vvector.
+ * @param   b   Second vvector.
+ * @return  Returns 0 on success or a positive, non-zero value on error, e.g. VEC_EMISMATCH if the allocators differ.
+ */
+int vvectorSwap(vvector a, vvector b);
+
+/**
+ * @brief Move the contents of 'src' into 'dst' in O(1), without copying any elements.
+ *
+ * Afterwards 'dst' holds what 'src' held, and 'src' is empty. Rather than being freed, the buffer 'dst' held before
+ * is handed to 'src', so 'src' can be refilled without allocating. Like 'vvectorSwap', both vvectors must use the same allocator.
+ *
+ * @param   dst     Receives the contents of 'src'.
+ * @param   src     Left empty.
+ * @return  Returns 0 on success or a positive, non-zero value on error, e.g. VEC_EMISMATCH if the allocators differ.
+ */
+int vvectorMove(vvector dst, vvector src);
+
+/**
+ * @brief Move the elements [first, last) of 'src' into 'dst', inserting them at 'dst_index'.
+ *
+ * Elements after the range in 'src' move forward, elements from 'dst_index' on in 'dst' move back. No gaps left.
+ * Costs one reservation in 'dst', one copy of the range and one shift in each vvector.
+ *
+ * @code
+ * // Move the last 100 elements of shard_a to the front of shard_b.
+ * ptrdiff_t len = vvectorGetLength(shard_a);
+ * int error = vvectorSplice(shard_b, 0, shard_a, len - 100, len);
+ * @endcode
+ *
+ * @param   dst         Receiving vvector. Must have the same element size as 'src' and be a different vvector.
+ * @param   dst_index   Position in 'dst' for the first moved element, in [0, vvectorGetLength(dst)].
+ * @param   src         Vvector the elements are taken from.
+ * @param   first       Index of the first element to move.
+ * @param   last        Index one past the last element to move, in [first, vvectorGetLength(src)].
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorSplice(vvector dst, ptrdiff_t dst_index, vvector src, ptrdiff_t first, ptrdiff_t last);
+
 // Control logic
 
 /**
@@ -260,6 +559,22 @@ int vvectorRemoveBack(vvector vec);
  */
 ptrdiff_t vvectorGetLength(vvector vec);
 
+/**
+ * @brief Get the capacity of the vvector, aka the number of elements it can hold before it has to reallocate.
+ *
+ * @param   vec     Target vvector.
+ * @return  Returns the capacity of the vvector in elements or 0 on error.
+ */
+ptrdiff_t vvectorGetCapacity(vvector vec);
+
+/**
+ * @brief Get the size in bytes of a single element of the vvector.
+ *
+ * @param   vec     Target vvector.
+ * @return  Returns the element size or 0 on error.
+ */
+ptrdiff_t vvectorGetElementSize(vvector vec);
+
 /**
  * @brief Check if a vector is empty
  * 
@@ -276,6 +591,15 @@ ptrdiff_t vvectorGetLength(vvector vec);
  */
 int vvectorIsEmpty(vvector vec);
 
+/**
+ * @brief Check if a vvector was created with 'allocator', as passed to 'vec_new_'.
+ *
+ * @param   vec         Target vvector.
+ * @param   allocator   The allocator, or NULL for the defaults.
+ * @return  Returns 1 if the vvector uses the same functions and context, 0 otherwise or on error.
+ */
+int vvectorUsesAllocator(vvector vec, const struct vvectorAlloc * allocator);
+
 // Debug functions
 #ifdef LIBVVECTOR_ENABLE_DEBUG_FN
 ptrdiff_t vvector_debug_get_capacity(vvector vec);
@@ -286,6 +610,92 @@ void * vvector_debug_get_realloc_fn(vvector vec);
 void * vvector_debug_get_ctx(vvector vec);
 #endif // LIBVVECTOR_ENABLE_DEBUG_FN
 
+// Tracing
+
+/**
+ * @brief The operations recorded in a vvector trace.
+ *
+ * Wrappers are recorded as the operation they forward to, e.g. 'vvectorPushBack' is recorded as
+ * VVECTOR_TRACE_INSERT_AT with 'index' equal to the length of the vector. Calls rejected by argument validation are not recorded,
+ * and neither are the reservations operations make internally.
+ */
+enum vvectorTraceOp {
+    VVECTOR_TRACE_NEW = 1,      /**< 'vec_new_'. */
+    VVECTOR_TRACE_FREE,         /**< 'vvectorFree'. */
+    VVECTOR_TRACE_RESERVE,      /**< 'vvectorReserve', 'index' holds the count. */
+    VVECTOR_TRACE_SHRINK,       /**< 'vvectorShrinkToFit'. */
+    VVECTOR_TRACE_GET_AT,       /**< 'vvectorGetAt', 'vvectorGetBack' and 'vvectorGetFront'. */
+    VVECTOR_TRACE_WRITE_AT,     /**< 'vvectorWriteValueAt'. */
+    VVECTOR_TRACE_INSERT_AT,    /**< 'vvectorInsertValueAt' and 'vvectorPushBack'. */
+    VVECTOR_TRACE_REMOVE_AT,    /**< 'vvectorRemoveAt' and 'vvectorRemoveBack'. */
+    VVECTOR_TRACE_APPEND,       /**< 'vvectorAppend', 'index' holds the count. */
+    VVECTOR_TRACE_GATHER,       /**< 'vvectorGather', 'index' holds the number of indices. */
+    VVECTOR_TRACE_SCATTER,      /**< 'vvectorScatter', 'index' holds the number of indices. */
+    VVECTOR_TRACE_SCATTER_SORTED, /**< 'vvectorScatterSorted', 'index' holds the number of indices. */
+    VVECTOR_TRACE_RESIZE,       /**< 'vvectorResize', 'index' holds the new length. */
+    VVECTOR_TRACE_RESIZE_UNINIT, /**< 'vvectorResizeUninit', 'index' holds the new length. */
+    VVECTOR_TRACE_RESIZE_ZEROED, /**< 'vvectorResizeZeroed', 'index' holds the new length. */
+    VVECTOR_TRACE_CLEAR,        /**< 'vvectorClear'. */
+    VVECTOR_TRACE_SWAP,         /**< 'vvectorSwap', 'other_id' is the second vvector. */
+    VVECTOR_TRACE_MOVE,         /**< 'vvectorMove', 'vec_id' is 'dst' and 'other_id' is 'src'. */
+    VVECTOR_TRACE_SPLICE,       /**< 'vvectorSplice': 'index' is 'dst_index', 'other_id' is 'src', 'other_index' is 'first', 'count' is last - first. */
+    VVECTOR_TRACE_ADOPT,        /**< 'vvectorAdopt', 'index' holds the adopted length. */
+    VVECTOR_TRACE_NR_OPS
+};
+
+/**
+ * @brief A single recorded operation. Trace files are a 'vvectorTraceHeader' followed by these records.
+ *
+ * Records are written in per-thread batches, so a trace file is only sorted by 'timestamp' within a thread.
+ */
+struct vvectorTraceRecord {
+    uint64_t timestamp;     /**< Nanoseconds since 'vvectorTraceStart'. */
+    uint64_t vec_id;        /**< Identifies the vvector. Only meaningful between its NEW and FREE records. */
+    uint64_t other_id;      /**< The second vvector of SWAP, MOVE and SPLICE, 0 otherwise. */
+    int64_t index;          /**< Index or count argument, 0 if the operation has none. */
+    int64_t other_index;    /**< Index into the second vvector, 0 if the operation has none. */
+    int64_t count;          /**< Number of elements moved between the two vvectors, 0 if the operation has none. */
+    int32_t element_size;   /**< Element size of the vvector. */
+    uint16_t thread;        /**< Identifies the recording thread. */
+    uint8_t op;             /**< A 'vvectorTraceOp'. */
+    uint8_t reserved;
+};
+
+#define VVECTOR_TRACE_MAGIC 0x52545656u     /**< "VVTR" */
+#define VVECTOR_TRACE_VERSION 3
+
+/**
+ * @brief The start of every trace file.
+ */
+struct vvectorTraceHeader {
+    uint32_t magic;         /**< VVECTOR_TRACE_MAGIC */
+    uint32_t version;       /**< VVECTOR_TRACE_VERSION */
+    uint32_t record_size;   /**< sizeof(struct vvectorTraceRecord) */
+    uint32_t reserved;
+};
+
+#ifdef LIBVVECTOR_ENABLE_TRACE
+/**
+ * @brief Start recording every vvector operation into the file at 'path'.
+ *
+ * Only available when the library itself is compiled with LIBVVECTOR_ENABLE_TRACE.
+ * Each thread fills its own buffer and writes it out with a single write() once full, so recording takes no locks.
+ *
+ * @param   path    Trace file to create. Truncated if it already exists.
+ * @return  0 on success, non-zero on error or if a trace is already running.
+ */
+int vvectorTraceStart(const char * path);
+
+/**
+ * @brief Flush every thread's buffer and close the trace file.
+ *
+ * @warning Other threads must not be using vvectors while this runs.
+ *
+ * @return  0 on success, non-zero on error.
+ */
+int vvectorTraceStop(void);
+#endif // LIBVVECTOR_ENABLE_TRACE
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,314 @@
+/*
+    Copyright 2024 I. Laurentiu
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "vvector_digest.h"
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// @file vvector_digest.c
+
+#define VEC_ENOVEC 1        /**< Indicates that the provided digest or vector argument is NULL. */
+#define VEC_EBADINDEX 2     /**< Indicates that the provided range is invalid. */
+#define VEC_ENOVALUE 3      /**< Indicates that the provided value pointer is NULL. */
+#define VEC_EMISMATCH 4     /**< Indicates that the vector does not hold doubles. */
+
+#define DEFAULT_COMPRESSION 100
+#define BUFFER_FACTOR 8     /**< The insert buffer holds 8 * compression samples before it is merged. */
+
+struct vvectorDigest {
+    double compression;
+    ptrdiff_t buffer_size;
+
+    vvector centroids;      /**< struct vvectorDigestCentroid, sorted by mean. */
+    vvector buffer;         /**< struct vvectorDigestCentroid, unsorted pending inserts. */
+    vvector scratch;        /**< struct vvectorDigestCentroid, reused by every merge. */
+
+    double count;
+    double min;
+    double max;
+
+    struct vvectorAlloc alloc;  /**< Used for this struct. Missing functions fall back to the C library. */
+};
+
+/* Helpers */
+
+static void * digest_malloc(struct vvectorAlloc * alloc, ptrdiff_t size){
+    if (alloc && alloc->malloc_fn) return alloc->malloc_fn(size, alloc->ctx);
+
+    return malloc(size);
+}
+
+static void digest_free(struct vvectorAlloc * alloc, void * ptr, ptrdiff_t size){
+    if (alloc && alloc->free_fn) {
+        alloc->free_fn(ptr, size, alloc->ctx);
+        return;
+    }
+
+    free(ptr);
+}
+
+static int compare_centroids(const void * a, const void * b){
+    double x = ((const struct vvectorDigestCentroid *) a)->mean;
+    double y = ((const struct vvectorDigestCentroid *) b)->mean;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * @internal
+ * @brief Sort the buffer, merge it with the centroids, and shrink the result to ~compression / 2 * ln(count) centroids.
+ *
+ * Neighbours are combined while the combined weight stays under 4 * count * q * (1 - q) / compression,
+ * q being the quantile at the combined centroid's center. Centroids shrink towards the tails, down to single samples
+ * at the extremes, which is where the logarithmic growth comes from.
+ */
+static int flush(struct vvectorDigest * digest){
+    ptrdiff_t nr_buffered = vvectorGetLength(digest->buffer);
+    if (nr_buffered == 0) return 0;
+
+    struct vvectorDigestCentroid * buffered = vvectorGetFront(digest->buffer);
+    qsort(buffered, nr_buffered, sizeof(struct vvectorDigestCentroid), compare_centroids);
+
+    // Merge the two sorted lists into 'scratch'.
+    ptrdiff_t nr_centroids = vvectorGetLength(digest->centroids);
+
+    int err = vvectorResizeUninit(digest->scratch, nr_centroids + nr_buffered);
+    if (err) return err;
+
+    const struct vvectorDigestCentroid * centroids = (nr_centroids > 0) ? vvectorGetFront(digest->centroids) : 0;
+    struct vvectorDigestCentroid * merged = vvectorGetFront(digest->scratch);
+    ptrdiff_t i = 0;
+    ptrdiff_t j = 0;
+    ptrdiff_t n = 0;
+
+    while (i < nr_centroids || j < nr_buffered) {
+        if (j == nr_buffered || (i < nr_centroids && centroids[i].mean <= buffered[j].mean)) merged[n++] = centroids[i++];
+        else merged[n++] = buffered[j++];
+    }
+
+    // Compress, writing back into 'scratch' (the write position never passes the read position).
+    double total = digest->count;
+    double weight_before = 0;
+    struct vvectorDigestCentroid current = merged[0];
+    ptrdiff_t out = 0;
+
+    for (ptrdiff_t k = 1; k < n; k++) {
+        double combined = current.weight + merged[k].weight;
+        double q = (weight_before + combined / 2) / total;
+        double limit = 4 * total * q * (1 - q) / digest->compression;
+
+        if (combined <= limit) {
+            current.mean += (merged[k].mean - current.mean) * merged[k].weight / combined;
+            current.weight = combined;
+        } else {
+            weight_before += current.weight;
+            merged[out++] = current;
+            current = merged[k];
+        }
+    }
+    merged[out++] = current;
+
+    err = vvectorResizeUninit(digest->scratch, out);
+    if (err) return err;
+
+    // The merged list becomes the centroids, the old centroids vvector is reused as scratch next time.
+    vvectorSwap(digest->centroids, digest->scratch);
+    vvectorClear(digest->buffer);
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Add a weighted point to the buffer, flushing it when full.
+ */
+static int add_point(struct vvectorDigest * digest, double mean, double weight){
+    if (isnan(mean)) return 0;
+
+    struct vvectorDigestCentroid point;
+    point.mean = mean;
+    point.weight = weight;
+
+    int err = vvectorPushBack(digest->buffer, &point);
+    if (err) return err;
+
+    if (digest->count == 0 || mean < digest->min) digest->min = mean;
+    if (digest->count == 0 || mean > digest->max) digest->max = mean;
+    digest->count += weight;
+
+    if (vvectorGetLength(digest->buffer) >= digest->buffer_size) {
+        return flush(digest);
+    }
+
+    return 0;
+}
+
+/* Create and destroy */
+
+struct vvectorDigest * vvectorDigestNew(double compression, struct vvectorAlloc * allocator){
+    if (compression < 0 || isnan(compression)) return 0;
+
+    if (compression == 0) compression = DEFAULT_COMPRESSION;
+    if (compression < 10) compression = 10;
+
+    struct vvectorDigest * digest = digest_malloc(allocator, sizeof(struct vvectorDigest));
+    if (!digest) return 0;
+
+    memset(digest, 0, sizeof(struct vvectorDigest));
+    if (allocator) digest->alloc = *allocator;
+    digest->compression = compression;
+    digest->buffer_size = (ptrdiff_t) (BUFFER_FACTOR * compression);
+
+    digest->centroids = vec_new_(sizeof(struct vvectorDigestCentroid), allocator);
+    digest->buffer = vec_new_(sizeof(struct vvectorDigestCentroid), allocator);
+    digest->scratch = vec_new_(sizeof(struct vvectorDigestCentroid), allocator);
+
+    if (!digest->centroids || !digest->buffer || !digest->scratch || vvectorReserve(digest->buffer, digest->buffer_size)) {
+        vvectorDigestFree(digest);
+        return 0;
+    }
+
+    return digest;
+}
+
+int vvectorDigestFree(struct vvectorDigest * digest){
+    if (!digest) return VEC_ENOVEC;
+
+    if (digest->centroids) vvectorFree(digest->centroids);
+    if (digest->buffer) vvectorFree(digest->buffer);
+    if (digest->scratch) vvectorFree(digest->scratch);
+
+    struct vvectorAlloc alloc = digest->alloc;
+    digest_free(&alloc, digest, sizeof(struct vvectorDigest));
+
+    return 0;
+}
+
+/* Insert and merge */
+
+int vvectorDigestInsert(struct vvectorDigest * digest, double value){
+    if (!digest) return VEC_ENOVEC;
+
+    return add_point(digest, value, 1);
+}
+
+int vvectorDigestInsertMany(struct vvectorDigest * digest, const double * values, ptrdiff_t count){
+    if (!digest) return VEC_ENOVEC;
+
+    if (count < 0) return VEC_EBADINDEX;
+
+    if (count > 0 && !values) return VEC_ENOVALUE;
+
+    for (ptrdiff_t i = 0; i < count; i++) {
+        int err = add_point(digest, values[i], 1);
+        if (err) return err;
+    }
+
+    return 0;
+}
+
+int vvectorDigestInsertVector(struct vvectorDigest * digest, vvector vec, ptrdiff_t first, ptrdiff_t last){
+    if (!digest || !vec || !*vec) return VEC_ENOVEC;
+
+    if (vvectorGetElementSize(vec) != sizeof(double)) return VEC_EMISMATCH;
+
+    if (first < 0 || first > last || last > vvectorGetLength(vec)) return VEC_EBADINDEX;
+
+    if (first == last) return 0;
+
+    return vvectorDigestInsertMany(digest, vvectorGetAt(vec, first), last - first);
+}
+
+int vvectorDigestMerge(struct vvectorDigest * dst, struct vvectorDigest * src){
+    if (!dst || !src) return VEC_ENOVEC;
+
+    if (dst == src) return VEC_EBADINDEX;
+
+    const struct vvectorDigestCentroid * points = vvectorGetFront(src->centroids);
+    ptrdiff_t nr_points = vvectorGetLength(src->centroids);
+
+    for (ptrdiff_t i = 0; i < nr_points; i++) {
+        int err = add_point(dst, points[i].mean, points[i].weight);
+        if (err) return err;
+    }
+
+    points = vvectorGetFront(src->buffer);
+    nr_points = vvectorGetLength(src->buffer);
+
+    for (ptrdiff_t i = 0; i < nr_points; i++) {
+        int err = add_point(dst, points[i].mean, points[i].weight);
+        if (err) return err;
+    }
+
+    // Centroid means lie inside [min, max]; take the exact extremes from 'src'.
+    if (src->count > 0) {
+        if (src->min < dst->min) dst->min = src->min;
+        if (src->max > dst->max) dst->max = src->max;
+    }
+
+    return 0;
+}
+
+/* Queries */
+
+double vvectorDigestQuantile(struct vvectorDigest * digest, double q){
+    if (!digest || isnan(q) || flush(digest)) return NAN;
+
+    if (digest->count == 0) return NAN;
+
+    if (q <= 0) return digest->min;
+    if (q >= 1) return digest->max;
+
+    const struct vvectorDigestCentroid * c = vvectorGetFront(digest->centroids);
+    ptrdiff_t n = vvectorGetLength(digest->centroids);
+    double index = q * digest->count;
+
+    // Each centroid's mean is taken to sit at the middle of its weight; interpolate between those points,
+    // and between the extremes and the outermost centroids.
+    if (index < c[0].weight / 2) {
+        return digest->min + (c[0].mean - digest->min) * index / (c[0].weight / 2);
+    }
+
+    double position = c[0].weight / 2;
+
+    for (ptrdiff_t i = 0; i + 1 < n; i++) {
+        double step = (c[i].weight + c[i + 1].weight) / 2;
+
+        if (index < position + step) {
+            return c[i].mean + (c[i + 1].mean - c[i].mean) * (index - position) / step;
+        }
+
+        position += step;
+    }
+
+    double tail = c[n - 1].weight / 2;
+
+    return c[n - 1].mean + (digest->max - c[n - 1].mean) * (index - position) / tail;
+}
+
+double vvectorDigestGetCount(struct vvectorDigest * digest){
+    if (!digest) return 0;
+
+    return digest->count;
+}
+
+vvector vvectorDigestGetCentroids(struct vvectorDigest * digest){
+    if (!digest || flush(digest)) return 0;
+
+    return digest->centroids;
+}
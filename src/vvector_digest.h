@@ -0,0 +1,149 @@
+/*
+    Copyright 2024 I. Laurentiu
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef VVECTOR_DIGEST_H
+#define VVECTOR_DIGEST_H
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+#include "vvector.h"
+
+#include <stddef.h>
+
+/// @file vvector_digest.h
+
+/**
+ * @struct vvectorDigestCentroid
+ *
+ * @brief   'weight' samples summarized by their mean.
+ */
+struct vvectorDigestCentroid {
+    double mean;
+    double weight;
+};
+
+/**
+ * @struct vvectorDigest
+ *
+ * @brief   A t-digest: approximate quantiles of any number of samples, in O(compression * log(count)) memory.
+ *
+ * Samples are summarized by sorted centroids, about compression / 2 * ln(count) of them, e.g. ~600 for
+ * a compression of 100 and 200 000 samples. Centroids near the median may hold many samples,
+ * those near the tails only a few, so extreme quantiles (p99, p999) stay accurate.
+ *
+ * Inserts go to a buffer, which is sorted and merged into the centroids when full, so an insert is O(1) amortized.
+ * Digests built on different threads can be merged in time linear in the source's centroids. A single digest is not thread safe.
+ *
+ * @code
+ * struct vvectorDigest * shard = vvectorDigestNew(100, 0);
+ * vvectorDigestInsertVector(shard, latencies, 0, vvectorGetLength(latencies));
+ * vvectorDigestMerge(total, shard);
+ * double p99 = vvectorDigestQuantile(total, 0.99);
+ * @endcode
+ */
+struct vvectorDigest;
+
+/**
+ * @brief Create a new, empty digest.
+ *
+ * @param   compression     Accuracy versus size: the digest keeps about compression / 2 * ln(count) centroids. 0 means the default (100).
+ * @param   allocator       Allocator for the digest's storage, or NULL for defaults. @see vvectorAlloc.
+ * @return  The new digest or NULL.
+ */
+struct vvectorDigest * vvectorDigestNew(double compression, struct vvectorAlloc * allocator);
+
+/**
+ * @brief Free the digest.
+ *
+ * @param   digest  The digest.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorDigestFree(struct vvectorDigest * digest);
+
+/**
+ * @brief Add a sample. NaN samples are ignored.
+ *
+ * @param   digest  The digest.
+ * @param   value   The sample.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorDigestInsert(struct vvectorDigest * digest, double value);
+
+/**
+ * @brief Add 'count' samples. NaN samples are ignored.
+ *
+ * @param   digest  The digest.
+ * @param   values  Pointer to 'count' samples.
+ * @param   count   Number of samples.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorDigestInsertMany(struct vvectorDigest * digest, const double * values, ptrdiff_t count);
+
+/**
+ * @brief Add the elements [first, last) of a vvector of double.
+ *
+ * @param   digest  The digest.
+ * @param   vec     vvector of double.
+ * @param   first   Index of the first element to add.
+ * @param   last    Index one past the last element to add.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorDigestInsertVector(struct vvectorDigest * digest, vvector vec, ptrdiff_t first, ptrdiff_t last);
+
+/**
+ * @brief Add every sample summarized by 'src' to 'dst'. 'src' is not modified.
+ *
+ * @param   dst     The digest to merge into.
+ * @param   src     The digest to merge. May use a different compression.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorDigestMerge(struct vvectorDigest * dst, struct vvectorDigest * src);
+
+/**
+ * @brief Estimate the 'q' quantile, e.g. 0.5 for the median.
+ *
+ * Merges pending inserts first.
+ *
+ * @param   digest  The digest.
+ * @param   q       The quantile, in [0, 1]. 0 and 1 return the exact minimum and maximum.
+ * @return  The estimate, or NaN if the digest is empty or on error.
+ */
+double vvectorDigestQuantile(struct vvectorDigest * digest, double q);
+
+/**
+ * @brief Get the number of samples added.
+ *
+ * @param   digest  The digest.
+ * @return  The number of samples, or 0 on error.
+ */
+double vvectorDigestGetCount(struct vvectorDigest * digest);
+
+/**
+ * @brief Get the centroids, sorted by mean, as a vvector of 'struct vvectorDigestCentroid'.
+ *
+ * Merges pending inserts first. The vvector is owned by the digest and must not be modified.
+ *
+ * @param   digest  The digest.
+ * @return  The centroids or NULL on error.
+ */
+vvector vvectorDigestGetCentroids(struct vvectorDigest * digest);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VVECTOR_DIGEST_H
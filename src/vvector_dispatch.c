@@ -0,0 +1,169 @@
+/*
+    Copyright 2024 I. Laurentiu
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+// sysconf(_SC_LEVEL3_CACHE_SIZE)
+#define _GNU_SOURCE
+
+#include "vvector_dispatch.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/// @file vvector_dispatch.c
+
+struct vvector_kernels_ vvector_kernels_ = {
+    vvector_find_u32_scalar_,
+    vvector_find_u64_scalar_,
+    vvector_stream_copy_scalar_,
+    vvector_gather_u32_scalar_,
+    vvector_gather_u64_scalar_,
+    vvector_axpy_f32_scalar_,
+    vvector_axpy_f64_scalar_,
+    vvector_compare_i8_scalar_,
+    vvector_compare_i16_scalar_,
+    vvector_compare_i32_scalar_,
+    vvector_compare_i64_scalar_,
+    vvector_compare_f32_scalar_,
+    vvector_compare_f64_scalar_,
+    vvector_compress_u32_scalar_,
+    vvector_compress_u64_scalar_,
+    vvector_sort_i32_scalar_,
+    vvector_sort_i64_scalar_,
+    vvector_sort_f32_scalar_,
+    vvector_sort_f64_scalar_,
+};
+
+ptrdiff_t vvector_stream_threshold_ = 8 * 1024 * 1024;
+
+static enum vvector_isa_ vvector_isa = VVECTOR_ISA_SCALAR;
+
+/**
+ * @internal
+ * @brief Find the best instruction set supported by both the CPU and the OS.
+ *
+ * The 'VVECTOR_ISA' environment variable ("scalar", "sse2", "avx2" or "avx512") can lower the result, which is useful for benchmarking.
+ * It can never raise it above what the CPU supports.
+ *
+ * @return The instruction set to use.
+ */
+static enum vvector_isa_ detect_isa(void){
+    enum vvector_isa_ isa = VVECTOR_ISA_SCALAR;
+
+#if VVECTOR_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("sse2")) {
+        isa = VVECTOR_ISA_SSE2;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        isa = VVECTOR_ISA_AVX2;
+    }
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl")) {
+        isa = VVECTOR_ISA_AVX512;
+    }
+#endif
+
+    const char * requested = getenv("VVECTOR_ISA");
+    if (requested) {
+        enum vvector_isa_ limit = isa;
+
+        if (strcmp(requested, "scalar") == 0) limit = VVECTOR_ISA_SCALAR;
+        else if (strcmp(requested, "sse2") == 0) limit = VVECTOR_ISA_SSE2;
+        else if (strcmp(requested, "avx2") == 0) limit = VVECTOR_ISA_AVX2;
+        else if (strcmp(requested, "avx512") == 0) limit = VVECTOR_ISA_AVX512;
+
+        if (limit < isa) isa = limit;
+    }
+
+    return isa;
+}
+
+/**
+ * @internal
+ * @brief Size of the last level cache in bytes, or 0 if unknown.
+ */
+static ptrdiff_t detect_llc_size(void){
+    long size = 0;
+
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (size <= 0) size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+
+    return (size > 0) ? size : 0;
+}
+
+/**
+ * @internal
+ * @brief Fills 'vvector_kernels_' once, when the library is loaded.
+ */
+__attribute__((constructor))
+static void vvector_dispatch_init(void){
+    vvector_isa = detect_isa();
+
+    ptrdiff_t llc_size = detect_llc_size();
+    if (llc_size) vvector_stream_threshold_ = llc_size;
+
+#if VVECTOR_X86
+    if (vvector_isa >= VVECTOR_ISA_SSE2) {
+        vvector_kernels_.stream_copy = vvector_stream_copy_sse2_;
+    }
+
+    if (vvector_isa >= VVECTOR_ISA_AVX2) {
+        vvector_kernels_.find_u32 = vvector_find_u32_avx2_;
+        vvector_kernels_.find_u64 = vvector_find_u64_avx2_;
+        vvector_kernels_.stream_copy = vvector_stream_copy_avx2_;
+        vvector_kernels_.gather_u32 = vvector_gather_u32_avx2_;
+        vvector_kernels_.gather_u64 = vvector_gather_u64_avx2_;
+        vvector_kernels_.axpy_f32 = vvector_axpy_f32_avx2_;
+        vvector_kernels_.axpy_f64 = vvector_axpy_f64_avx2_;
+        vvector_kernels_.compare_i8 = vvector_compare_i8_avx2_;
+        vvector_kernels_.compare_i16 = vvector_compare_i16_avx2_;
+        vvector_kernels_.compare_i32 = vvector_compare_i32_avx2_;
+        vvector_kernels_.compare_i64 = vvector_compare_i64_avx2_;
+        vvector_kernels_.compare_f32 = vvector_compare_f32_avx2_;
+        vvector_kernels_.compare_f64 = vvector_compare_f64_avx2_;
+        vvector_kernels_.sort_i32 = vvector_sort_i32_avx2_;
+        vvector_kernels_.sort_i64 = vvector_sort_i64_avx2_;
+        vvector_kernels_.sort_f32 = vvector_sort_f32_avx2_;
+        vvector_kernels_.sort_f64 = vvector_sort_f64_avx2_;
+    }
+
+    if (vvector_isa >= VVECTOR_ISA_AVX512) {
+        vvector_kernels_.find_u32 = vvector_find_u32_avx512_;
+        vvector_kernels_.find_u64 = vvector_find_u64_avx512_;
+        vvector_kernels_.stream_copy = vvector_stream_copy_avx512_;
+        vvector_kernels_.axpy_f32 = vvector_axpy_f32_avx512_;
+        vvector_kernels_.axpy_f64 = vvector_axpy_f64_avx512_;
+        vvector_kernels_.compare_i8 = vvector_compare_i8_avx512_;
+        vvector_kernels_.compare_i16 = vvector_compare_i16_avx512_;
+        vvector_kernels_.compare_i32 = vvector_compare_i32_avx512_;
+        vvector_kernels_.compare_i64 = vvector_compare_i64_avx512_;
+        vvector_kernels_.compare_f32 = vvector_compare_f32_avx512_;
+        vvector_kernels_.compare_f64 = vvector_compare_f64_avx512_;
+        vvector_kernels_.compress_u32 = vvector_compress_u32_avx512_;
+        vvector_kernels_.compress_u64 = vvector_compress_u64_avx512_;
+        vvector_kernels_.sort_i32 = vvector_sort_i32_avx512_;
+        vvector_kernels_.sort_i64 = vvector_sort_i64_avx512_;
+        vvector_kernels_.sort_f32 = vvector_sort_f32_avx512_;
+        vvector_kernels_.sort_f64 = vvector_sort_f64_avx512_;
+    }
+#endif
+}
+
+enum vvector_isa_ vvector_get_isa_(void){
+    return vvector_isa;
+}
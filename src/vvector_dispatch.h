@@ -0,0 +1,170 @@
+/*
+    Copyright 2024 I. Laurentiu
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef VVECTOR_DISPATCH_H
+#define VVECTOR_DISPATCH_H
+
+/// @file vvector_dispatch.h
+/// @internal Runtime CPU feature dispatch. Not installed, only used by the library's own sources.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #define VVECTOR_X86 1
+#else
+    #define VVECTOR_X86 0
+#endif
+
+/**
+ * @internal
+ * @brief Largest input of the small sort kernels.
+ */
+#define VVECTOR_SMALL_SORT_MAX 256
+
+/**
+ * @internal
+ * @brief Instruction sets kernels can be built for, from worst to best.
+ */
+enum vvector_isa_ {
+    VVECTOR_ISA_SCALAR = 0,
+    VVECTOR_ISA_SSE2,
+    VVECTOR_ISA_AVX2,
+    VVECTOR_ISA_AVX512,     /**< AVX-512 F, BW and VL. */
+};
+
+/**
+ * @internal
+ * @struct vvector_kernels_
+ * @brief One function pointer per kernel, set to the best variant for this CPU.
+ *
+ * The table is statically initialized with the scalar variants, so it is usable even before the load time constructor runs.
+ * Every kernel variant is built with its own __attribute__((target(...))), the library itself is compiled without arch flags.
+ */
+struct vvector_kernels_ {
+    /** Index of the first element equal to 'value', or -1. */
+    ptrdiff_t (*find_u32)(const uint32_t * data, ptrdiff_t n, uint32_t value);
+    /** Index of the first element equal to 'value', or -1. */
+    ptrdiff_t (*find_u64)(const uint64_t * data, ptrdiff_t n, uint64_t value);
+    /** memcpy using non-temporal stores, followed by a store fence. Buffers must not overlap. */
+    void (*stream_copy)(void * dst, const void * src, ptrdiff_t n);
+    /** out[i] = data[indices[i]], prefetching 'distance' indices ahead. Indices must be valid. */
+    void (*gather_u32)(const uint32_t * data, const ptrdiff_t * indices, ptrdiff_t n, uint32_t * out, ptrdiff_t distance);
+    /** out[i] = data[indices[i]], prefetching 'distance' indices ahead. Indices must be valid. */
+    void (*gather_u64)(const uint64_t * data, const ptrdiff_t * indices, ptrdiff_t n, uint64_t * out, ptrdiff_t distance);
+    /** y[i] += a * x[i]. Multiply and add are rounded separately, so every variant gives the same result. */
+    void (*axpy_f32)(float a, const float * x, float * y, ptrdiff_t n);
+    /** y[i] += a * x[i]. Multiply and add are rounded separately, so every variant gives the same result. */
+    void (*axpy_f64)(double a, const double * x, double * y, ptrdiff_t n);
+    /**
+     * Set bit i of 'bitmap' to x[i] 'op' (y ? y[i] : a), or a <= x[i] <= b for VVECTOR_BETWEEN. @see vvectorCompareOp
+     * Writes (n + 63) / 64 words, unused bits of the last one are 0.
+     */
+    void (*compare_i8)(const int8_t * x, const int8_t * y, int8_t a, int8_t b, int op, ptrdiff_t n, uint64_t * bitmap);
+    void (*compare_i16)(const int16_t * x, const int16_t * y, int16_t a, int16_t b, int op, ptrdiff_t n, uint64_t * bitmap);
+    void (*compare_i32)(const int32_t * x, const int32_t * y, int32_t a, int32_t b, int op, ptrdiff_t n, uint64_t * bitmap);
+    void (*compare_i64)(const int64_t * x, const int64_t * y, int64_t a, int64_t b, int op, ptrdiff_t n, uint64_t * bitmap);
+    void (*compare_f32)(const float * x, const float * y, float a, float b, int op, ptrdiff_t n, uint64_t * bitmap);
+    void (*compare_f64)(const double * x, const double * y, double a, double b, int op, ptrdiff_t n, uint64_t * bitmap);
+    /** Copy every x[i] whose bit is set in 'bitmap' to 'out', in order. Returns the number copied. */
+    ptrdiff_t (*compress_u32)(const uint32_t * x, const uint64_t * bitmap, ptrdiff_t n, uint32_t * out);
+    ptrdiff_t (*compress_u64)(const uint64_t * x, const uint64_t * bitmap, ptrdiff_t n, uint64_t * out);
+    /**
+     * Sort n <= VVECTOR_SMALL_SORT_MAX elements in place, ascending. Floats are ordered by their bits:
+     * NaNs with the sign bit set first, then -inf, ..., -0.0, +0.0, ..., +inf, then the other NaNs.
+     */
+    void (*sort_i32)(int32_t * data, ptrdiff_t n);
+    void (*sort_i64)(int64_t * data, ptrdiff_t n);
+    void (*sort_f32)(float * data, ptrdiff_t n);
+    void (*sort_f64)(double * data, ptrdiff_t n);
+};
+
+extern struct vvector_kernels_ vvector_kernels_;
+
+/**
+ * @internal
+ * @brief Copies of at least this many bytes bypass the cache in VVECTOR_COPY_AUTO mode.
+ *
+ * Set to the size of the last level cache at load time. @see vvectorSetStreamThreshold
+ */
+extern ptrdiff_t vvector_stream_threshold_;
+
+/**
+ * @internal
+ * @brief The instruction set 'vvector_kernels_' was resolved for.
+ */
+enum vvector_isa_ vvector_get_isa_(void);
+
+/* Kernel variants. Only call these through 'vvector_kernels_'. */
+
+ptrdiff_t vvector_find_u32_scalar_(const uint32_t * data, ptrdiff_t n, uint32_t value);
+ptrdiff_t vvector_find_u64_scalar_(const uint64_t * data, ptrdiff_t n, uint64_t value);
+void vvector_stream_copy_scalar_(void * dst, const void * src, ptrdiff_t n);
+void vvector_gather_u32_scalar_(const uint32_t * data, const ptrdiff_t * indices, ptrdiff_t n, uint32_t * out, ptrdiff_t distance);
+void vvector_gather_u64_scalar_(const uint64_t * data, const ptrdiff_t * indices, ptrdiff_t n, uint64_t * out, ptrdiff_t distance);
+void vvector_axpy_f32_scalar_(float a, const float * x, float * y, ptrdiff_t n);
+void vvector_axpy_f64_scalar_(double a, const double * x, double * y, ptrdiff_t n);
+void vvector_compare_i8_scalar_(const int8_t * x, const int8_t * y, int8_t a, int8_t b, int op, ptrdiff_t n, uint64_t * bitmap);
+void vvector_compare_i16_scalar_(const int16_t * x, const int16_t * y, int16_t a, int16_t b, int op, ptrdiff_t n, uint64_t * bitmap);
+void vvector_compare_i32_scalar_(const int32_t * x, const int32_t * y, int32_t a, int32_t b, int op, ptrdiff_t n, uint64_t * bitmap);
+void vvector_compare_i64_scalar_(const int64_t * x, const int64_t * y, int64_t a, int64_t b, int op, ptrdiff_t n, uint64_t * bitmap);
+void vvector_compare_f32_scalar_(const float * x, const float * y, float a, float b, int op, ptrdiff_t n, uint64_t * bitmap);
+void vvector_compare_f64_scalar_(const double * x, const double * y, double a, double b, int op, ptrdiff_t n, uint64_t * bitmap);
+ptrdiff_t vvector_compress_u32_scalar_(const uint32_t * x, const uint64_t * bitmap, ptrdiff_t n, uint32_t * out);
+ptrdiff_t vvector_compress_u64_scalar_(const uint64_t * x, const uint64_t * bitmap, ptrdiff_t n, uint64_t * out);
+void vvector_sort_i32_scalar_(int32_t * data, ptrdiff_t n);
+void vvector_sort_i64_scalar_(int64_t * data, ptrdiff_t n);
+void vvector_sort_f32_scalar_(float * data, ptrdiff_t n);
+void vvector_sort_f64_scalar_(double * data, ptrdiff_t n);
+
+#if VVECTOR_X86
+ptrdiff_t vvector_find_u32_avx2_(const uint32_t * data, ptrdiff_t n, uint32_t value);
+ptrdiff_t vvector_find_u64_avx2_(const uint64_t * data, ptrdiff_t n, uint64_t value);
+ptrdiff_t vvector_find_u32_avx512_(const uint32_t * data, ptrdiff_t n, uint32_t value);
+ptrdiff_t vvector_find_u64_avx512_(const uint64_t * data, ptrdiff_t n, uint64_t value);
+void vvector_stream_copy_sse2_(void * dst, const void * src, ptrdiff_t n);
+void vvector_stream_copy_avx2_(void * dst, const void * src, ptrdiff_t n);
+void vvector_stream_copy_avx512_(void * dst, const void * src, ptrdiff_t n);
+void vvector_gather_u32_avx2_(const uint32_t * data, const ptrdiff_t * indices, ptrdiff_t n, uint32_t * out, ptrdiff_t distance);
+void vvector_gather_u64_avx2_(const uint64_t * data, const ptrdiff_t * indices, ptrdiff_t n, uint64_t * out, ptrdiff_t distance);
+void vvector_axpy_f32_avx2_(float a, const float * x, float * y, ptrdiff_t n);
+void vvector_axpy_f64_avx2_(double a, const double * x, double * y, ptrdiff_t n);
+void vvector_compare_i8_avx2_(const int8_t * x, const int8_t * y, int8_t a, int8_t b, int op, ptrdiff_t n, uint64_t * bitmap);
+void vvector_compare_i16_avx2_(const int16_t * x, const int16_t * y, int16_t a, int16_t b, int op, ptrdiff_t n, uint64_t * bitmap);
+void vvector_compare_i32_avx2_(const int32_t * x, const int32_t * y, int32_t a, int32_t b, int op, ptrdiff_t n, uint64_t * bitmap);
+void vvector_compare_i64_avx2_(const int64_t * x, const int64_t * y, int64_t a, int64_t b, int op, ptrdiff_t n, uint64_t * bitmap);
+void vvector_compare_f32_avx2_(const float * x, const float * y, float a, float b, int op, ptrdiff_t n, uint64_t * bitmap);
+void vvector_compare_f64_avx2_(const double * x, const double * y, double a, double b, int op, ptrdiff_t n, uint64_t * bitmap);
+void vvector_sort_i32_avx2_(int32_t * data, ptrdiff_t n);
+void vvector_sort_i64_avx2_(int64_t * data, ptrdiff_t n);
+void vvector_sort_f32_avx2_(float * data, ptrdiff_t n);
+void vvector_sort_f64_avx2_(double * data, ptrdiff_t n);
+void vvector_axpy_f32_avx512_(float a, const float * x, float * y, ptrdiff_t n);
+void vvector_axpy_f64_avx512_(double a, const double * x, double * y, ptrdiff_t n);
+void vvector_compare_i8_avx512_(const int8_t * x, const int8_t * y, int8_t a, int8_t b, int op, ptrdiff_t n, uint64_t * bitmap);
+void vvector_compare_i16_avx512_(const int16_t * x, const int16_t * y, int16_t a, int16_t b, int op, ptrdiff_t n, uint64_t * bitmap);
+void vvector_compare_i32_avx512_(const int32_t * x, const int32_t * y, int32_t a, int32_t b, int op, ptrdiff_t n, uint64_t * bitmap);
+void vvector_compare_i64_avx512_(const int64_t * x, const int64_t * y, int64_t a, int64_t b, int op, ptrdiff_t n, uint64_t * bitmap);
+void vvector_compare_f32_avx512_(const float * x, const float * y, float a, float b, int op, ptrdiff_t n, uint64_t * bitmap);
+void vvector_compare_f64_avx512_(const double * x, const double * y, double a, double b, int op, ptrdiff_t n, uint64_t * bitmap);
+ptrdiff_t vvector_compress_u32_avx512_(const uint32_t * x, const uint64_t * bitmap, ptrdiff_t n, uint32_t * out);
+ptrdiff_t vvector_compress_u64_avx512_(const uint64_t * x, const uint64_t * bitmap, ptrdiff_t n, uint64_t * out);
+void vvector_sort_i32_avx512_(int32_t * data, ptrdiff_t n);
+void vvector_sort_i64_avx512_(int64_t * data, ptrdiff_t n);
+void vvector_sort_f32_avx512_(float * data, ptrdiff_t n);
+void vvector_sort_f64_avx512_(double * data, ptrdiff_t n);
+#endif
+
+#endif // VVECTOR_DISPATCH_H
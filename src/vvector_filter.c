@@ -0,0 +1,208 @@
+/*
+    Copyright 2024 I. Laurentiu
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "vvector_filter.h"
+#include "vvector_dispatch.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/// @file vvector_filter.c
+
+#define VEC_ENOVEC 1        /**< Indicates that a vector argument is NULL. */
+#define VEC_EBADINDEX 2     /**< Indicates that the type, the operator or the bitmap length is invalid. */
+#define VEC_ENOVALUE 3      /**< Indicates that a constant pointer is NULL. */
+#define VEC_EMISMATCH 4     /**< Indicates that the element sizes or lengths do not match. */
+
+#define SELECTION_CHUNK 256 /**< Indices are collected on the stack and appended in chunks. */
+
+/* Helpers */
+
+static ptrdiff_t type_size(enum vvectorScalarType type){
+    switch (type) {
+        case VVECTOR_INT8: return sizeof(int8_t);
+        case VVECTOR_INT16: return sizeof(int16_t);
+        case VVECTOR_INT32: return sizeof(int32_t);
+        case VVECTOR_INT64: return sizeof(int64_t);
+        case VVECTOR_FLOAT: return sizeof(float);
+        case VVECTOR_DOUBLE: return sizeof(double);
+        default: return 0;
+    }
+}
+
+/**
+ * @internal
+ * @brief Size 'bitmap' for 'n' bits and run the dispatched kernel. 'y' is NULL for comparisons against constants.
+ */
+static int compare(const void * x, const void * y, ptrdiff_t n, enum vvectorScalarType type, enum vvectorCompareOp op,
+                   const void * a, const void * b, vvector bitmap){
+    int err = vvectorResizeUninit(bitmap, (n + 63) / 64);
+    if (err) return err;
+
+    if (n == 0) return 0;
+
+    uint64_t * bits = vvectorGetFront(bitmap);
+
+    // Column comparisons pass no constants; the kernels ignore 'a' and 'b' when 'y' is set.
+    switch (type) {
+        case VVECTOR_INT8: {
+            int8_t ca = a ? *(const int8_t *) a : 0, cb = b ? *(const int8_t *) b : 0;
+            vvector_kernels_.compare_i8(x, y, ca, cb, op, n, bits);
+            break;
+        }
+        case VVECTOR_INT16: {
+            int16_t ca = a ? *(const int16_t *) a : 0, cb = b ? *(const int16_t *) b : 0;
+            vvector_kernels_.compare_i16(x, y, ca, cb, op, n, bits);
+            break;
+        }
+        case VVECTOR_INT32: {
+            int32_t ca = a ? *(const int32_t *) a : 0, cb = b ? *(const int32_t *) b : 0;
+            vvector_kernels_.compare_i32(x, y, ca, cb, op, n, bits);
+            break;
+        }
+        case VVECTOR_INT64: {
+            int64_t ca = a ? *(const int64_t *) a : 0, cb = b ? *(const int64_t *) b : 0;
+            vvector_kernels_.compare_i64(x, y, ca, cb, op, n, bits);
+            break;
+        }
+        case VVECTOR_FLOAT: {
+            float ca = a ? *(const float *) a : 0, cb = b ? *(const float *) b : 0;
+            vvector_kernels_.compare_f32(x, y, ca, cb, op, n, bits);
+            break;
+        }
+        case VVECTOR_DOUBLE: {
+            double ca = a ? *(const double *) a : 0, cb = b ? *(const double *) b : 0;
+            vvector_kernels_.compare_f64(x, y, ca, cb, op, n, bits);
+            break;
+        }
+    }
+
+    return 0;
+}
+
+/* Comparisons */
+
+int vvectorCompare(vvector vec, enum vvectorScalarType type, enum vvectorCompareOp op, const void * a, const void * b, vvector bitmap){
+    if (!vec || !*vec || !bitmap || !*bitmap) return VEC_ENOVEC;
+
+    ptrdiff_t size = type_size(type);
+    if (size == 0 || op < VVECTOR_EQ || op > VVECTOR_BETWEEN) return VEC_EBADINDEX;
+
+    if (!a || (op == VVECTOR_BETWEEN && !b)) return VEC_ENOVALUE;
+
+    if (vvectorGetElementSize(vec) != size || vvectorGetElementSize(bitmap) != sizeof(uint64_t)) return VEC_EMISMATCH;
+
+    return compare(vvectorGetFront(vec), 0, vvectorGetLength(vec), type, op, a, b, bitmap);
+}
+
+int vvectorCompareColumns(vvector left, vvector right, enum vvectorScalarType type, enum vvectorCompareOp op, vvector bitmap){
+    if (!left || !*left || !right || !*right || !bitmap || !*bitmap) return VEC_ENOVEC;
+
+    ptrdiff_t size = type_size(type);
+    if (size == 0 || op < VVECTOR_EQ || op >= VVECTOR_BETWEEN) return VEC_EBADINDEX;
+
+    ptrdiff_t n = vvectorGetLength(left);
+
+    if (vvectorGetElementSize(left) != size || vvectorGetElementSize(right) != size || vvectorGetLength(right) != n ||
+        vvectorGetElementSize(bitmap) != sizeof(uint64_t)) return VEC_EMISMATCH;
+
+    return compare(vvectorGetFront(left), vvectorGetFront(right), n, type, op, 0, 0, bitmap);
+}
+
+/* Selections */
+
+int vvectorBitmapToSelection(vvector bitmap, vvector selection){
+    if (!bitmap || !*bitmap || !selection || !*selection) return VEC_ENOVEC;
+
+    if (vvectorGetElementSize(bitmap) != sizeof(uint64_t) || vvectorGetElementSize(selection) != sizeof(ptrdiff_t)) return VEC_EMISMATCH;
+
+    const uint64_t * bits = vvectorGetFront(bitmap);
+    ptrdiff_t nr_words = vvectorGetLength(bitmap);
+    ptrdiff_t chunk[SELECTION_CHUNK];
+    int count = 0;
+
+    for (ptrdiff_t w = 0; w < nr_words; w++) {
+        uint64_t word = bits[w];
+
+        while (word) {
+            chunk[count++] = w * 64 + __builtin_ctzll(word);
+            word &= word - 1;
+
+            if (count == SELECTION_CHUNK) {
+                int err = vvectorAppend(selection, chunk, count, VVECTOR_COPY_AUTO);
+                if (err) return err;
+                count = 0;
+            }
+        }
+    }
+
+    if (count > 0) return vvectorAppend(selection, chunk, count, VVECTOR_COPY_AUTO);
+
+    return 0;
+}
+
+int vvectorCompress(vvector vec, vvector bitmap, vvector out){
+    if (!vec || !*vec || !bitmap || !*bitmap || !out || !*out) return VEC_ENOVEC;
+
+    if (vec == out) return VEC_EBADINDEX;
+
+    ptrdiff_t size = vvectorGetElementSize(vec);
+    ptrdiff_t n = vvectorGetLength(vec);
+
+    if (vvectorGetElementSize(out) != size || vvectorGetElementSize(bitmap) != sizeof(uint64_t)) return VEC_EMISMATCH;
+
+    if (vvectorGetLength(bitmap) * 64 < n) return VEC_EBADINDEX;
+
+    if (n == 0) return 0;
+
+    const uint64_t * bits = vvectorGetFront(bitmap);
+    ptrdiff_t nr_selected = 0;
+
+    for (ptrdiff_t w = 0; w * 64 < n; w++) {
+        uint64_t word = bits[w];
+        if (n - w * 64 < 64) word &= ((uint64_t) 1 << (n - w * 64)) - 1;
+        nr_selected += __builtin_popcountll(word);
+    }
+
+    if (nr_selected == 0) return 0;
+
+    // Grow 'out' once, then write the selected elements straight past its old end.
+    ptrdiff_t old_length = vvectorGetLength(out);
+
+    int err = vvectorResizeUninit(out, old_length + nr_selected);
+    if (err) return err;
+
+    const uint8_t * src = vvectorGetFront(vec);
+    uint8_t * dst = vvectorGetAt(out, old_length);
+
+    if (size == sizeof(uint32_t)) {
+        vvector_kernels_.compress_u32((const uint32_t *) src, bits, n, (uint32_t *) dst);
+    } else if (size == sizeof(uint64_t)) {
+        vvector_kernels_.compress_u64((const uint64_t *) src, bits, n, (uint64_t *) dst);
+    } else {
+        for (ptrdiff_t w = 0; w * 64 < n; w++) {
+            uint64_t word = bits[w];
+            if (n - w * 64 < 64) word &= ((uint64_t) 1 << (n - w * 64)) - 1;
+
+            while (word) {
+                memcpy(dst, src + (w * 64 + __builtin_ctzll(word)) * size, size);
+                dst += size;
+                word &= word - 1;
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,121 @@
+/*
+    Copyright 2024 I. Laurentiu
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef VVECTOR_FILTER_H
+#define VVECTOR_FILTER_H
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+#include "vvector.h"
+
+#include <stddef.h>
+
+/// @file vvector_filter.h
+
+/*
+ * Filtering a column (a vvector of numbers) is done in two steps:
+ *
+ *      1. A comparison produces a bitmap: a vvector of uint64_t with bit 'i % 64' of word 'i / 64' set if element 'i' matched.
+ *      2. The bitmap is turned into a selection vector of indices ('vvectorBitmapToSelection'), which can be passed to
+ *         'vvectorGather', or the matching elements are copied out directly ('vvectorCompress').
+ *
+ * Bitmaps from several predicates can be combined word by word with & and |.
+ *
+ * @code
+ * vvector bitmap = vvectorNew(uint64_t, 0);
+ * int32_t low = 18, high = 65;
+ * vvectorCompare(ages, VVECTOR_INT32, VVECTOR_BETWEEN, &low, &high, bitmap);
+ *
+ * vvector adults = vvectorNew(int32_t, 0);
+ * vvectorCompress(ages, bitmap, adults);
+ * @endcode
+ */
+
+/**
+ * @brief Element types comparisons work on.
+ */
+enum vvectorScalarType {
+    VVECTOR_INT8 = 0,
+    VVECTOR_INT16,
+    VVECTOR_INT32,
+    VVECTOR_INT64,
+    VVECTOR_FLOAT,
+    VVECTOR_DOUBLE,
+};
+
+/**
+ * @brief Comparison operators. They follow C semantics, e.g. NaN only matches VVECTOR_NE.
+ */
+enum vvectorCompareOp {
+    VVECTOR_EQ = 0,     /**< x == a */
+    VVECTOR_NE,         /**< x != a */
+    VVECTOR_LT,         /**< x < a */
+    VVECTOR_LE,         /**< x <= a */
+    VVECTOR_GT,         /**< x > a */
+    VVECTOR_GE,         /**< x >= a */
+    VVECTOR_BETWEEN,    /**< a <= x && x <= b. Only for comparisons against constants. */
+};
+
+/**
+ * @brief Compare every element of 'vec' with one or two constants.
+ *
+ * @param   vec     vvector of 'type' elements.
+ * @param   type    Element type. Its size must match the element size of 'vec'.
+ * @param   op      Comparison. @see vvectorCompareOp
+ * @param   a       Pointer to the constant, of 'type'.
+ * @param   b       Pointer to the upper bound for VVECTOR_BETWEEN, of 'type'. Ignored otherwise.
+ * @param   bitmap  vvector of uint64_t, resized to hold one bit per element of 'vec'. Unused bits of the last word are 0.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorCompare(vvector vec, enum vvectorScalarType type, enum vvectorCompareOp op, const void * a, const void * b, vvector bitmap);
+
+/**
+ * @brief Compare two vvectors element by element: left[i] op right[i].
+ *
+ * @param   left    vvector of 'type' elements.
+ * @param   right   vvector of 'type' elements, as long as 'left'.
+ * @param   type    Element type.
+ * @param   op      Comparison, anything but VVECTOR_BETWEEN.
+ * @param   bitmap  vvector of uint64_t, resized to hold one bit per element.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorCompareColumns(vvector left, vvector right, enum vvectorScalarType type, enum vvectorCompareOp op, vvector bitmap);
+
+/**
+ * @brief Append the index of every set bit, in increasing order, to a vvector of ptrdiff_t.
+ *
+ * @param   bitmap      vvector of uint64_t.
+ * @param   selection   vvector of ptrdiff_t which receives the indices.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorBitmapToSelection(vvector bitmap, vvector selection);
+
+/**
+ * @brief Append every element of 'vec' whose bit is set in 'bitmap' to 'out' (compress-store).
+ *
+ * @param   vec     Source vvector, of any element size.
+ * @param   bitmap  vvector of uint64_t with at least one bit per element of 'vec'.
+ * @param   out     vvector with the element size of 'vec'. Must not be 'vec'.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorCompress(vvector vec, vvector bitmap, vvector out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VVECTOR_FILTER_H
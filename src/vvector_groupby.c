@@ -0,0 +1,631 @@
+/*
+    Copyright 2024 I. Laurentiu
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+// pthread_*
+#define _POSIX_C_SOURCE 200809L
+
+#include "vvector_groupby.h"
+#include <math.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+/// @file vvector_groupby.c
+
+#define VEC_ENOVEC 1        /**< Indicates that the table or a vector argument is NULL. */
+#define VEC_EBADINDEX 2     /**< Indicates that the range or a type is invalid. */
+#define VEC_EMISMATCH 4     /**< Indicates that a vector does not hold the expected type or is too short. */
+
+#define BUCKET_SLOTS 16     /**< Slots per bucket: one SSE2 register of tags. */
+#define MIN_BUCKETS 4
+#define BATCH 256           /**< Rows hashed and prefetched ahead of probing. */
+#define MIN_ROWS_PER_THREAD 65536
+
+/**
+ * @internal
+ * @struct groupby_group_
+ * @brief One group's key and aggregates.
+ */
+struct groupby_group_ {
+    int64_t key;
+    int64_t count;
+    double sum;
+    double min;
+    double max;
+};
+
+struct vvectorGroupBy {
+    vvector tags;           /**< uint8_t per slot: 0 if empty, else 1 + the top 7 bits of the key's hash. */
+    vvector slots;          /**< uint32_t per slot: index of the slot's group. */
+    vvector groups;         /**< struct groupby_group_, in the order they were first seen. */
+    ptrdiff_t bucket_mask;  /**< Number of buckets - 1, a power of two. */
+
+    struct vvectorAlloc alloc;  /**< Used for this struct. Missing functions fall back to the C library. */
+};
+
+/* Helpers */
+
+static void * groupby_malloc(struct vvectorAlloc * alloc, ptrdiff_t size){
+    if (alloc && alloc->malloc_fn) return alloc->malloc_fn(size, alloc->ctx);
+
+    return malloc(size);
+}
+
+static void groupby_free(struct vvectorAlloc * alloc, void * ptr, ptrdiff_t size){
+    if (alloc && alloc->free_fn) {
+        alloc->free_fn(ptr, size, alloc->ctx);
+        return;
+    }
+
+    free(ptr);
+}
+
+// Finalizer of MurmurHash3: every key bit affects the low bits (bucket), the middle bits (tag) and the top bits (partition).
+static inline uint64_t hash_key(int64_t key){
+    uint64_t h = (uint64_t) key;
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+
+    return h;
+}
+
+/*
+ * The tag takes 7 bits which neither the bucket (low bits) nor the parallel partition (top bits) uses:
+ * all keys of a partition share its top bits, which would make tags taken from there match each other.
+ */
+static inline uint8_t hash_tag(uint64_t hash){
+    return (uint8_t) (((hash >> 32) & 0x7f) + 1);
+}
+
+/**
+ * @internal
+ * @brief Bit 'i' of the result is set if tags[i] == tag, for the 16 tags of a bucket.
+ */
+static inline unsigned match_tags(const uint8_t * tags, uint8_t tag){
+#if defined(__SSE2__)
+    __m128i bucket = _mm_loadu_si128((const __m128i *) tags);
+
+    return (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(bucket, _mm_set1_epi8((char) tag)));
+#else
+    unsigned mask = 0;
+
+    for (int i = 0; i < BUCKET_SLOTS; i++) mask |= (unsigned) (tags[i] == tag) << i;
+
+    return mask;
+#endif
+}
+
+static int key_type_ok(vvector vec, enum vvectorScalarType type){
+    static const ptrdiff_t sizes[] = {sizeof(int8_t), sizeof(int16_t), sizeof(int32_t), sizeof(int64_t)};
+
+    if (type < VVECTOR_INT8 || type > VVECTOR_INT64) return VEC_EBADINDEX;
+
+    return (vvectorGetElementSize(vec) == sizes[type]) ? 0 : VEC_EMISMATCH;
+}
+
+static int value_type_ok(vvector vec, enum vvectorScalarType type){
+    static const ptrdiff_t sizes[] = {sizeof(int8_t), sizeof(int16_t), sizeof(int32_t), sizeof(int64_t), sizeof(float), sizeof(double)};
+
+    if (type < VVECTOR_INT8 || type > VVECTOR_DOUBLE) return VEC_EBADINDEX;
+
+    return (vvectorGetElementSize(vec) == sizes[type]) ? 0 : VEC_EMISMATCH;
+}
+
+// Widen 'count' keys starting at 'first'. The switch is outside the loops so each one vectorizes.
+static void load_keys(const void * src, enum vvectorScalarType type, ptrdiff_t first, int count, int64_t * out){
+    switch (type) {
+        case VVECTOR_INT8: for (int i = 0; i < count; i++) out[i] = ((const int8_t *) src)[first + i]; break;
+        case VVECTOR_INT16: for (int i = 0; i < count; i++) out[i] = ((const int16_t *) src)[first + i]; break;
+        case VVECTOR_INT32: for (int i = 0; i < count; i++) out[i] = ((const int32_t *) src)[first + i]; break;
+        default: memcpy(out, (const int64_t *) src + first, count * sizeof(int64_t)); break;
+    }
+}
+
+static void load_values(const void * src, enum vvectorScalarType type, ptrdiff_t first, int count, double * out){
+    switch (type) {
+        case VVECTOR_INT8: for (int i = 0; i < count; i++) out[i] = ((const int8_t *) src)[first + i]; break;
+        case VVECTOR_INT16: for (int i = 0; i < count; i++) out[i] = ((const int16_t *) src)[first + i]; break;
+        case VVECTOR_INT32: for (int i = 0; i < count; i++) out[i] = ((const int32_t *) src)[first + i]; break;
+        case VVECTOR_INT64: for (int i = 0; i < count; i++) out[i] = (double) ((const int64_t *) src)[first + i]; break;
+        case VVECTOR_FLOAT: for (int i = 0; i < count; i++) out[i] = ((const float *) src)[first + i]; break;
+        default: memcpy(out, (const double *) src + first, count * sizeof(double)); break;
+    }
+}
+
+static int ensure_capacity(vvector vec, ptrdiff_t count){
+    ptrdiff_t capacity = vvectorGetCapacity(vec);
+
+    return (capacity < count) ? vvectorReserve(vec, count - capacity) : 0;
+}
+
+/* Table */
+
+static int table_rebuild(struct vvectorGroupBy * groupby, ptrdiff_t nr_buckets){
+    ptrdiff_t nr_slots = nr_buckets * BUCKET_SLOTS;
+
+    int err = vvectorResizeUninit(groupby->slots, nr_slots);
+    if (err) return err;
+
+    err = vvectorResizeZeroed(groupby->tags, 0);
+    if (!err) err = vvectorResizeZeroed(groupby->tags, nr_slots);
+    if (err) return err;
+
+    // Groups are never removed, so the table holds up to 7/8 of its slots in groups.
+    err = ensure_capacity(groupby->groups, nr_slots / 8 * 7);
+    if (err) return err;
+
+    groupby->bucket_mask = nr_buckets - 1;
+
+    uint8_t * tags = vvectorGetFront(groupby->tags);
+    uint32_t * slots = vvectorGetFront(groupby->slots);
+    const struct groupby_group_ * groups = vvectorGetFront(groupby->groups);
+    ptrdiff_t nr_groups = vvectorGetLength(groupby->groups);
+
+    for (ptrdiff_t g = 0; g < nr_groups; g++) {
+        uint64_t hash = hash_key(groups[g].key);
+        ptrdiff_t bucket = (ptrdiff_t) hash & groupby->bucket_mask;
+        unsigned empty;
+
+        while (!(empty = match_tags(&tags[bucket * BUCKET_SLOTS], 0))) bucket = (bucket + 1) & groupby->bucket_mask;
+
+        ptrdiff_t slot = bucket * BUCKET_SLOTS + __builtin_ctz(empty);
+        tags[slot] = hash_tag(hash);
+        slots[slot] = (uint32_t) g;
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Make room for 'count' more groups, so inserts never grow the table in the middle of a batch.
+ */
+static int table_reserve(struct vvectorGroupBy * groupby, ptrdiff_t count){
+    ptrdiff_t needed = vvectorGetLength(groupby->groups) + count;
+
+    if (needed > UINT32_MAX) return VEC_EBADINDEX;
+
+    ptrdiff_t nr_buckets = groupby->bucket_mask + 1;
+    if (needed <= nr_buckets * BUCKET_SLOTS / 8 * 7) return 0;
+
+    while (needed > nr_buckets * BUCKET_SLOTS / 8 * 7) nr_buckets *= 2;
+
+    return table_rebuild(groupby, nr_buckets);
+}
+
+/**
+ * @internal
+ * @brief Find the group of 'key', adding an empty one if there is none. The table must have room (@see table_reserve).
+ */
+static inline struct groupby_group_ * table_find_or_insert(struct vvectorGroupBy * groupby, int64_t key, uint64_t hash){
+    uint8_t * tags = vvectorGetFront(groupby->tags);
+    uint8_t tag = hash_tag(hash);
+    ptrdiff_t bucket = (ptrdiff_t) hash & groupby->bucket_mask;
+
+    for (;;) {
+        uint8_t * bucket_tags = &tags[bucket * BUCKET_SLOTS];
+        const uint32_t * slots = (const uint32_t *) vvectorGetFront(groupby->slots) + bucket * BUCKET_SLOTS;
+        struct groupby_group_ * groups = vvectorGetFront(groupby->groups);
+
+        for (unsigned match = match_tags(bucket_tags, tag); match; match &= match - 1) {
+            struct groupby_group_ * group = &groups[slots[__builtin_ctz(match)]];
+            if (group->key == key) return group;
+        }
+
+        // No deletions: an empty slot means the key is not further along.
+        unsigned empty = match_tags(bucket_tags, 0);
+
+        if (empty) {
+            ptrdiff_t slot = __builtin_ctz(empty);
+            ptrdiff_t index = vvectorGetLength(groupby->groups);
+
+            struct groupby_group_ group;
+            group.key = key;
+            group.count = 0;
+            group.sum = 0;
+            group.min = INFINITY;
+            group.max = -INFINITY;
+
+            // Capacity was reserved, this never reallocates.
+            vvectorPushBack(groupby->groups, &group);
+
+            bucket_tags[slot] = tag;
+            ((uint32_t *) vvectorGetFront(groupby->slots))[bucket * BUCKET_SLOTS + slot] = (uint32_t) index;
+
+            return (struct groupby_group_ *) vvectorGetFront(groupby->groups) + index;
+        }
+
+        bucket = (bucket + 1) & groupby->bucket_mask;
+    }
+}
+
+static inline void prefetch_bucket(struct vvectorGroupBy * groupby, uint64_t hash){
+    ptrdiff_t bucket = (ptrdiff_t) hash & groupby->bucket_mask;
+
+    __builtin_prefetch((const uint8_t *) vvectorGetFront(groupby->tags) + bucket * BUCKET_SLOTS);
+    __builtin_prefetch((const uint32_t *) vvectorGetFront(groupby->slots) + bucket * BUCKET_SLOTS);
+}
+
+/**
+ * @internal
+ * @brief Aggregate rows [first, last) of raw key and value arrays. 'values' may be NULL.
+ */
+static int consume_rows(struct vvectorGroupBy * groupby, const void * keys, enum vvectorScalarType key_type,
+                        const void * values, enum vvectorScalarType value_type, ptrdiff_t first, ptrdiff_t last){
+    int64_t batch_keys[BATCH];
+    double batch_values[BATCH];
+    uint64_t hashes[BATCH];
+
+    for (ptrdiff_t start = first; start < last; start += BATCH) {
+        int count = (last - start < BATCH) ? (int) (last - start) : BATCH;
+
+        int err = table_reserve(groupby, count);
+        if (err) return err;
+
+        load_keys(keys, key_type, start, count, batch_keys);
+        if (values) load_values(values, value_type, start, count, batch_values);
+
+        // Hash the whole batch and start loading its buckets, then probe them.
+        for (int i = 0; i < count; i++) {
+            hashes[i] = hash_key(batch_keys[i]);
+            prefetch_bucket(groupby, hashes[i]);
+        }
+
+        if (values) {
+            for (int i = 0; i < count; i++) {
+                struct groupby_group_ * group = table_find_or_insert(groupby, batch_keys[i], hashes[i]);
+                double value = batch_values[i];
+
+                group->count++;
+                group->sum += value;
+                if (value < group->min) group->min = value;
+                if (value > group->max) group->max = value;
+            }
+        } else {
+            for (int i = 0; i < count; i++) table_find_or_insert(groupby, batch_keys[i], hashes[i])->count++;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Combine already aggregated groups into the table.
+ */
+static int merge_groups(struct vvectorGroupBy * groupby, const struct groupby_group_ * groups, ptrdiff_t n){
+    int err = table_reserve(groupby, n);
+    if (err) return err;
+
+    for (ptrdiff_t i = 0; i < n; i++) {
+        struct groupby_group_ * group = table_find_or_insert(groupby, groups[i].key, hash_key(groups[i].key));
+
+        group->count += groups[i].count;
+        group->sum += groups[i].sum;
+        if (groups[i].min < group->min) group->min = groups[i].min;
+        if (groups[i].max > group->max) group->max = groups[i].max;
+    }
+
+    return 0;
+}
+
+/* Create and destroy */
+
+struct vvectorGroupBy * vvectorGroupByNew(ptrdiff_t expected_groups, struct vvectorAlloc * allocator){
+    if (expected_groups < 0) return 0;
+
+    struct vvectorGroupBy * groupby = groupby_malloc(allocator, sizeof(struct vvectorGroupBy));
+    if (!groupby) return 0;
+
+    memset(groupby, 0, sizeof(struct vvectorGroupBy));
+    if (allocator) groupby->alloc = *allocator;
+
+    groupby->tags = vec_new_(sizeof(uint8_t), allocator);
+    groupby->slots = vec_new_(sizeof(uint32_t), allocator);
+    groupby->groups = vec_new_(sizeof(struct groupby_group_), allocator);
+
+    ptrdiff_t nr_buckets = MIN_BUCKETS;
+    while (expected_groups > nr_buckets * BUCKET_SLOTS / 8 * 7) nr_buckets *= 2;
+
+    if (!groupby->tags || !groupby->slots || !groupby->groups || table_rebuild(groupby, nr_buckets)) {
+        vvectorGroupByFree(groupby);
+        return 0;
+    }
+
+    return groupby;
+}
+
+int vvectorGroupByFree(struct vvectorGroupBy * groupby){
+    if (!groupby) return VEC_ENOVEC;
+
+    if (groupby->tags) vvectorFree(groupby->tags);
+    if (groupby->slots) vvectorFree(groupby->slots);
+    if (groupby->groups) vvectorFree(groupby->groups);
+
+    struct vvectorAlloc alloc = groupby->alloc;
+    groupby_free(&alloc, groupby, sizeof(struct vvectorGroupBy));
+
+    return 0;
+}
+
+int vvectorGroupByClear(struct vvectorGroupBy * groupby){
+    if (!groupby) return VEC_ENOVEC;
+
+    vvectorClear(groupby->groups);
+    memset(vvectorGetFront(groupby->tags), 0, vvectorGetLength(groupby->tags));
+
+    return 0;
+}
+
+/* Aggregation */
+
+int vvectorGroupByConsume(struct vvectorGroupBy * groupby, vvector keys, enum vvectorScalarType key_type,
+                          vvector values, enum vvectorScalarType value_type, ptrdiff_t first, ptrdiff_t last){
+    if (!groupby || !keys || !*keys || (values && !*values)) return VEC_ENOVEC;
+
+    int err = key_type_ok(keys, key_type);
+    if (!err && values) err = value_type_ok(values, value_type);
+    if (err) return err;
+
+    if (first < 0 || first > last || last > vvectorGetLength(keys)) return VEC_EBADINDEX;
+
+    if (values && vvectorGetLength(values) < last) return VEC_EMISMATCH;
+
+    if (first == last) return 0;
+
+    return consume_rows(groupby, vvectorGetFront(keys), key_type, values ? vvectorGetFront(values) : 0, value_type, first, last);
+}
+
+ptrdiff_t vvectorGroupByGetNrGroups(struct vvectorGroupBy * groupby){
+    if (!groupby) return 0;
+
+    return vvectorGetLength(groupby->groups);
+}
+
+/**
+ * @internal
+ * @brief Append 'n' groups to the output vvectors of 'vvectorGroupByEmit'. Sizes are checked by the caller.
+ */
+static int emit_groups(const struct groupby_group_ * groups, ptrdiff_t n, vvector keys, vvector counts, vvector sums, vvector mins, vvector maxs){
+    vvector outputs[5] = {keys, counts, sums, mins, maxs};
+    ptrdiff_t offsets[5] = {offsetof(struct groupby_group_, key), offsetof(struct groupby_group_, count),
+                            offsetof(struct groupby_group_, sum), offsetof(struct groupby_group_, min), offsetof(struct groupby_group_, max)};
+
+    if (n == 0) return 0;
+
+    // Every field is 8 bytes: copy one column at a time, out of the array of structs.
+    for (int k = 0; k < 5; k++) {
+        if (!outputs[k]) continue;
+
+        ptrdiff_t old_length = vvectorGetLength(outputs[k]);
+
+        int err = vvectorResizeUninit(outputs[k], old_length + n);
+        if (err) return err;
+
+        uint8_t * out = vvectorGetAt(outputs[k], old_length);
+        const uint8_t * src = (const uint8_t *) groups + offsets[k];
+
+        for (ptrdiff_t i = 0; i < n; i++) memcpy(out + i * 8, src + i * sizeof(struct groupby_group_), 8);
+    }
+
+    return 0;
+}
+
+static int outputs_ok(vvector keys, vvector counts, vvector sums, vvector mins, vvector maxs){
+    vvector outputs[5] = {keys, counts, sums, mins, maxs};
+
+    for (int k = 0; k < 5; k++) {
+        if (outputs[k] && !*outputs[k]) return VEC_ENOVEC;
+        if (outputs[k] && vvectorGetElementSize(outputs[k]) != 8) return VEC_EMISMATCH;
+    }
+
+    return 0;
+}
+
+int vvectorGroupByEmit(struct vvectorGroupBy * groupby, vvector keys, vvector counts, vvector sums, vvector mins, vvector maxs){
+    if (!groupby) return VEC_ENOVEC;
+
+    int err = outputs_ok(keys, counts, sums, mins, maxs);
+    if (err) return err;
+
+    return emit_groups(vvectorGetFront(groupby->groups), vvectorGetLength(groupby->groups), keys, counts, sums, mins, maxs);
+}
+
+// << PARALLEL >>
+
+/**
+ * @internal
+ * @struct groupby_task_
+ * @brief One thread's rows, its local table, and the partitions it merges in 'vvectorGroupByParallel'.
+ */
+struct groupby_task_ {
+    const void * keys;
+    enum vvectorScalarType key_type;
+    const void * values;
+    enum vvectorScalarType value_type;
+    ptrdiff_t first;
+    ptrdiff_t last;
+
+    struct vvectorGroupBy * local;      /**< Groups of rows [first, last). */
+    vvector partitioned;                /**< The local groups, reordered by partition. */
+    ptrdiff_t * partition_offsets;      /**< nr_partitions + 1 offsets into 'partitioned'. */
+    struct vvectorGroupBy * merged;     /**< Groups of this thread's partitions, over every thread's rows. */
+
+    struct groupby_task_ * all;
+    int nr_tasks;
+    int nr_partitions;
+    int partition_shift;
+    int err;
+    pthread_t thread;
+    int started;
+};
+
+static void * groupby_aggregate(void * arg){
+    struct groupby_task_ * task = arg;
+
+    task->err = consume_rows(task->local, task->keys, task->key_type, task->values, task->value_type, task->first, task->last);
+    if (task->err) return 0;
+
+    // Counting sort of the local groups by the top bits of their hashes.
+    const struct groupby_group_ * groups = vvectorGetFront(task->local->groups);
+    ptrdiff_t nr_groups = vvectorGetLength(task->local->groups);
+    ptrdiff_t * offsets = task->partition_offsets;
+
+    task->err = vvectorResizeUninit(task->partitioned, nr_groups);
+    if (task->err || nr_groups == 0) return 0;
+
+    struct groupby_group_ * out = vvectorGetFront(task->partitioned);
+
+    for (ptrdiff_t g = 0; g < nr_groups; g++) offsets[(hash_key(groups[g].key) >> task->partition_shift) + 1]++;
+    for (int p = 0; p < task->nr_partitions; p++) offsets[p + 1] += offsets[p];
+
+    for (ptrdiff_t g = 0; g < nr_groups; g++) {
+        out[offsets[hash_key(groups[g].key) >> task->partition_shift]++] = groups[g];
+    }
+
+    // Scattering advanced each offset to the start of the next partition; shift them back.
+    for (int p = task->nr_partitions; p > 0; p--) offsets[p] = offsets[p - 1];
+    offsets[0] = 0;
+
+    return 0;
+}
+
+static void * groupby_merge(void * arg){
+    struct groupby_task_ * task = arg;
+    int me = (int) (task - task->all);
+
+    // Partition 'p' is merged by thread 'p % nr_tasks'; its groups are in every thread's 'partitioned'.
+    for (int p = me; p < task->nr_partitions; p += task->nr_tasks) {
+        for (int t = 0; t < task->nr_tasks; t++) {
+            const struct groupby_task_ * source = &task->all[t];
+            ptrdiff_t begin = source->partition_offsets[p];
+            ptrdiff_t end = source->partition_offsets[p + 1];
+
+            if (begin == end) continue;
+
+            task->err = merge_groups(task->merged, (const struct groupby_group_ *) vvectorGetFront(source->partitioned) + begin, end - begin);
+            if (task->err) return 0;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Run 'fn' on every task, tasks[0] on the calling thread. Falls back to the calling thread if a thread can't be started.
+ */
+static void run_tasks(void * (*fn)(void *), struct groupby_task_ * tasks, int nr_tasks){
+    for (int t = 1; t < nr_tasks; t++) {
+        tasks[t].started = (pthread_create(&tasks[t].thread, 0, fn, &tasks[t]) == 0);
+        if (!tasks[t].started) fn(&tasks[t]);
+    }
+
+    fn(&tasks[0]);
+
+    for (int t = 1; t < nr_tasks; t++) {
+        if (tasks[t].started) pthread_join(tasks[t].thread, 0);
+    }
+}
+
+int vvectorGroupByParallel(vvector keys, enum vvectorScalarType key_type, vvector values, enum vvectorScalarType value_type, int nr_threads,
+                           vvector out_keys, vvector counts, vvector sums, vvector mins, vvector maxs, struct vvectorAlloc * allocator){
+    if (!keys || !*keys || (values && !*values)) return VEC_ENOVEC;
+
+    int err = key_type_ok(keys, key_type);
+    if (!err && values) err = value_type_ok(values, value_type);
+    if (!err) err = outputs_ok(out_keys, counts, sums, mins, maxs);
+    if (err) return err;
+
+    ptrdiff_t n = vvectorGetLength(keys);
+
+    if (values && vvectorGetLength(values) < n) return VEC_EMISMATCH;
+
+    if (nr_threads < 1) nr_threads = 1;
+    if (nr_threads > 1 && n / nr_threads < MIN_ROWS_PER_THREAD) nr_threads = (int) (n / MIN_ROWS_PER_THREAD);
+    if (nr_threads < 1) nr_threads = 1;
+
+    // A power of two number of partitions, a few per thread so uneven partitions even out.
+    int nr_partitions = 1;
+    int partition_bits = 0;
+    while (nr_partitions < 4 * nr_threads) {
+        nr_partitions *= 2;
+        partition_bits++;
+    }
+
+    // Scratch: the tasks, followed by nr_partitions + 1 offsets per thread.
+    ptrdiff_t scratch_size = nr_threads * ((ptrdiff_t) sizeof(struct groupby_task_) + (nr_partitions + 1) * (ptrdiff_t) sizeof(ptrdiff_t));
+    uint8_t * scratch = groupby_malloc(allocator, scratch_size);
+    if (!scratch) return VEC_ENOVEC;
+
+    memset(scratch, 0, scratch_size);
+
+    struct groupby_task_ * tasks = (struct groupby_task_ *) scratch;
+    ptrdiff_t * offsets = (ptrdiff_t *) (scratch + nr_threads * sizeof(struct groupby_task_));
+
+    for (int t = 0; t < nr_threads; t++) {
+        tasks[t].keys = vvectorGetFront(keys);
+        tasks[t].key_type = key_type;
+        tasks[t].values = values ? vvectorGetFront(values) : 0;
+        tasks[t].value_type = value_type;
+        tasks[t].first = n * t / nr_threads;
+        tasks[t].last = n * (t + 1) / nr_threads;
+        tasks[t].partition_offsets = &offsets[t * (nr_partitions + 1)];
+        tasks[t].all = tasks;
+        tasks[t].nr_tasks = nr_threads;
+        tasks[t].nr_partitions = nr_partitions;
+        tasks[t].partition_shift = 64 - partition_bits;
+        tasks[t].local = vvectorGroupByNew(0, allocator);
+        tasks[t].merged = vvectorGroupByNew(0, allocator);
+        tasks[t].partitioned = vec_new_(sizeof(struct groupby_group_), allocator);
+
+        if (!tasks[t].local || !tasks[t].merged || !tasks[t].partitioned) err = VEC_ENOVEC;
+    }
+
+    if (!err) {
+        run_tasks(groupby_aggregate, tasks, nr_threads);
+        for (int t = 0; t < nr_threads; t++) err = err ? err : tasks[t].err;
+    }
+
+    if (!err) {
+        run_tasks(groupby_merge, tasks, nr_threads);
+        for (int t = 0; t < nr_threads; t++) err = err ? err : tasks[t].err;
+    }
+
+    for (int t = 0; t < nr_threads && !err; t++) {
+        struct vvectorGroupBy * merged = tasks[t].merged;
+        err = emit_groups(vvectorGetFront(merged->groups), vvectorGetLength(merged->groups), out_keys, counts, sums, mins, maxs);
+    }
+
+    for (int t = 0; t < nr_threads; t++) {
+        if (tasks[t].local) vvectorGroupByFree(tasks[t].local);
+        if (tasks[t].merged) vvectorGroupByFree(tasks[t].merged);
+        if (tasks[t].partitioned) vvectorFree(tasks[t].partitioned);
+    }
+
+    groupby_free(allocator, scratch, scratch_size);
+
+    return err;
+}
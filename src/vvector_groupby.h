@@ -0,0 +1,143 @@
+/*
+    Copyright 2024 I. Laurentiu
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef VVECTOR_GROUPBY_H
+#define VVECTOR_GROUPBY_H
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+#include "vvector.h"
+#include "vvector_filter.h"
+
+#include <stddef.h>
+
+/// @file vvector_groupby.h
+
+/**
+ * @struct vvectorGroupBy
+ *
+ * @brief   Count, sum, min and max of a value column per distinct key of a key column.
+ *
+ * Keys are integers (VVECTOR_INT8 to VVECTOR_INT64), values any vvectorScalarType; sums, minimums and maximums are kept as double.
+ * Groups live in a dense array, found through an open addressing table of 16 slot buckets. Each slot has a one byte tag
+ * taken from the key's hash, and a bucket's 16 tags are compared at once with SSE2, so most lookups touch one cache line
+ * of tags and one group. Keys are consumed in batches whose buckets are prefetched before they are probed.
+ *
+ * Spans of the key and value columns can be consumed in any number of calls; results are emitted in the order groups were first seen.
+ *
+ * @code
+ * struct vvectorGroupBy * by_user = vvectorGroupByNew(0, 0);
+ * vvectorGroupByConsume(by_user, user_ids, VVECTOR_INT64, bytes, VVECTOR_DOUBLE, 0, vvectorGetLength(user_ids));
+ *
+ * vvector users = vvectorNew(int64_t, 0);
+ * vvector totals = vvectorNew(double, 0);
+ * vvectorGroupByEmit(by_user, users, 0, totals, 0, 0);
+ * @endcode
+ */
+struct vvectorGroupBy;
+
+/**
+ * @brief Create a new, empty group-by table.
+ *
+ * @param   expected_groups     Number of groups to size the table for, or 0. The table grows as needed.
+ * @param   allocator           Allocator for the table's storage, or NULL for defaults. @see vvectorAlloc.
+ * @return  The new table or NULL.
+ */
+struct vvectorGroupBy * vvectorGroupByNew(ptrdiff_t expected_groups, struct vvectorAlloc * allocator);
+
+/**
+ * @brief Free the table.
+ *
+ * @param   groupby     The table.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorGroupByFree(struct vvectorGroupBy * groupby);
+
+/**
+ * @brief Remove every group, keeping the memory.
+ *
+ * @param   groupby     The table.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorGroupByClear(struct vvectorGroupBy * groupby);
+
+/**
+ * @brief Aggregate keys[i], values[i] for i in [first, last).
+ *
+ * @param   groupby     The table.
+ * @param   keys        vvector of 'key_type' elements.
+ * @param   key_type    An integer type, VVECTOR_INT8 to VVECTOR_INT64.
+ * @param   values      vvector of 'value_type' elements, at least as long as 'keys', or NULL to only count.
+ * @param   value_type  Type of 'values'. Ignored if 'values' is NULL.
+ * @param   first       Index of the first row.
+ * @param   last        Index one past the last row.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorGroupByConsume(struct vvectorGroupBy * groupby, vvector keys, enum vvectorScalarType key_type,
+                          vvector values, enum vvectorScalarType value_type, ptrdiff_t first, ptrdiff_t last);
+
+/**
+ * @brief Get the number of groups.
+ *
+ * @param   groupby     The table.
+ * @return  The number of groups, or 0 on error.
+ */
+ptrdiff_t vvectorGroupByGetNrGroups(struct vvectorGroupBy * groupby);
+
+/**
+ * @brief Append the key and aggregates of every group to output vvectors, in the order the groups were first seen.
+ *
+ * Sums, minimums and maximums are 0, +inf and -inf for groups consumed without values.
+ *
+ * @param   groupby     The table.
+ * @param   keys        vvector of int64_t which receives the keys, or NULL.
+ * @param   counts      vvector of int64_t which receives the number of rows, or NULL.
+ * @param   sums        vvector of double which receives the sums, or NULL.
+ * @param   mins        vvector of double which receives the minimums, or NULL.
+ * @param   maxs        vvector of double which receives the maximums, or NULL.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorGroupByEmit(struct vvectorGroupBy * groupby, vvector keys, vvector counts, vvector sums, vvector mins, vvector maxs);
+
+/**
+ * @brief Group a whole key column on several threads and append the results to output vvectors.
+ *
+ * Each thread aggregates a slice of the rows into its own table, then splits its groups by the top bits of their
+ * hashes (radix partitions). Partitions hold disjoint keys, so each is merged by one thread without locks.
+ * Groups are emitted partition by partition; their order is not specified.
+ *
+ * @param   keys        vvector of 'key_type' elements.
+ * @param   key_type    An integer type, VVECTOR_INT8 to VVECTOR_INT64.
+ * @param   values      vvector of 'value_type' elements, at least as long as 'keys', or NULL to only count.
+ * @param   value_type  Type of 'values'. Ignored if 'values' is NULL.
+ * @param   nr_threads  Number of threads, including the calling one. Small inputs use fewer.
+ * @param   out_keys    vvector of int64_t which receives the keys, or NULL.
+ * @param   counts      vvector of int64_t which receives the number of rows, or NULL.
+ * @param   sums        vvector of double which receives the sums, or NULL.
+ * @param   mins        vvector of double which receives the minimums, or NULL.
+ * @param   maxs        vvector of double which receives the maximums, or NULL.
+ * @param   allocator   Allocator for the temporary tables, or NULL for defaults. @see vvectorAlloc.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorGroupByParallel(vvector keys, enum vvectorScalarType key_type, vvector values, enum vvectorScalarType value_type, int nr_threads,
+                           vvector out_keys, vvector counts, vvector sums, vvector mins, vvector maxs, struct vvectorAlloc * allocator);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VVECTOR_GROUPBY_H
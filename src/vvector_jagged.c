@@ -0,0 +1,415 @@
+/*
+    Copyright 2024 I. Laurentiu
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+// pthread_*
+#define _POSIX_C_SOURCE 200809L
+
+#include "vvector_jagged.h"
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// @file vvector_jagged.c
+
+#define VEC_ENOVEC 1        /**< Indicates that the provided vector or jagged array argument is NULL. */
+#define VEC_EBADINDEX 2     /**< Indicates that the provided row index is invalid. */
+#define VEC_ENOVALUE 3      /**< Indicates that the provided value pointer is NULL. */
+
+struct vvectorJagged {
+    vvector offsets;                /**< nr_rows + 1 ptrdiff_t, starting with 0. */
+    vvector values;
+    struct vvectorAlloc alloc;      /**< Used for this struct. Missing functions fall back to the C library. */
+};
+
+/* Helpers */
+
+static void * jagged_malloc(struct vvectorAlloc * alloc, ptrdiff_t size){
+    if (alloc && alloc->malloc_fn) return alloc->malloc_fn(size, alloc->ctx);
+
+    return malloc(size);
+}
+
+static void jagged_free(struct vvectorAlloc * alloc, void * ptr, ptrdiff_t size){
+    if (alloc && alloc->free_fn) {
+        alloc->free_fn(ptr, size, alloc->ctx);
+        return;
+    }
+
+    free(ptr);
+}
+
+/**
+ * @internal
+ * @brief Pointer to the offsets, valid until the offsets vvector grows. Never NULL, there is always at least one offset.
+ */
+static ptrdiff_t * get_offsets(struct vvectorJagged * jagged){
+    return vvectorGetFront(jagged->offsets);
+}
+
+/**
+ * @internal
+ * @brief Create a jagged array with 'nr_rows' rows holding 'nr_values' values in total. Offsets and values are left uninitialized.
+ */
+static struct vvectorJagged * jagged_new_uninit(ptrdiff_t element_size, ptrdiff_t nr_rows, ptrdiff_t nr_values, struct vvectorAlloc * allocator){
+    struct vvectorJagged * jagged = vvectorJaggedNew(element_size, allocator);
+    if (!jagged) return 0;
+
+    if (vvectorResizeUninit(jagged->offsets, nr_rows + 1) || vvectorResizeUninit(jagged->values, nr_values)) {
+        vvectorJaggedFree(jagged);
+        return 0;
+    }
+
+    return jagged;
+}
+
+/* Create and destroy */
+
+struct vvectorJagged * vvectorJaggedNew(ptrdiff_t element_size, struct vvectorAlloc * allocator){
+    if (element_size <= 0) return 0;
+
+    struct vvectorJagged * jagged = jagged_malloc(allocator, sizeof(struct vvectorJagged));
+    if (!jagged) return 0;
+
+    memset(jagged, 0, sizeof(struct vvectorJagged));
+    if (allocator) jagged->alloc = *allocator;
+
+    jagged->offsets = vec_new_(sizeof(ptrdiff_t), allocator);
+    jagged->values = vec_new_(element_size, allocator);
+
+    ptrdiff_t zero = 0;
+    if (!jagged->offsets || !jagged->values || vvectorPushBack(jagged->offsets, &zero)) {
+        vvectorJaggedFree(jagged);
+        return 0;
+    }
+
+    return jagged;
+}
+
+int vvectorJaggedFree(struct vvectorJagged * jagged){
+    if (!jagged) return VEC_ENOVEC;
+
+    if (jagged->offsets) vvectorFree(jagged->offsets);
+    if (jagged->values) vvectorFree(jagged->values);
+
+    struct vvectorAlloc alloc = jagged->alloc;
+    jagged_free(&alloc, jagged, sizeof(struct vvectorJagged));
+
+    return 0;
+}
+
+/* Build by appending */
+
+int vvectorJaggedReserve(struct vvectorJagged * jagged, ptrdiff_t nr_rows, ptrdiff_t nr_values){
+    if (!jagged) return VEC_ENOVEC;
+
+    if (nr_rows < 0 || nr_values < 0) return VEC_EBADINDEX;
+
+    int err = vvectorReserve(jagged->offsets, nr_rows);
+    if (err) return err;
+
+    return vvectorReserve(jagged->values, nr_values);
+}
+
+int vvectorJaggedAppendRow(struct vvectorJagged * jagged, void * values, ptrdiff_t count){
+    if (!jagged) return VEC_ENOVEC;
+
+    if (count < 0) return VEC_EBADINDEX;
+
+    if (count > 0 && !values) return VEC_ENOVALUE;
+
+    int err = vvectorAppend(jagged->values, values, count, VVECTOR_COPY_AUTO);
+    if (err) return err;
+
+    ptrdiff_t end = vvectorGetLength(jagged->values);
+    err = vvectorPushBack(jagged->offsets, &end);
+    if (err) {
+        vvectorResizeUninit(jagged->values, end - count);
+        return err;
+    }
+
+    return 0;
+}
+
+int vvectorJaggedPushBack(struct vvectorJagged * jagged, void * value){
+    if (!jagged) return VEC_ENOVEC;
+
+    if (!value) return VEC_ENOVALUE;
+
+    ptrdiff_t nr_rows = vvectorGetLength(jagged->offsets) - 1;
+    if (nr_rows == 0) return VEC_EBADINDEX;
+
+    int err = vvectorPushBack(jagged->values, value);
+    if (err) return err;
+
+    get_offsets(jagged)[nr_rows]++;
+
+    return 0;
+}
+
+/* Access */
+
+void * vvectorJaggedGetRow(struct vvectorJagged * jagged, ptrdiff_t row, ptrdiff_t * length){
+    if (length) *length = 0;
+
+    if (!jagged) return 0;
+
+    if (row < 0 || row >= vvectorGetLength(jagged->offsets) - 1) return 0;
+
+    const ptrdiff_t * offsets = get_offsets(jagged);
+    ptrdiff_t first = offsets[row];
+    ptrdiff_t count = offsets[row + 1] - first;
+
+    if (length) *length = count;
+
+    return (count > 0) ? vvectorGetAt(jagged->values, first) : 0;
+}
+
+ptrdiff_t vvectorJaggedGetNrRows(struct vvectorJagged * jagged){
+    if (!jagged) return 0;
+
+    return vvectorGetLength(jagged->offsets) - 1;
+}
+
+ptrdiff_t vvectorJaggedGetNrValues(struct vvectorJagged * jagged){
+    if (!jagged) return 0;
+
+    return vvectorGetLength(jagged->values);
+}
+
+vvector vvectorJaggedGetOffsets(struct vvectorJagged * jagged){
+    if (!jagged) return 0;
+
+    return jagged->offsets;
+}
+
+vvector vvectorJaggedGetValues(struct vvectorJagged * jagged){
+    if (!jagged) return 0;
+
+    return jagged->values;
+}
+
+// << COUNTING SORT BUILD >>
+
+/**
+ * @internal
+ * @struct jagged_build_task_
+ * @brief One thread's slice of the pairs in 'vvectorJaggedFromPairs'.
+ */
+struct jagged_build_task_ {
+    const ptrdiff_t * rows;
+    const uint8_t * values;
+    ptrdiff_t first;
+    ptrdiff_t last;
+    ptrdiff_t element_size;
+    ptrdiff_t nr_rows;
+    ptrdiff_t * cursors;    /**< nr_rows counters: counts in the first pass, write positions in the second. */
+    uint8_t * out;
+    int bad_row;
+    pthread_t thread;
+    int started;
+};
+
+static void * jagged_count_rows(void * arg){
+    struct jagged_build_task_ * task = arg;
+
+    for (ptrdiff_t i = task->first; i < task->last; i++) {
+        ptrdiff_t row = task->rows[i];
+
+        if (row < 0 || row >= task->nr_rows) {
+            task->bad_row = 1;
+            return 0;
+        }
+
+        task->cursors[row]++;
+    }
+
+    return 0;
+}
+
+static void * jagged_place_values(void * arg){
+    struct jagged_build_task_ * task = arg;
+    ptrdiff_t element_size = task->element_size;
+
+    // Fixed size copies compile to a single move.
+    switch (element_size) {
+        case 4:
+            for (ptrdiff_t i = task->first; i < task->last; i++) {
+                memcpy(task->out + task->cursors[task->rows[i]]++ * 4, task->values + i * 4, 4);
+            }
+            break;
+        case 8:
+            for (ptrdiff_t i = task->first; i < task->last; i++) {
+                memcpy(task->out + task->cursors[task->rows[i]]++ * 8, task->values + i * 8, 8);
+            }
+            break;
+        default:
+            for (ptrdiff_t i = task->first; i < task->last; i++) {
+                memcpy(task->out + task->cursors[task->rows[i]]++ * element_size, task->values + i * element_size, element_size);
+            }
+            break;
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Run 'fn' on every task, tasks[0] on the calling thread. Falls back to the calling thread if a thread can't be started.
+ */
+static void run_tasks(void * (*fn)(void *), struct jagged_build_task_ * tasks, int nr_tasks){
+    for (int t = 1; t < nr_tasks; t++) {
+        tasks[t].started = (pthread_create(&tasks[t].thread, 0, fn, &tasks[t]) == 0);
+        if (!tasks[t].started) fn(&tasks[t]);
+    }
+
+    fn(&tasks[0]);
+
+    for (int t = 1; t < nr_tasks; t++) {
+        if (tasks[t].started) pthread_join(tasks[t].thread, 0);
+    }
+}
+
+struct vvectorJagged * vvectorJaggedFromPairs(ptrdiff_t element_size, const ptrdiff_t * rows, void * values, ptrdiff_t n,
+                                              ptrdiff_t nr_rows, int nr_threads, struct vvectorAlloc * allocator){
+    if (element_size <= 0 || n < 0 || nr_rows < 0) return 0;
+    if (n > 0 && (!rows || !values)) return 0;
+
+    if (nr_threads < 1) nr_threads = 1;
+    // Each thread needs enough pairs to pay for its counters and startup.
+    if (nr_threads > 1 && n / nr_threads < nr_rows + 4096) nr_threads = 1;
+
+    struct vvectorJagged * jagged = jagged_new_uninit(element_size, nr_rows, n, allocator);
+    if (!jagged) return 0;
+
+    // Scratch: the tasks, followed by nr_rows counters per thread.
+    ptrdiff_t scratch_size = nr_threads * ((ptrdiff_t) sizeof(struct jagged_build_task_) + nr_rows * (ptrdiff_t) sizeof(ptrdiff_t));
+    uint8_t * scratch = jagged_malloc(allocator, scratch_size);
+    if (!scratch) {
+        vvectorJaggedFree(jagged);
+        return 0;
+    }
+
+    struct jagged_build_task_ * tasks = (struct jagged_build_task_ *) scratch;
+    ptrdiff_t * counters = (ptrdiff_t *) (scratch + nr_threads * sizeof(struct jagged_build_task_));
+
+    memset(counters, 0, nr_threads * nr_rows * sizeof(ptrdiff_t));
+
+    for (int t = 0; t < nr_threads; t++) {
+        tasks[t].rows = rows;
+        tasks[t].values = values;
+        tasks[t].first = n * t / nr_threads;
+        tasks[t].last = n * (t + 1) / nr_threads;
+        tasks[t].element_size = element_size;
+        tasks[t].nr_rows = nr_rows;
+        tasks[t].cursors = &counters[t * nr_rows];
+        tasks[t].out = vvectorGetFront(jagged->values);
+        tasks[t].bad_row = 0;
+    }
+
+    run_tasks(jagged_count_rows, tasks, nr_threads);
+
+    int bad_row = 0;
+    for (int t = 0; t < nr_threads; t++) bad_row |= tasks[t].bad_row;
+
+    if (bad_row) {
+        jagged_free(allocator, scratch, scratch_size);
+        vvectorJaggedFree(jagged);
+        return 0;
+    }
+
+    // Exclusive prefix sum, row major then thread: thread 't' writes row 'r' after threads 0..t-1, which keeps the input order.
+    ptrdiff_t * offsets = get_offsets(jagged);
+    ptrdiff_t position = 0;
+
+    for (ptrdiff_t r = 0; r < nr_rows; r++) {
+        offsets[r] = position;
+
+        for (int t = 0; t < nr_threads; t++) {
+            ptrdiff_t count = tasks[t].cursors[r];
+            tasks[t].cursors[r] = position;
+            position += count;
+        }
+    }
+    offsets[nr_rows] = position;
+
+    if (n > 0) run_tasks(jagged_place_values, tasks, nr_threads);
+
+    jagged_free(allocator, scratch, scratch_size);
+
+    return jagged;
+}
+
+// << CONVERSIONS >>
+
+struct vvectorJagged * vvectorJaggedFromVectors(vvector * vecs, ptrdiff_t n, struct vvectorAlloc * allocator){
+    if (!vecs || n <= 0) return 0;
+
+    ptrdiff_t element_size = vvectorGetElementSize(vecs[0]);
+    ptrdiff_t nr_values = 0;
+
+    for (ptrdiff_t i = 0; i < n; i++) {
+        if (!vecs[i] || vvectorGetElementSize(vecs[i]) != element_size) return 0;
+
+        nr_values += vvectorGetLength(vecs[i]);
+    }
+
+    struct vvectorJagged * jagged = jagged_new_uninit(element_size, n, nr_values, allocator);
+    if (!jagged) return 0;
+
+    ptrdiff_t * offsets = get_offsets(jagged);
+    uint8_t * out = vvectorGetFront(jagged->values);
+    ptrdiff_t position = 0;
+
+    for (ptrdiff_t i = 0; i < n; i++) {
+        ptrdiff_t length = vvectorGetLength(vecs[i]);
+
+        offsets[i] = position;
+        if (length > 0) memcpy(out + position * element_size, vvectorGetFront(vecs[i]), length * element_size);
+
+        position += length;
+    }
+    offsets[n] = position;
+
+    return jagged;
+}
+
+int vvectorJaggedToVectors(struct vvectorJagged * jagged, vvector * out, struct vvectorAlloc * allocator){
+    if (!jagged) return VEC_ENOVEC;
+
+    if (!out) return VEC_ENOVALUE;
+
+    ptrdiff_t nr_rows = vvectorJaggedGetNrRows(jagged);
+    ptrdiff_t element_size = vvectorGetElementSize(jagged->values);
+
+    for (ptrdiff_t i = 0; i < nr_rows; i++) {
+        ptrdiff_t length;
+        void * row = vvectorJaggedGetRow(jagged, i, &length);
+
+        out[i] = vec_new_(element_size, allocator);
+
+        if (!out[i] || vvectorAppend(out[i], row, length, VVECTOR_COPY_AUTO)) {
+            for (ptrdiff_t j = 0; j <= i; j++) {
+                if (out[j]) vvectorFree(out[j]);
+                out[j] = 0;
+            }
+
+            return VEC_ENOVEC;
+        }
+    }
+
+    return 0;
+}
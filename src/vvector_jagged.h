@@ -0,0 +1,182 @@
+/*
+    Copyright 2024 I. Laurentiu
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef VVECTOR_JAGGED_H
+#define VVECTOR_JAGGED_H
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+#include "vvector.h"
+
+#include <stddef.h>
+
+/// @file vvector_jagged.h
+
+/**
+ * @struct vvectorJagged
+ *
+ * @brief   A list of variable length rows stored in two vvectors (compressed sparse row layout).
+ *
+ * Every value of every row lives in one flat 'values' vvector, row after row.
+ * A second vvector holds nr_rows + 1 offsets: row 'i' is values[offsets[i]] up to, but not including, values[offsets[i + 1]].
+ * Compared to an array of vvectors this is two allocations instead of one per row, and walking all rows is a sequential scan.
+ *
+ * @code
+ * struct vvectorJagged * adjacency = vvectorJaggedNew(sizeof(int), 0);
+ * int neighbours[] = {1, 2};
+ * vvectorJaggedAppendRow(adjacency, neighbours, 2);   // Node 0
+ * vvectorJaggedAppendRow(adjacency, 0, 0);            // Node 1, no neighbours yet
+ * int n = 0;
+ * vvectorJaggedPushBack(adjacency, &n);               // Node 1 -> 0
+ *
+ * ptrdiff_t length;
+ * int * row = vvectorJaggedGetRow(adjacency, 0, &length);
+ * @endcode
+ */
+struct vvectorJagged;
+
+/**
+ * @brief Create a new, empty jagged array.
+ *
+ * @param   element_size    Size of each value in bytes.
+ * @param   allocator       Allocator for both vvectors, or NULL for defaults. @see vvectorAlloc.
+ * @return  The new jagged array or NULL.
+ */
+struct vvectorJagged * vvectorJaggedNew(ptrdiff_t element_size, struct vvectorAlloc * allocator);
+
+/**
+ * @brief Free the jagged array and its storage.
+ *
+ * @param   jagged  The jagged array.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorJaggedFree(struct vvectorJagged * jagged);
+
+/**
+ * @brief Reserve room for 'nr_rows' more rows and 'nr_values' more values.
+ *
+ * @param   jagged      The jagged array.
+ * @param   nr_rows     Number of rows to make room for.
+ * @param   nr_values   Number of values to make room for.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorJaggedReserve(struct vvectorJagged * jagged, ptrdiff_t nr_rows, ptrdiff_t nr_values);
+
+/**
+ * @brief Add a new row at the end, holding a copy of 'count' values.
+ *
+ * @param   jagged  The jagged array.
+ * @param   values  Pointer to 'count' contiguous values. May be NULL if 'count' is 0.
+ * @param   count   Number of values in the new row.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorJaggedAppendRow(struct vvectorJagged * jagged, void * values, ptrdiff_t count);
+
+/**
+ * @brief Add a value at the end of the last row.
+ *
+ * @param   jagged  The jagged array. Must have at least one row.
+ * @param   value   Pointer to the value.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorJaggedPushBack(struct vvectorJagged * jagged, void * value);
+
+/**
+ * @brief Get a row in O(1).
+ *
+ * The pointer is invalidated by any function which adds rows or values.
+ *
+ * @param   jagged  The jagged array.
+ * @param   row     Index of the row.
+ * @param   length  Set to the number of values in the row, or 0 on error.
+ * @return  Pointer to the first value of the row. NULL on error, or if the row is empty.
+ */
+void * vvectorJaggedGetRow(struct vvectorJagged * jagged, ptrdiff_t row, ptrdiff_t * length);
+
+/**
+ * @brief Get the number of rows.
+ *
+ * @param   jagged  The jagged array.
+ * @return  The number of rows, or 0 on error.
+ */
+ptrdiff_t vvectorJaggedGetNrRows(struct vvectorJagged * jagged);
+
+/**
+ * @brief Get the total number of values, in all rows.
+ *
+ * @param   jagged  The jagged array.
+ * @return  The number of values, or 0 on error.
+ */
+ptrdiff_t vvectorJaggedGetNrValues(struct vvectorJagged * jagged);
+
+/**
+ * @brief Get the vvector of row offsets (ptrdiff_t), nr_rows + 1 long.
+ *
+ * Do not modify it, it is owned by the jagged array.
+ */
+vvector vvectorJaggedGetOffsets(struct vvectorJagged * jagged);
+
+/**
+ * @brief Get the vvector holding the values of all rows, row after row.
+ *
+ * Values may be modified in place, but the length must not change. It is owned by the jagged array.
+ */
+vvector vvectorJaggedGetValues(struct vvectorJagged * jagged);
+
+/**
+ * @brief Build a jagged array from unordered (row, value) pairs with a counting sort.
+ *
+ * Pair 'i' puts values[i] into row rows[i]. Values keep their input order within a row.
+ * With more than one thread, each thread counts and then places a contiguous slice of the pairs.
+ *
+ * @param   element_size    Size of each value in bytes.
+ * @param   rows            Row index of each pair, in [0, nr_rows).
+ * @param   values          'n' contiguous values.
+ * @param   n               Number of pairs.
+ * @param   nr_rows         Number of rows of the result. Rows without pairs are empty.
+ * @param   nr_threads      Number of threads to use. Values below 1 mean 1.
+ * @param   allocator       Allocator for the result, or NULL for defaults. @see vvectorAlloc.
+ * @return  The new jagged array, or NULL on error (including a row index out of range).
+ */
+struct vvectorJagged * vvectorJaggedFromPairs(ptrdiff_t element_size, const ptrdiff_t * rows, void * values, ptrdiff_t n,
+                                              ptrdiff_t nr_rows, int nr_threads, struct vvectorAlloc * allocator);
+
+/**
+ * @brief Build a jagged array with one row per vvector, copying their elements.
+ *
+ * @param   vecs        Array of 'n' vvectors, all with the same element size.
+ * @param   n           Number of vvectors.
+ * @param   allocator   Allocator for the result, or NULL for defaults. @see vvectorAlloc.
+ * @return  The new jagged array, or NULL on error (including element sizes that differ).
+ */
+struct vvectorJagged * vvectorJaggedFromVectors(vvector * vecs, ptrdiff_t n, struct vvectorAlloc * allocator);
+
+/**
+ * @brief Create one vvector per row, holding a copy of the row's values.
+ *
+ * @param   jagged      The jagged array.
+ * @param   out         Array with room for 'vvectorJaggedGetNrRows' vvectors.
+ * @param   allocator   Allocator for the new vvectors, or NULL for defaults. @see vvectorAlloc.
+ * @return  Returns 0 on success or a positive, non-zero value on error (no vvectors are left allocated then).
+ */
+int vvectorJaggedToVectors(struct vvectorJagged * jagged, vvector * out, struct vvectorAlloc * allocator);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VVECTOR_JAGGED_H
@@ -0,0 +1,558 @@
+/*
+    Copyright 2024 I. Laurentiu
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+// pthread_*
+#define _POSIX_C_SOURCE 200809L
+
+#include "vvector_join.h"
+#include "vvector_partition.h"
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// @file vvector_join.c
+
+#define VEC_ENOVEC 1        /**< Indicates that a vector or key argument is NULL, or an allocation failed. */
+#define VEC_EBADINDEX 2     /**< Indicates that a key does not fit in the elements. */
+#define VEC_EMISMATCH 4     /**< Indicates that an output vector does not hold ptrdiff_t. */
+
+#define SIGN_BIT ((uint64_t) 1 << 63)
+#define PAIR_CHUNK 256                  /**< Matches are collected per thread and appended in chunks. */
+#define PARTITION_ROWS 2048             /**< Target build rows per partition: rows, heads and links fit in L2. */
+#define MAX_PARTITION_BITS 16
+#define MIN_ROWS_PER_THREAD 65536
+
+/**
+ * @internal
+ * @struct join_row_
+ * @brief A key and the index of its element, the unit both sides of a hash join are partitioned as.
+ */
+struct join_row_ {
+    uint64_t key;
+    ptrdiff_t index;
+};
+
+/**
+ * @internal
+ * @struct join_side_
+ * @brief One input of a merge join.
+ */
+struct join_side_ {
+    const uint8_t * data;
+    ptrdiff_t size;
+    const struct vvectorJoinKey * key;
+};
+
+/**
+ * @internal
+ * @struct join_output_
+ * @brief One thread's matches: a chunk of pairs in flight, and the vvectors they are appended to.
+ */
+struct join_output_ {
+    vvector left;
+    vvector right;
+    ptrdiff_t chunk_left[PAIR_CHUNK];
+    ptrdiff_t chunk_right[PAIR_CHUNK];
+    int count;
+    int err;
+};
+
+/**
+ * @internal
+ * @struct join_task_
+ * @brief One thread's share of a join: partitions 'p' with p % nr_tasks == its index for hash joins, a range of rows for merge joins.
+ */
+struct join_task_ {
+    // Hash join.
+    const struct join_row_ * build;
+    const ptrdiff_t * build_offsets;
+    const struct join_row_ * probe;
+    const ptrdiff_t * probe_offsets;
+    ptrdiff_t nr_partitions;
+    int swapped;                /**< The build side is the right input. */
+    vvector heads;              /**< ptrdiff_t: first build row of each bucket, or -1. */
+    vvector links;              /**< ptrdiff_t: next build row of the same bucket, or -1. */
+
+    // Merge join.
+    struct join_side_ left;
+    struct join_side_ right;
+    ptrdiff_t left_first;
+    ptrdiff_t left_last;
+    ptrdiff_t right_first;
+    ptrdiff_t right_last;
+
+    struct join_output_ * out;
+    struct join_task_ * all;
+    int nr_tasks;
+    pthread_t thread;
+    int started;
+};
+
+/* Helpers */
+
+static void * join_malloc(struct vvectorAlloc * alloc, ptrdiff_t size){
+    if (alloc && alloc->malloc_fn) return alloc->malloc_fn(size, alloc->ctx);
+
+    return malloc(size);
+}
+
+static void join_free(struct vvectorAlloc * alloc, void * ptr, ptrdiff_t size){
+    if (alloc && alloc->free_fn) {
+        alloc->free_fn(ptr, size, alloc->ctx);
+        return;
+    }
+
+    free(ptr);
+}
+
+/**
+ * @internal
+ * @brief Read the key of an element as a 64 bit integer which orders like the key (signed keys get their sign bit flipped).
+ */
+static inline uint64_t extract_key(const struct vvectorJoinKey * key, const uint8_t * element){
+    if (key->fn) return key->fn(element, key->ctx);
+
+    const uint8_t * field = element + key->offset;
+
+    if (key->is_signed) {
+        int64_t value;
+
+        switch (key->size) {
+            case 1: value = (int8_t) *field; break;
+            case 2: { int16_t k; memcpy(&k, field, 2); value = k; break; }
+            case 4: { int32_t k; memcpy(&k, field, 4); value = k; break; }
+            default: memcpy(&value, field, 8); break;
+        }
+
+        return (uint64_t) value ^ SIGN_BIT;
+    }
+
+    switch (key->size) {
+        case 1: return *field;
+        case 2: { uint16_t k; memcpy(&k, field, 2); return k; }
+        case 4: { uint32_t k; memcpy(&k, field, 4); return k; }
+        default: { uint64_t k; memcpy(&k, field, 8); return k; }
+    }
+}
+
+static int check_inputs(vvector vec, const struct vvectorJoinKey * key){
+    if (!vec || !*vec || !key) return VEC_ENOVEC;
+
+    if (key->fn) return 0;
+
+    if (key->size != 1 && key->size != 2 && key->size != 4 && key->size != 8) return VEC_EBADINDEX;
+
+    if (key->offset < 0 || key->offset + key->size > vvectorGetElementSize(vec)) return VEC_EBADINDEX;
+
+    return 0;
+}
+
+static int check_outputs(vvector left_indices, vvector right_indices){
+    if (!left_indices || !*left_indices || !right_indices || !*right_indices) return VEC_ENOVEC;
+
+    if (vvectorGetElementSize(left_indices) != sizeof(ptrdiff_t) || vvectorGetElementSize(right_indices) != sizeof(ptrdiff_t)) return VEC_EMISMATCH;
+
+    return 0;
+}
+
+static void flush_pairs(struct join_output_ * out){
+    if (out->count > 0 && !out->err) {
+        out->err = vvectorAppend(out->left, out->chunk_left, out->count, VVECTOR_COPY_CACHED);
+        if (!out->err) out->err = vvectorAppend(out->right, out->chunk_right, out->count, VVECTOR_COPY_CACHED);
+    }
+
+    out->count = 0;
+}
+
+// After a failed flush the pairs are dropped; the caller stops at its next 'out->err' check.
+static inline void emit_pair(struct join_output_ * out, ptrdiff_t left, ptrdiff_t right){
+    if (out->err) return;
+
+    out->chunk_left[out->count] = left;
+    out->chunk_right[out->count] = right;
+
+    if (++out->count == PAIR_CHUNK) flush_pairs(out);
+}
+
+/**
+ * @internal
+ * @brief Run 'fn' on every task, tasks[0] on the calling thread. Falls back to the calling thread if a thread can't be started.
+ */
+static void run_tasks(void * (*fn)(void *), struct join_task_ * tasks, int nr_tasks){
+    for (int t = 1; t < nr_tasks; t++) {
+        tasks[t].started = (pthread_create(&tasks[t].thread, 0, fn, &tasks[t]) == 0);
+        if (!tasks[t].started) fn(&tasks[t]);
+    }
+
+    fn(&tasks[0]);
+
+    for (int t = 1; t < nr_tasks; t++) {
+        if (tasks[t].started) pthread_join(tasks[t].thread, 0);
+    }
+}
+
+/**
+ * @internal
+ * @brief Allocate 'nr_tasks' tasks, each with its own output vvectors.
+ */
+static struct join_task_ * new_tasks(int nr_tasks, struct vvectorAlloc * allocator){
+    ptrdiff_t size = nr_tasks * (ptrdiff_t) (sizeof(struct join_task_) + sizeof(struct join_output_));
+    uint8_t * scratch = join_malloc(allocator, size);
+    if (!scratch) return 0;
+
+    memset(scratch, 0, size);
+
+    struct join_task_ * tasks = (struct join_task_ *) scratch;
+    struct join_output_ * outputs = (struct join_output_ *) (scratch + nr_tasks * sizeof(struct join_task_));
+    int err = 0;
+
+    for (int t = 0; t < nr_tasks; t++) {
+        tasks[t].out = &outputs[t];
+        tasks[t].all = tasks;
+        tasks[t].nr_tasks = nr_tasks;
+        outputs[t].left = vec_new_(sizeof(ptrdiff_t), allocator);
+        outputs[t].right = vec_new_(sizeof(ptrdiff_t), allocator);
+        tasks[t].heads = vec_new_(sizeof(ptrdiff_t), allocator);
+        tasks[t].links = vec_new_(sizeof(ptrdiff_t), allocator);
+
+        if (!outputs[t].left || !outputs[t].right || !tasks[t].heads || !tasks[t].links) err = 1;
+    }
+
+    if (!err) return tasks;
+
+    for (int t = 0; t < nr_tasks; t++) {
+        if (outputs[t].left) vvectorFree(outputs[t].left);
+        if (outputs[t].right) vvectorFree(outputs[t].right);
+        if (tasks[t].heads) vvectorFree(tasks[t].heads);
+        if (tasks[t].links) vvectorFree(tasks[t].links);
+    }
+    join_free(allocator, scratch, size);
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Append every task's matches to the outputs, in task order, and free the tasks.
+ */
+static int finish_tasks(struct join_task_ * tasks, int nr_tasks, vvector left_indices, vvector right_indices, struct vvectorAlloc * allocator){
+    int err = 0;
+
+    for (int t = 0; t < nr_tasks; t++) {
+        struct join_output_ * out = tasks[t].out;
+        ptrdiff_t count = vvectorGetLength(out->left);
+
+        err = err ? err : out->err;
+
+        if (!err && count > 0) {
+            err = vvectorAppend(left_indices, vvectorGetFront(out->left), count, VVECTOR_COPY_AUTO);
+            if (!err) err = vvectorAppend(right_indices, vvectorGetFront(out->right), count, VVECTOR_COPY_AUTO);
+        }
+
+        vvectorFree(out->left);
+        vvectorFree(out->right);
+        vvectorFree(tasks[t].heads);
+        vvectorFree(tasks[t].links);
+    }
+
+    join_free(allocator, tasks, nr_tasks * (ptrdiff_t) (sizeof(struct join_task_) + sizeof(struct join_output_)));
+
+    return err;
+}
+
+static int clamp_threads(int nr_threads, ptrdiff_t n){
+    if (nr_threads < 1) nr_threads = 1;
+    if (nr_threads > 1 && n / nr_threads < MIN_ROWS_PER_THREAD) nr_threads = (int) (n / MIN_ROWS_PER_THREAD);
+    if (nr_threads < 1) nr_threads = 1;
+
+    return nr_threads;
+}
+
+// << HASH JOIN >>
+
+static vvector extract_rows(vvector vec, const struct vvectorJoinKey * key, struct vvectorAlloc * allocator){
+    vvector rows = vec_new_(sizeof(struct join_row_), allocator);
+    ptrdiff_t n = vvectorGetLength(vec);
+
+    if (!rows || vvectorResizeUninit(rows, n)) {
+        if (rows) vvectorFree(rows);
+        return 0;
+    }
+
+    const uint8_t * data = vvectorGetFront(vec);
+    ptrdiff_t size = vvectorGetElementSize(vec);
+    struct join_row_ * out = vvectorGetFront(rows);
+
+    for (ptrdiff_t i = 0; i < n; i++) {
+        out[i].key = extract_key(key, data + i * size);
+        out[i].index = i;
+    }
+
+    return rows;
+}
+
+// Fibonacci hashing: the top bits of key * 2^64 / phi. Independent of the partitioning hash, whose top bits are equal within a partition.
+static inline ptrdiff_t bucket_of(uint64_t key, int shift){
+    return (ptrdiff_t) ((key * 0x9E3779B97F4A7C15ull) >> shift);
+}
+
+static void * hash_join_partitions(void * arg){
+    struct join_task_ * task = arg;
+    struct join_output_ * out = task->out;
+
+    for (ptrdiff_t p = task - task->all; p < task->nr_partitions; p += task->nr_tasks) {
+        const struct join_row_ * build = task->build + task->build_offsets[p];
+        ptrdiff_t nr_build = task->build_offsets[p + 1] - task->build_offsets[p];
+        const struct join_row_ * probe = task->probe + task->probe_offsets[p];
+        ptrdiff_t nr_probe = task->probe_offsets[p + 1] - task->probe_offsets[p];
+
+        if (nr_build == 0 || nr_probe == 0) continue;
+
+        // Chained table over the partition's build rows, at least as many buckets as rows.
+        ptrdiff_t nr_buckets = 2;
+        int shift = 63;
+        while (nr_buckets < nr_build) {
+            nr_buckets *= 2;
+            shift--;
+        }
+
+        out->err = vvectorResizeUninit(task->heads, nr_buckets);
+        if (!out->err) out->err = vvectorResizeUninit(task->links, nr_build);
+        if (out->err) return 0;
+
+        ptrdiff_t * heads = vvectorGetFront(task->heads);
+        ptrdiff_t * links = vvectorGetFront(task->links);
+
+        memset(heads, 0xFF, nr_buckets * sizeof(ptrdiff_t));
+
+        // Insert back to front so chains list rows in input order.
+        for (ptrdiff_t i = nr_build - 1; i >= 0; i--) {
+            ptrdiff_t bucket = bucket_of(build[i].key, shift);
+            links[i] = heads[bucket];
+            heads[bucket] = i;
+        }
+
+        for (ptrdiff_t i = 0; i < nr_probe && !out->err; i++) {
+            uint64_t key = probe[i].key;
+
+            for (ptrdiff_t e = heads[bucket_of(key, shift)]; e >= 0; e = links[e]) {
+                if (build[e].key != key) continue;
+
+                if (task->swapped) emit_pair(out, probe[i].index, build[e].index);
+                else emit_pair(out, build[e].index, probe[i].index);
+            }
+        }
+
+        if (out->err) return 0;
+    }
+
+    flush_pairs(out);
+
+    return 0;
+}
+
+int vvectorHashJoin(vvector left, const struct vvectorJoinKey * left_key, vvector right, const struct vvectorJoinKey * right_key,
+                    int nr_threads, vvector left_indices, vvector right_indices, struct vvectorAlloc * allocator){
+    int err = check_inputs(left, left_key);
+    if (!err) err = check_inputs(right, right_key);
+    if (!err) err = check_outputs(left_indices, right_indices);
+    if (err) return err;
+
+    ptrdiff_t nr_left = vvectorGetLength(left);
+    ptrdiff_t nr_right = vvectorGetLength(right);
+
+    if (nr_left == 0 || nr_right == 0) return 0;
+
+    nr_threads = clamp_threads(nr_threads, nr_left + nr_right);
+
+    // Build on the smaller side.
+    int swapped = (nr_right < nr_left);
+    ptrdiff_t nr_build = swapped ? nr_right : nr_left;
+
+    // Enough partitions for the build side of each to stay in cache, and a few per thread.
+    int bits = 1;
+    while (bits < MAX_PARTITION_BITS && ((nr_build >> bits) > PARTITION_ROWS || ((ptrdiff_t) 1 << bits) < 4 * nr_threads)) bits++;
+
+    vvector build_rows = swapped ? extract_rows(right, right_key, allocator) : extract_rows(left, left_key, allocator);
+    vvector probe_rows = swapped ? extract_rows(left, left_key, allocator) : extract_rows(right, right_key, allocator);
+    vvector build = vec_new_(sizeof(struct join_row_), allocator);
+    vvector probe = vec_new_(sizeof(struct join_row_), allocator);
+    vvector build_offsets = vec_new_(sizeof(ptrdiff_t), allocator);
+    vvector probe_offsets = vec_new_(sizeof(ptrdiff_t), allocator);
+
+    if (!build_rows || !probe_rows || !build || !probe || !build_offsets || !probe_offsets) err = VEC_ENOVEC;
+
+    if (!err) err = vvectorRadixPartition(build_rows, offsetof(struct join_row_, key), sizeof(uint64_t), bits, nr_threads, build, build_offsets, allocator);
+    if (!err) err = vvectorRadixPartition(probe_rows, offsetof(struct join_row_, key), sizeof(uint64_t), bits, nr_threads, probe, probe_offsets, allocator);
+
+    // The unpartitioned rows are not needed past this point.
+    if (build_rows) vvectorFree(build_rows);
+    if (probe_rows) vvectorFree(probe_rows);
+
+    struct join_task_ * tasks = err ? 0 : new_tasks(nr_threads, allocator);
+    if (!err && !tasks) err = VEC_ENOVEC;
+
+    if (!err) {
+        for (int t = 0; t < nr_threads; t++) {
+            tasks[t].build = vvectorGetFront(build);
+            tasks[t].build_offsets = vvectorGetFront(build_offsets);
+            tasks[t].probe = vvectorGetFront(probe);
+            tasks[t].probe_offsets = vvectorGetFront(probe_offsets);
+            tasks[t].nr_partitions = (ptrdiff_t) 1 << bits;
+            tasks[t].swapped = swapped;
+        }
+
+        run_tasks(hash_join_partitions, tasks, nr_threads);
+        err = finish_tasks(tasks, nr_threads, left_indices, right_indices, allocator);
+    }
+
+    if (build) vvectorFree(build);
+    if (probe) vvectorFree(probe);
+    if (build_offsets) vvectorFree(build_offsets);
+    if (probe_offsets) vvectorFree(probe_offsets);
+
+    return err;
+}
+
+// << MERGE JOIN >>
+
+static inline uint64_t key_at(const struct join_side_ * side, ptrdiff_t i){
+    return extract_key(side->key, side->data + i * side->size);
+}
+
+/**
+ * @internal
+ * @brief First index in [first, last) whose key is >= 'target' (or > 'target' if 'after'), by galloping from 'first'.
+ *
+ * Costs O(log d) for an answer 'd' elements away, so skipping short and long gaps are both cheap.
+ */
+static ptrdiff_t gallop(const struct join_side_ * side, ptrdiff_t first, ptrdiff_t last, uint64_t target, int after){
+    #define PASSES(i) (after ? key_at(side, (i)) > target : key_at(side, (i)) >= target)
+
+    if (first >= last || PASSES(first)) return first;
+
+    // Exponential search: 'low' fails, find a 'high' which passes (or the end).
+    ptrdiff_t low = first;
+    ptrdiff_t step = 1;
+    ptrdiff_t high = first + 1;
+
+    while (high < last && !PASSES(high)) {
+        low = high;
+        step *= 2;
+        high = low + step;
+    }
+    if (high > last) high = last;
+
+    // Binary search in (low, high].
+    low++;
+    while (low < high) {
+        ptrdiff_t mid = low + (high - low) / 2;
+
+        if (PASSES(mid)) high = mid;
+        else low = mid + 1;
+    }
+
+    return low;
+
+    #undef PASSES
+}
+
+static void * merge_join_range(void * arg){
+    struct join_task_ * task = arg;
+    struct join_output_ * out = task->out;
+    const struct join_side_ * left = &task->left;
+    const struct join_side_ * right = &task->right;
+    ptrdiff_t i = task->left_first;
+    ptrdiff_t j = task->right_first;
+
+    while (i < task->left_last && j < task->right_last) {
+        uint64_t a = key_at(left, i);
+        uint64_t b = key_at(right, j);
+
+        if (a < b) {
+            i = gallop(left, i + 1, task->left_last, b, 0);
+        } else if (a > b) {
+            j = gallop(right, j + 1, task->right_last, a, 0);
+        } else {
+            // Equal runs: every left row of the run matches every right row of the run.
+            ptrdiff_t i_end = gallop(left, i + 1, task->left_last, a, 1);
+            ptrdiff_t j_end = gallop(right, j + 1, task->right_last, a, 1);
+
+            for (ptrdiff_t x = i; x < i_end && !out->err; x++) {
+                for (ptrdiff_t y = j; y < j_end; y++) emit_pair(out, x, y);
+            }
+            if (out->err) return 0;
+
+            i = i_end;
+            j = j_end;
+        }
+    }
+
+    flush_pairs(out);
+
+    return 0;
+}
+
+int vvectorMergeJoin(vvector left, const struct vvectorJoinKey * left_key, vvector right, const struct vvectorJoinKey * right_key,
+                     int nr_threads, vvector left_indices, vvector right_indices, struct vvectorAlloc * allocator){
+    int err = check_inputs(left, left_key);
+    if (!err) err = check_inputs(right, right_key);
+    if (!err) err = check_outputs(left_indices, right_indices);
+    if (err) return err;
+
+    ptrdiff_t nr_left = vvectorGetLength(left);
+    ptrdiff_t nr_right = vvectorGetLength(right);
+
+    if (nr_left == 0 || nr_right == 0) return 0;
+
+    nr_threads = clamp_threads(nr_threads, nr_left);
+
+    struct join_task_ * tasks = new_tasks(nr_threads, allocator);
+    if (!tasks) return VEC_ENOVEC;
+
+    struct join_side_ left_side = {vvectorGetFront(left), vvectorGetElementSize(left), left_key};
+    struct join_side_ right_side = {vvectorGetFront(right), vvectorGetElementSize(right), right_key};
+
+    // Split the left side into ranges which never cut a run of equal keys; each range's right start is found by galloping.
+    ptrdiff_t left_start = 0;
+    ptrdiff_t right_start = 0;
+
+    for (int t = 0; t < nr_threads; t++) {
+        ptrdiff_t left_end = nr_left * (t + 1) / nr_threads;
+        if (left_end < left_start) left_end = left_start;
+
+        if (left_end > 0 && left_end < nr_left) {
+            left_end = gallop(&left_side, left_end, nr_left, key_at(&left_side, left_end - 1), 1);
+        }
+
+        ptrdiff_t right_end = (left_end < nr_left) ? gallop(&right_side, right_start, nr_right, key_at(&left_side, left_end), 0) : nr_right;
+
+        tasks[t].left = left_side;
+        tasks[t].right = right_side;
+        tasks[t].left_first = left_start;
+        tasks[t].left_last = left_end;
+        tasks[t].right_first = right_start;
+        tasks[t].right_last = right_end;
+
+        left_start = left_end;
+        right_start = right_end;
+    }
+
+    run_tasks(merge_join_range, tasks, nr_threads);
+
+    return finish_tasks(tasks, nr_threads, left_indices, right_indices, allocator);
+}
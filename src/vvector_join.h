@@ -0,0 +1,111 @@
+/*
+    Copyright 2024 I. Laurentiu
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef VVECTOR_JOIN_H
+#define VVECTOR_JOIN_H
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+#include "vvector.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @file vvector_join.h
+
+/*
+ * Joins match the elements of two vvectors with equal keys and append the index pairs of every match
+ * to two vvectors of ptrdiff_t: left_indices[k] matches right_indices[k].
+ *
+ * @code
+ * // Orders and customers, both keyed by customer id.
+ * struct vvectorJoinKey by_customer = {offsetof(struct order, customer), sizeof(int64_t), 1, 0, 0};
+ * struct vvectorJoinKey by_id = {offsetof(struct customer, id), sizeof(int64_t), 1, 0, 0};
+ *
+ * vvector order_rows = vvectorNew(ptrdiff_t, 0);
+ * vvector customer_rows = vvectorNew(ptrdiff_t, 0);
+ * vvectorHashJoin(orders, &by_customer, customers, &by_id, 4, order_rows, customer_rows, 0);
+ * @endcode
+ */
+
+/**
+ * @brief Callback returning the key of an element, for keys which are not a plain integer field.
+ *
+ * @param   element     Pointer to the element.
+ * @param   ctx         The 'ctx' of the vvectorJoinKey.
+ * @return  The key. The merge join compares keys as unsigned 64 bit integers.
+ */
+typedef uint64_t (*vvectorKeyFn)(const void * element, void * ctx);
+
+/**
+ * @struct vvectorJoinKey
+ *
+ * @brief Where the key of an element is: an integer field, or a callback.
+ */
+struct vvectorJoinKey {
+    ptrdiff_t offset;   /**< Offset of the key inside an element, in bytes. */
+    ptrdiff_t size;     /**< Size of the key: 1, 2, 4 or 8 bytes. */
+    int is_signed;      /**< Non-zero if the field is a signed integer, so the merge join orders negative keys first. */
+    vvectorKeyFn fn;    /**< If not NULL, keys are fn(element, ctx) and the fields above are ignored. */
+    void * ctx;
+};
+
+/**
+ * @brief Join two unsorted vvectors on equal keys.
+ *
+ * Both sides are radix partitioned on the key's hash (@see vvector_partition.h) so every partition of the smaller side
+ * fits in the cache. Each partition gets a small hash table of the smaller side, which its rows of the larger side probe.
+ * Partitions are joined on different threads. The order of the output pairs is not specified.
+ *
+ * @param   left            The left vvector.
+ * @param   left_key        Key of the left elements. May differ in size from 'right_key', but not in signedness.
+ * @param   right           The right vvector.
+ * @param   right_key       Key of the right elements.
+ * @param   nr_threads      Number of threads, including the calling one. Small inputs use fewer.
+ * @param   left_indices    vvector of ptrdiff_t which receives the left index of every match.
+ * @param   right_indices   vvector of ptrdiff_t which receives the right index of every match.
+ * @param   allocator       Allocator for temporary storage, or NULL for defaults. @see vvectorAlloc.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorHashJoin(vvector left, const struct vvectorJoinKey * left_key, vvector right, const struct vvectorJoinKey * right_key,
+                    int nr_threads, vvector left_indices, vvector right_indices, struct vvectorAlloc * allocator);
+
+/**
+ * @brief Join two vvectors sorted by ascending key on equal keys.
+ *
+ * Both sides are walked in step; when one side is behind, it skips ahead with a galloping (exponential, then binary) search,
+ * so a small side joined to a large one costs O(small * log(large)). The left side is split into ranges of whole keys,
+ * one per thread. Pairs are emitted in ascending order of left index, then right index.
+ *
+ * @param   left            The left vvector, sorted by 'left_key'.
+ * @param   left_key        Key of the left elements. May differ in size from 'right_key', but not in signedness.
+ * @param   right           The right vvector, sorted by 'right_key'.
+ * @param   right_key       Key of the right elements.
+ * @param   nr_threads      Number of threads, including the calling one. Small inputs use fewer.
+ * @param   left_indices    vvector of ptrdiff_t which receives the left index of every match.
+ * @param   right_indices   vvector of ptrdiff_t which receives the right index of every match.
+ * @param   allocator       Allocator for temporary storage, or NULL for defaults. @see vvectorAlloc.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorMergeJoin(vvector left, const struct vvectorJoinKey * left_key, vvector right, const struct vvectorJoinKey * right_key,
+                     int nr_threads, vvector left_indices, vvector right_indices, struct vvectorAlloc * allocator);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VVECTOR_JOIN_H
@@ -0,0 +1,888 @@
+/*
+    Copyright 2024 I. Laurentiu
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "vvector_dispatch.h"
+#include "vvector_filter.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if VVECTOR_X86
+    #include <immintrin.h>
+#endif
+
+/// @file vvector_kernels.c
+/// @internal Every variant of every dispatched kernel. @see vvector_dispatch.h
+
+#define VVECTOR_SSE2 __attribute__((target("sse2")))
+#define VVECTOR_AVX2 __attribute__((target("avx2")))
+#define VVECTOR_AVX512 __attribute__((target("avx512f,avx512bw,avx512vl")))
+
+// << FIND >>
+
+ptrdiff_t vvector_find_u32_scalar_(const uint32_t * data, ptrdiff_t n, uint32_t value){
+    for (ptrdiff_t i = 0; i < n; i++) {
+        if (data[i] == value) return i;
+    }
+
+    return -1;
+}
+
+ptrdiff_t vvector_find_u64_scalar_(const uint64_t * data, ptrdiff_t n, uint64_t value){
+    for (ptrdiff_t i = 0; i < n; i++) {
+        if (data[i] == value) return i;
+    }
+
+    return -1;
+}
+
+#if VVECTOR_X86
+
+VVECTOR_AVX2
+ptrdiff_t vvector_find_u32_avx2_(const uint32_t * data, ptrdiff_t n, uint32_t value){
+    const __m256i needle = _mm256_set1_epi32((int) value);
+    ptrdiff_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256i block = _mm256_loadu_si256((const __m256i *) &data[i]);
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(block, needle)));
+
+        if (mask) return i + __builtin_ctz(mask);
+    }
+
+    for (; i < n; i++) {
+        if (data[i] == value) return i;
+    }
+
+    return -1;
+}
+
+VVECTOR_AVX2
+ptrdiff_t vvector_find_u64_avx2_(const uint64_t * data, ptrdiff_t n, uint64_t value){
+    const __m256i needle = _mm256_set1_epi64x((long long) value);
+    ptrdiff_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m256i block = _mm256_loadu_si256((const __m256i *) &data[i]);
+        int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(block, needle)));
+
+        if (mask) return i + __builtin_ctz(mask);
+    }
+
+    for (; i < n; i++) {
+        if (data[i] == value) return i;
+    }
+
+    return -1;
+}
+
+VVECTOR_AVX512
+ptrdiff_t vvector_find_u32_avx512_(const uint32_t * data, ptrdiff_t n, uint32_t value){
+    const __m512i needle = _mm512_set1_epi32((int) value);
+    ptrdiff_t i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __mmask16 mask = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512(&data[i]), needle);
+
+        if (mask) return i + __builtin_ctz(mask);
+    }
+
+    // Masked loads never fault on the lanes they skip.
+    if (i < n) {
+        __mmask16 tail = (__mmask16) ((1u << (n - i)) - 1);
+        __mmask16 mask = _mm512_mask_cmpeq_epi32_mask(tail, _mm512_maskz_loadu_epi32(tail, &data[i]), needle);
+
+        if (mask) return i + __builtin_ctz(mask);
+    }
+
+    return -1;
+}
+
+VVECTOR_AVX512
+ptrdiff_t vvector_find_u64_avx512_(const uint64_t * data, ptrdiff_t n, uint64_t value){
+    const __m512i needle = _mm512_set1_epi64((long long) value);
+    ptrdiff_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __mmask8 mask = _mm512_cmpeq_epi64_mask(_mm512_loadu_si512(&data[i]), needle);
+
+        if (mask) return i + __builtin_ctz(mask);
+    }
+
+    if (i < n) {
+        __mmask8 tail = (__mmask8) ((1u << (n - i)) - 1);
+        __mmask8 mask = _mm512_mask_cmpeq_epi64_mask(tail, _mm512_maskz_loadu_epi64(tail, &data[i]), needle);
+
+        if (mask) return i + __builtin_ctz(mask);
+    }
+
+    return -1;
+}
+
+#endif // VVECTOR_X86
+
+// << STREAMING COPY >>
+
+void vvector_stream_copy_scalar_(void * dst, const void * src, ptrdiff_t n){
+    memcpy(dst, src, n);
+}
+
+#if VVECTOR_X86
+
+/**
+ * @internal
+ * @brief Copies the bytes in front of the first 'alignment' aligned address in 'dst' with a regular memcpy.
+ *
+ * Non-temporal stores need an aligned destination, the source is read with unaligned loads.
+ *
+ * @return The number of bytes copied.
+ */
+static ptrdiff_t stream_copy_head(uint8_t * dst, const uint8_t * src, ptrdiff_t n, ptrdiff_t alignment){
+    ptrdiff_t head = (ptrdiff_t) ((alignment - ((uintptr_t) dst & (alignment - 1))) & (alignment - 1));
+    if (head > n) head = n;
+
+    memcpy(dst, src, head);
+
+    return head;
+}
+
+VVECTOR_SSE2
+void vvector_stream_copy_sse2_(void * dst, const void * src, ptrdiff_t n){
+    uint8_t * d = dst;
+    const uint8_t * s = src;
+
+    ptrdiff_t head = stream_copy_head(d, s, n, 16);
+    d += head;
+    s += head;
+    n -= head;
+
+    for (; n >= 64; n -= 64, d += 64, s += 64) {
+        __m128i a = _mm_loadu_si128((const __m128i *) (s + 0));
+        __m128i b = _mm_loadu_si128((const __m128i *) (s + 16));
+        __m128i c = _mm_loadu_si128((const __m128i *) (s + 32));
+        __m128i e = _mm_loadu_si128((const __m128i *) (s + 48));
+        _mm_stream_si128((__m128i *) (d + 0), a);
+        _mm_stream_si128((__m128i *) (d + 16), b);
+        _mm_stream_si128((__m128i *) (d + 32), c);
+        _mm_stream_si128((__m128i *) (d + 48), e);
+    }
+
+    // Make the streamed data visible before anyone reads it through the cache.
+    _mm_sfence();
+
+    memcpy(d, s, n);
+}
+
+VVECTOR_AVX2
+void vvector_stream_copy_avx2_(void * dst, const void * src, ptrdiff_t n){
+    uint8_t * d = dst;
+    const uint8_t * s = src;
+
+    ptrdiff_t head = stream_copy_head(d, s, n, 32);
+    d += head;
+    s += head;
+    n -= head;
+
+    for (; n >= 128; n -= 128, d += 128, s += 128) {
+        __m256i a = _mm256_loadu_si256((const __m256i *) (s + 0));
+        __m256i b = _mm256_loadu_si256((const __m256i *) (s + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i *) (s + 64));
+        __m256i e = _mm256_loadu_si256((const __m256i *) (s + 96));
+        _mm256_stream_si256((__m256i *) (d + 0), a);
+        _mm256_stream_si256((__m256i *) (d + 32), b);
+        _mm256_stream_si256((__m256i *) (d + 64), c);
+        _mm256_stream_si256((__m256i *) (d + 96), e);
+    }
+
+    _mm_sfence();
+
+    memcpy(d, s, n);
+}
+
+VVECTOR_AVX512
+void vvector_stream_copy_avx512_(void * dst, const void * src, ptrdiff_t n){
+    uint8_t * d = dst;
+    const uint8_t * s = src;
+
+    ptrdiff_t head = stream_copy_head(d, s, n, 64);
+    d += head;
+    s += head;
+    n -= head;
+
+    for (; n >= 256; n -= 256, d += 256, s += 256) {
+        __m512i a = _mm512_loadu_si512(s + 0);
+        __m512i b = _mm512_loadu_si512(s + 64);
+        __m512i c = _mm512_loadu_si512(s + 128);
+        __m512i e = _mm512_loadu_si512(s + 192);
+        _mm512_stream_si512((__m512i *) (d + 0), a);
+        _mm512_stream_si512((__m512i *) (d + 64), b);
+        _mm512_stream_si512((__m512i *) (d + 128), c);
+        _mm512_stream_si512((__m512i *) (d + 192), e);
+    }
+
+    _mm_sfence();
+
+    memcpy(d, s, n);
+}
+
+#endif // VVECTOR_X86
+
+// << GATHER >>
+
+void vvector_gather_u32_scalar_(const uint32_t * data, const ptrdiff_t * indices, ptrdiff_t n, uint32_t * out, ptrdiff_t distance){
+    ptrdiff_t i = 0;
+
+    for (; i + distance < n; i++) {
+        __builtin_prefetch(&data[indices[i + distance]]);
+        out[i] = data[indices[i]];
+    }
+
+    for (; i < n; i++) {
+        out[i] = data[indices[i]];
+    }
+}
+
+void vvector_gather_u64_scalar_(const uint64_t * data, const ptrdiff_t * indices, ptrdiff_t n, uint64_t * out, ptrdiff_t distance){
+    ptrdiff_t i = 0;
+
+    for (; i + distance < n; i++) {
+        __builtin_prefetch(&data[indices[i + distance]]);
+        out[i] = data[indices[i]];
+    }
+
+    for (; i < n; i++) {
+        out[i] = data[indices[i]];
+    }
+}
+
+#if VVECTOR_X86
+
+// The indices are 64 bit, so each gather instruction fetches 4 elements.
+
+VVECTOR_AVX2
+void vvector_gather_u32_avx2_(const uint32_t * data, const ptrdiff_t * indices, ptrdiff_t n, uint32_t * out, ptrdiff_t distance){
+    ptrdiff_t i = 0;
+
+    for (; i + 4 + distance <= n; i += 4) {
+        __builtin_prefetch(&data[indices[i + distance + 0]]);
+        __builtin_prefetch(&data[indices[i + distance + 1]]);
+        __builtin_prefetch(&data[indices[i + distance + 2]]);
+        __builtin_prefetch(&data[indices[i + distance + 3]]);
+
+        __m256i index = _mm256_loadu_si256((const __m256i *) &indices[i]);
+        __m128i values = _mm256_i64gather_epi32((const int *) data, index, 4);
+        _mm_storeu_si128((__m128i *) &out[i], values);
+    }
+
+    for (; i + 4 <= n; i += 4) {
+        __m256i index = _mm256_loadu_si256((const __m256i *) &indices[i]);
+        __m128i values = _mm256_i64gather_epi32((const int *) data, index, 4);
+        _mm_storeu_si128((__m128i *) &out[i], values);
+    }
+
+    for (; i < n; i++) {
+        out[i] = data[indices[i]];
+    }
+}
+
+VVECTOR_AVX2
+void vvector_gather_u64_avx2_(const uint64_t * data, const ptrdiff_t * indices, ptrdiff_t n, uint64_t * out, ptrdiff_t distance){
+    ptrdiff_t i = 0;
+
+    for (; i + 4 + distance <= n; i += 4) {
+        __builtin_prefetch(&data[indices[i + distance + 0]]);
+        __builtin_prefetch(&data[indices[i + distance + 1]]);
+        __builtin_prefetch(&data[indices[i + distance + 2]]);
+        __builtin_prefetch(&data[indices[i + distance + 3]]);
+
+        __m256i index = _mm256_loadu_si256((const __m256i *) &indices[i]);
+        __m256i values = _mm256_i64gather_epi64((const long long *) data, index, 8);
+        _mm256_storeu_si256((__m256i *) &out[i], values);
+    }
+
+    for (; i + 4 <= n; i += 4) {
+        __m256i index = _mm256_loadu_si256((const __m256i *) &indices[i]);
+        __m256i values = _mm256_i64gather_epi64((const long long *) data, index, 8);
+        _mm256_storeu_si256((__m256i *) &out[i], values);
+    }
+
+    for (; i < n; i++) {
+        out[i] = data[indices[i]];
+    }
+}
+
+#endif // VVECTOR_X86
+
+// << AXPY >>
+
+void vvector_axpy_f32_scalar_(float a, const float * x, float * y, ptrdiff_t n){
+    for (ptrdiff_t i = 0; i < n; i++) {
+        y[i] += a * x[i];
+    }
+}
+
+void vvector_axpy_f64_scalar_(double a, const double * x, double * y, ptrdiff_t n){
+    for (ptrdiff_t i = 0; i < n; i++) {
+        y[i] += a * x[i];
+    }
+}
+
+#if VVECTOR_X86
+
+// No FMA: a fused multiply-add rounds once, which would make results depend on the CPU.
+
+VVECTOR_AVX2
+void vvector_axpy_f32_avx2_(float a, const float * x, float * y, ptrdiff_t n){
+    const __m256 scale = _mm256_set1_ps(a);
+    ptrdiff_t i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m256 y0 = _mm256_add_ps(_mm256_loadu_ps(&y[i + 0]), _mm256_mul_ps(scale, _mm256_loadu_ps(&x[i + 0])));
+        __m256 y1 = _mm256_add_ps(_mm256_loadu_ps(&y[i + 8]), _mm256_mul_ps(scale, _mm256_loadu_ps(&x[i + 8])));
+        _mm256_storeu_ps(&y[i + 0], y0);
+        _mm256_storeu_ps(&y[i + 8], y1);
+    }
+
+    for (; i < n; i++) {
+        y[i] += a * x[i];
+    }
+}
+
+VVECTOR_AVX2
+void vvector_axpy_f64_avx2_(double a, const double * x, double * y, ptrdiff_t n){
+    const __m256d scale = _mm256_set1_pd(a);
+    ptrdiff_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256d y0 = _mm256_add_pd(_mm256_loadu_pd(&y[i + 0]), _mm256_mul_pd(scale, _mm256_loadu_pd(&x[i + 0])));
+        __m256d y1 = _mm256_add_pd(_mm256_loadu_pd(&y[i + 4]), _mm256_mul_pd(scale, _mm256_loadu_pd(&x[i + 4])));
+        _mm256_storeu_pd(&y[i + 0], y0);
+        _mm256_storeu_pd(&y[i + 4], y1);
+    }
+
+    for (; i < n; i++) {
+        y[i] += a * x[i];
+    }
+}
+
+VVECTOR_AVX512
+void vvector_axpy_f32_avx512_(float a, const float * x, float * y, ptrdiff_t n){
+    const __m512 scale = _mm512_set1_ps(a);
+    ptrdiff_t i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m512 sum = _mm512_add_ps(_mm512_loadu_ps(&y[i]), _mm512_mul_ps(scale, _mm512_loadu_ps(&x[i])));
+        _mm512_storeu_ps(&y[i], sum);
+    }
+
+    if (i < n) {
+        __mmask16 tail = (__mmask16) ((1u << (n - i)) - 1);
+        __m512 sum = _mm512_add_ps(_mm512_maskz_loadu_ps(tail, &y[i]), _mm512_mul_ps(scale, _mm512_maskz_loadu_ps(tail, &x[i])));
+        _mm512_mask_storeu_ps(&y[i], tail, sum);
+    }
+}
+
+VVECTOR_AVX512
+void vvector_axpy_f64_avx512_(double a, const double * x, double * y, ptrdiff_t n){
+    const __m512d scale = _mm512_set1_pd(a);
+    ptrdiff_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m512d sum = _mm512_add_pd(_mm512_loadu_pd(&y[i]), _mm512_mul_pd(scale, _mm512_loadu_pd(&x[i])));
+        _mm512_storeu_pd(&y[i], sum);
+    }
+
+    if (i < n) {
+        __mmask8 tail = (__mmask8) ((1u << (n - i)) - 1);
+        __m512d sum = _mm512_add_pd(_mm512_maskz_loadu_pd(tail, &y[i]), _mm512_mul_pd(scale, _mm512_maskz_loadu_pd(tail, &x[i])));
+        _mm512_mask_storeu_pd(&y[i], tail, sum);
+    }
+}
+
+#endif // VVECTOR_X86
+
+// << COMPARE >>
+
+/*
+ * Every variant handles whole 64 element words and leaves the last, partial word to the scalar variant.
+ * The switch on 'op' runs once per vector; it is loop invariant, so the branch is always predicted.
+ */
+
+#define COMPARE_SCALAR_LOOP(EXPR)                           \
+    for (int j = 0; j < end; j++) {                         \
+        TYPE v = x[base + j];                               \
+        TYPE c = y ? y[base + j] : a;                       \
+        bits |= (uint64_t) (EXPR) << j;                     \
+    }
+
+#define COMPARE_SCALAR(NAME, T)                                                                         \
+void NAME(const T * x, const T * y, T a, T b, int op, ptrdiff_t n, uint64_t * bitmap){                  \
+    typedef T TYPE;                                                                                     \
+    for (ptrdiff_t w = 0; w * 64 < n; w++) {                                                            \
+        ptrdiff_t base = w * 64;                                                                        \
+        int end = (n - base < 64) ? (int) (n - base) : 64;                                              \
+        uint64_t bits = 0;                                                                              \
+        switch (op) {                                                                                   \
+            case VVECTOR_EQ: COMPARE_SCALAR_LOOP(v == c); break;                                        \
+            case VVECTOR_NE: COMPARE_SCALAR_LOOP(v != c); break;                                        \
+            case VVECTOR_LT: COMPARE_SCALAR_LOOP(v < c); break;                                         \
+            case VVECTOR_LE: COMPARE_SCALAR_LOOP(v <= c); break;                                        \
+            case VVECTOR_GT: COMPARE_SCALAR_LOOP(v > c); break;                                         \
+            case VVECTOR_GE: COMPARE_SCALAR_LOOP(v >= c); break;                                        \
+            case VVECTOR_BETWEEN: COMPARE_SCALAR_LOOP(((void) c, v >= a && v <= b)); break;              \
+            default: break;                                                                             \
+        }                                                                                               \
+        bitmap[w] = bits;                                                                               \
+    }                                                                                                   \
+}
+
+COMPARE_SCALAR(vvector_compare_i8_scalar_, int8_t)
+COMPARE_SCALAR(vvector_compare_i16_scalar_, int16_t)
+COMPARE_SCALAR(vvector_compare_i32_scalar_, int32_t)
+COMPARE_SCALAR(vvector_compare_i64_scalar_, int64_t)
+COMPARE_SCALAR(vvector_compare_f32_scalar_, float)
+COMPARE_SCALAR(vvector_compare_f64_scalar_, double)
+
+#if VVECTOR_X86
+
+/*
+ * SIMD variants are built from one function per type and ISA, which compares a vector of LANES elements
+ * and returns one bit per lane. 'y' replaces the broadcast constant 'a' for column vs column comparisons.
+ */
+#define COMPARE_SIMD(NAME, T, VEC, LANES, LOAD, SET1, COMPARE_VECTOR, SCALAR)                           \
+void NAME(const T * x, const T * y, T a, T b, int op, ptrdiff_t n, uint64_t * bitmap){                  \
+    const VEC va = SET1(a);                                                                             \
+    const VEC vb = SET1(b);                                                                             \
+    ptrdiff_t nr_words = n / 64;                                                                        \
+                                                                                                        \
+    for (ptrdiff_t w = 0; w < nr_words; w++) {                                                          \
+        uint64_t bits = 0;                                                                              \
+        for (int j = 0; j < 64; j += LANES) {                                                           \
+            ptrdiff_t i = w * 64 + j;                                                                   \
+            VEC vy = y ? LOAD(&y[i]) : va;                                                              \
+            bits |= (uint64_t) COMPARE_VECTOR(LOAD(&x[i]), vy, vb, op) << j;                            \
+        }                                                                                               \
+        bitmap[w] = bits;                                                                               \
+    }                                                                                                   \
+                                                                                                        \
+    ptrdiff_t done = nr_words * 64;                                                                     \
+    if (done < n) SCALAR(x + done, y ? y + done : 0, a, b, op, n - done, bitmap + nr_words);            \
+}
+
+/*
+ * AVX2 integer compares only come as == and signed >, the other operators are built from them.
+ * Float compares take the predicate directly; the ordered ones are false for NaN, like C.
+ */
+#define AVX2_INT_COMPARE(NAME, MOVEMASK, CMPEQ, CMPGT, LANE_MASK)                                       \
+VVECTOR_AVX2                                                                                            \
+static inline uint64_t NAME(__m256i x, __m256i a, __m256i b, int op){                                   \
+    switch (op) {                                                                                       \
+        case VVECTOR_EQ: return MOVEMASK(CMPEQ(x, a));                                                  \
+        case VVECTOR_NE: return ~MOVEMASK(CMPEQ(x, a)) & LANE_MASK;                                     \
+        case VVECTOR_LT: return MOVEMASK(CMPGT(a, x));                                                  \
+        case VVECTOR_LE: return ~MOVEMASK(CMPGT(x, a)) & LANE_MASK;                                     \
+        case VVECTOR_GT: return MOVEMASK(CMPGT(x, a));                                                  \
+        case VVECTOR_GE: return ~MOVEMASK(CMPGT(a, x)) & LANE_MASK;                                     \
+        case VVECTOR_BETWEEN: return ~(MOVEMASK(CMPGT(a, x)) | MOVEMASK(CMPGT(x, b))) & LANE_MASK;     \
+        default: return 0;                                                                              \
+    }                                                                                                   \
+}
+
+#define AVX2_LOAD_SI256(p) _mm256_loadu_si256((const __m256i *) (p))
+
+// Lane masks, widened to 64 bits so ~ does not spill into the next vector's bits.
+#define AVX2_MOVEMASK_8(v) ((uint64_t) (uint32_t) _mm256_movemask_epi8(v))
+// Packing to bytes interleaves the 128 bit halves, the permute puts them back in order.
+#define AVX2_MOVEMASK_16(v) ((uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_permute4x64_epi64(_mm256_packs_epi16((v), _mm256_setzero_si256()), 0xD8)) & 0xFFFF)
+#define AVX2_MOVEMASK_32(v) ((uint64_t) _mm256_movemask_ps(_mm256_castsi256_ps(v)))
+#define AVX2_MOVEMASK_64(v) ((uint64_t) _mm256_movemask_pd(_mm256_castsi256_pd(v)))
+
+AVX2_INT_COMPARE(compare_vector_i8_avx2, AVX2_MOVEMASK_8, _mm256_cmpeq_epi8, _mm256_cmpgt_epi8, 0xFFFFFFFFull)
+AVX2_INT_COMPARE(compare_vector_i16_avx2, AVX2_MOVEMASK_16, _mm256_cmpeq_epi16, _mm256_cmpgt_epi16, 0xFFFFull)
+AVX2_INT_COMPARE(compare_vector_i32_avx2, AVX2_MOVEMASK_32, _mm256_cmpeq_epi32, _mm256_cmpgt_epi32, 0xFFull)
+AVX2_INT_COMPARE(compare_vector_i64_avx2, AVX2_MOVEMASK_64, _mm256_cmpeq_epi64, _mm256_cmpgt_epi64, 0xFull)
+
+#define AVX2_FLOAT_COMPARE(NAME, VEC, CMP, MOVEMASK)                                                    \
+VVECTOR_AVX2                                                                                            \
+static inline uint64_t NAME(VEC x, VEC a, VEC b, int op){                                               \
+    switch (op) {                                                                                       \
+        case VVECTOR_EQ: return (uint64_t) MOVEMASK(CMP(x, a, _CMP_EQ_OQ));                             \
+        case VVECTOR_NE: return (uint64_t) MOVEMASK(CMP(x, a, _CMP_NEQ_UQ));                            \
+        case VVECTOR_LT: return (uint64_t) MOVEMASK(CMP(x, a, _CMP_LT_OQ));                             \
+        case VVECTOR_LE: return (uint64_t) MOVEMASK(CMP(x, a, _CMP_LE_OQ));                             \
+        case VVECTOR_GT: return (uint64_t) MOVEMASK(CMP(x, a, _CMP_GT_OQ));                             \
+        case VVECTOR_GE: return (uint64_t) MOVEMASK(CMP(x, a, _CMP_GE_OQ));                             \
+        case VVECTOR_BETWEEN: return (uint64_t) (MOVEMASK(CMP(x, a, _CMP_GE_OQ)) & MOVEMASK(CMP(x, b, _CMP_LE_OQ))); \
+        default: return 0;                                                                              \
+    }                                                                                                   \
+}
+
+AVX2_FLOAT_COMPARE(compare_vector_f32_avx2, __m256, _mm256_cmp_ps, _mm256_movemask_ps)
+AVX2_FLOAT_COMPARE(compare_vector_f64_avx2, __m256d, _mm256_cmp_pd, _mm256_movemask_pd)
+
+VVECTOR_AVX2 COMPARE_SIMD(vvector_compare_i8_avx2_, int8_t, __m256i, 32, AVX2_LOAD_SI256, _mm256_set1_epi8, compare_vector_i8_avx2, vvector_compare_i8_scalar_)
+VVECTOR_AVX2 COMPARE_SIMD(vvector_compare_i16_avx2_, int16_t, __m256i, 16, AVX2_LOAD_SI256, _mm256_set1_epi16, compare_vector_i16_avx2, vvector_compare_i16_scalar_)
+VVECTOR_AVX2 COMPARE_SIMD(vvector_compare_i32_avx2_, int32_t, __m256i, 8, AVX2_LOAD_SI256, _mm256_set1_epi32, compare_vector_i32_avx2, vvector_compare_i32_scalar_)
+VVECTOR_AVX2 COMPARE_SIMD(vvector_compare_i64_avx2_, int64_t, __m256i, 4, AVX2_LOAD_SI256, _mm256_set1_epi64x, compare_vector_i64_avx2, vvector_compare_i64_scalar_)
+VVECTOR_AVX2 COMPARE_SIMD(vvector_compare_f32_avx2_, float, __m256, 8, _mm256_loadu_ps, _mm256_set1_ps, compare_vector_f32_avx2, vvector_compare_f32_scalar_)
+VVECTOR_AVX2 COMPARE_SIMD(vvector_compare_f64_avx2_, double, __m256d, 4, _mm256_loadu_pd, _mm256_set1_pd, compare_vector_f64_avx2, vvector_compare_f64_scalar_)
+
+// AVX-512 compares write a mask register directly, for every type and predicate.
+
+#define AVX512_INT_COMPARE(NAME, CMP)                                                                   \
+VVECTOR_AVX512                                                                                          \
+static inline uint64_t NAME(__m512i x, __m512i a, __m512i b, int op){                                   \
+    switch (op) {                                                                                       \
+        case VVECTOR_EQ: return (uint64_t) CMP(x, a, _MM_CMPINT_EQ);                                    \
+        case VVECTOR_NE: return (uint64_t) CMP(x, a, _MM_CMPINT_NE);                                    \
+        case VVECTOR_LT: return (uint64_t) CMP(x, a, _MM_CMPINT_LT);                                    \
+        case VVECTOR_LE: return (uint64_t) CMP(x, a, _MM_CMPINT_LE);                                    \
+        case VVECTOR_GT: return (uint64_t) CMP(x, a, _MM_CMPINT_NLE);                                   \
+        case VVECTOR_GE: return (uint64_t) CMP(x, a, _MM_CMPINT_NLT);                                   \
+        case VVECTOR_BETWEEN: return (uint64_t) (CMP(x, a, _MM_CMPINT_NLT) & CMP(x, b, _MM_CMPINT_LE)); \
+        default: return 0;                                                                              \
+    }                                                                                                   \
+}
+
+AVX512_INT_COMPARE(compare_vector_i8_avx512, _mm512_cmp_epi8_mask)
+AVX512_INT_COMPARE(compare_vector_i16_avx512, _mm512_cmp_epi16_mask)
+AVX512_INT_COMPARE(compare_vector_i32_avx512, _mm512_cmp_epi32_mask)
+AVX512_INT_COMPARE(compare_vector_i64_avx512, _mm512_cmp_epi64_mask)
+
+#define AVX512_FLOAT_COMPARE(NAME, VEC, CMP)                                                            \
+VVECTOR_AVX512                                                                                          \
+static inline uint64_t NAME(VEC x, VEC a, VEC b, int op){                                               \
+    switch (op) {                                                                                       \
+        case VVECTOR_EQ: return (uint64_t) CMP(x, a, _CMP_EQ_OQ);                                       \
+        case VVECTOR_NE: return (uint64_t) CMP(x, a, _CMP_NEQ_UQ);                                      \
+        case VVECTOR_LT: return (uint64_t) CMP(x, a, _CMP_LT_OQ);                                       \
+        case VVECTOR_LE: return (uint64_t) CMP(x, a, _CMP_LE_OQ);                                       \
+        case VVECTOR_GT: return (uint64_t) CMP(x, a, _CMP_GT_OQ);                                       \
+        case VVECTOR_GE: return (uint64_t) CMP(x, a, _CMP_GE_OQ);                                       \
+        case VVECTOR_BETWEEN: return (uint64_t) (CMP(x, a, _CMP_GE_OQ) & CMP(x, b, _CMP_LE_OQ));       \
+        default: return 0;                                                                              \
+    }                                                                                                   \
+}
+
+AVX512_FLOAT_COMPARE(compare_vector_f32_avx512, __m512, _mm512_cmp_ps_mask)
+AVX512_FLOAT_COMPARE(compare_vector_f64_avx512, __m512d, _mm512_cmp_pd_mask)
+
+#define AVX512_LOAD_SI512(p) _mm512_loadu_si512((const void *) (p))
+
+VVECTOR_AVX512 COMPARE_SIMD(vvector_compare_i8_avx512_, int8_t, __m512i, 64, AVX512_LOAD_SI512, _mm512_set1_epi8, compare_vector_i8_avx512, vvector_compare_i8_scalar_)
+VVECTOR_AVX512 COMPARE_SIMD(vvector_compare_i16_avx512_, int16_t, __m512i, 32, AVX512_LOAD_SI512, _mm512_set1_epi16, compare_vector_i16_avx512, vvector_compare_i16_scalar_)
+VVECTOR_AVX512 COMPARE_SIMD(vvector_compare_i32_avx512_, int32_t, __m512i, 16, AVX512_LOAD_SI512, _mm512_set1_epi32, compare_vector_i32_avx512, vvector_compare_i32_scalar_)
+VVECTOR_AVX512 COMPARE_SIMD(vvector_compare_i64_avx512_, int64_t, __m512i, 8, AVX512_LOAD_SI512, _mm512_set1_epi64, compare_vector_i64_avx512, vvector_compare_i64_scalar_)
+VVECTOR_AVX512 COMPARE_SIMD(vvector_compare_f32_avx512_, float, __m512, 16, _mm512_loadu_ps, _mm512_set1_ps, compare_vector_f32_avx512, vvector_compare_f32_scalar_)
+VVECTOR_AVX512 COMPARE_SIMD(vvector_compare_f64_avx512_, double, __m512d, 8, _mm512_loadu_pd, _mm512_set1_pd, compare_vector_f64_avx512, vvector_compare_f64_scalar_)
+
+#endif // VVECTOR_X86
+
+// << COMPRESS >>
+
+ptrdiff_t vvector_compress_u32_scalar_(const uint32_t * x, const uint64_t * bitmap, ptrdiff_t n, uint32_t * out){
+    ptrdiff_t count = 0;
+
+    for (ptrdiff_t w = 0; w * 64 < n; w++) {
+        uint64_t bits = bitmap[w];
+        if (n - w * 64 < 64) bits &= ((uint64_t) 1 << (n - w * 64)) - 1;
+
+        while (bits) {
+            out[count++] = x[w * 64 + __builtin_ctzll(bits)];
+            bits &= bits - 1;
+        }
+    }
+
+    return count;
+}
+
+ptrdiff_t vvector_compress_u64_scalar_(const uint64_t * x, const uint64_t * bitmap, ptrdiff_t n, uint64_t * out){
+    ptrdiff_t count = 0;
+
+    for (ptrdiff_t w = 0; w * 64 < n; w++) {
+        uint64_t bits = bitmap[w];
+        if (n - w * 64 < 64) bits &= ((uint64_t) 1 << (n - w * 64)) - 1;
+
+        while (bits) {
+            out[count++] = x[w * 64 + __builtin_ctzll(bits)];
+            bits &= bits - 1;
+        }
+    }
+
+    return count;
+}
+
+#if VVECTOR_X86
+
+// No AVX2 variant: without a compress instruction it needs a permutation lookup table, and the scalar loop is close for sparse bitmaps.
+
+VVECTOR_AVX512
+ptrdiff_t vvector_compress_u32_avx512_(const uint32_t * x, const uint64_t * bitmap, ptrdiff_t n, uint32_t * out){
+    ptrdiff_t nr_words = n / 64;
+    ptrdiff_t count = 0;
+
+    for (ptrdiff_t w = 0; w < nr_words; w++) {
+        uint64_t bits = bitmap[w];
+
+        for (int j = 0; j < 64; j += 16) {
+            __mmask16 mask = (__mmask16) (bits >> j);
+            _mm512_mask_compressstoreu_epi32(&out[count], mask, _mm512_loadu_si512(&x[w * 64 + j]));
+            count += __builtin_popcount(mask);
+        }
+    }
+
+    return count + vvector_compress_u32_scalar_(x + nr_words * 64, bitmap + nr_words, n - nr_words * 64, out + count);
+}
+
+VVECTOR_AVX512
+ptrdiff_t vvector_compress_u64_avx512_(const uint64_t * x, const uint64_t * bitmap, ptrdiff_t n, uint64_t * out){
+    ptrdiff_t nr_words = n / 64;
+    ptrdiff_t count = 0;
+
+    for (ptrdiff_t w = 0; w < nr_words; w++) {
+        uint64_t bits = bitmap[w];
+
+        for (int j = 0; j < 64; j += 8) {
+            __mmask8 mask = (__mmask8) (bits >> j);
+            _mm512_mask_compressstoreu_epi64(&out[count], mask, _mm512_loadu_si512(&x[w * 64 + j]));
+            count += __builtin_popcount(mask);
+        }
+    }
+
+    return count + vvector_compress_u64_scalar_(x + nr_words * 64, bitmap + nr_words, n - nr_words * 64, out + count);
+}
+
+#endif // VVECTOR_X86
+
+// << SMALL SORT >>
+
+/*
+ * Floats are sorted as the integers key(bits) = bits ^ ((bits >> 31) >>> 1): negative floats get every bit but the sign flipped,
+ * so signed integer order is the order of the floats and NaNs land at either end instead of breaking the comparisons.
+ * The mapping is its own inverse. Every variant copies the input into a buffer of keys, sorts it and copies it back.
+ */
+
+static inline int32_t sort_key_f32(int32_t bits){
+    return bits ^ (int32_t) ((uint32_t) (bits >> 31) >> 1);
+}
+
+static inline int64_t sort_key_f64(int64_t bits){
+    return bits ^ (int64_t) ((uint64_t) (bits >> 63) >> 1);
+}
+
+#define SORT_KEY_SAME(x) (x)
+
+#define SMALL_SORT_SCALAR(NAME, T, KEY, TO_KEY)                                                         \
+void NAME(T * data, ptrdiff_t n){                                                                       \
+    KEY buf[VVECTOR_SMALL_SORT_MAX];                                                                    \
+                                                                                                        \
+    memcpy(buf, data, n * sizeof(KEY));                                                                 \
+    for (ptrdiff_t i = 0; i < n; i++) buf[i] = TO_KEY(buf[i]);                                          \
+                                                                                                        \
+    for (ptrdiff_t i = 1; i < n; i++) {                                                                 \
+        KEY key = buf[i];                                                                               \
+        ptrdiff_t j = i;                                                                                \
+        for (; j > 0 && buf[j - 1] > key; j--) buf[j] = buf[j - 1];                                     \
+        buf[j] = key;                                                                                   \
+    }                                                                                                   \
+                                                                                                        \
+    for (ptrdiff_t i = 0; i < n; i++) buf[i] = TO_KEY(buf[i]);                                          \
+    memcpy(data, buf, n * sizeof(KEY));                                                                 \
+}
+
+SMALL_SORT_SCALAR(vvector_sort_i32_scalar_, int32_t, int32_t, SORT_KEY_SAME)
+SMALL_SORT_SCALAR(vvector_sort_i64_scalar_, int64_t, int64_t, SORT_KEY_SAME)
+SMALL_SORT_SCALAR(vvector_sort_f32_scalar_, float, int32_t, sort_key_f32)
+SMALL_SORT_SCALAR(vvector_sort_f64_scalar_, double, int64_t, sort_key_f64)
+
+#if VVECTOR_X86
+
+/*
+ * Bitonic sorting network over a power of two number of keys, at least one vector. Every step compare-exchanges
+ * the keys 'j' apart; within blocks of 'k' keys, ascending where the bit 'k' of the position is clear, descending elsewhere.
+ * Steps with j >= LANES pair whole vectors. Smaller ones pair the lanes of one vector with a permutation, LANE_INDEX(j),
+ * and blend the minimum and maximum: a lane takes the maximum when exactly one of the bits 'j' and 'k' of its position is set.
+ * LANE_MASK(j, k) computes that for the first vector, and the blocks of 'k' >= LANES keys which sort descending use its inverse.
+ * The network has no data dependent branches.
+ */
+#define BITONIC_SIMD(NAME, KEY, VEC, MASK, LANES, LOAD, STORE, MIN, MAX, LANE_INDEX, LANE_MASK, INVERT_MASK, EXCHANGE_LANES) \
+static void NAME(KEY * buf, ptrdiff_t size){                                                            \
+    for (ptrdiff_t k = 2; k <= size; k <<= 1) {                                                         \
+        for (ptrdiff_t j = k >> 1; j > 0; j >>= 1) {                                                    \
+            if (j >= LANES) {                                                                           \
+                for (ptrdiff_t i = 0; i < size; i += LANES) {                                           \
+                    if (i & j) continue;                                                                \
+                    VEC a = LOAD(&buf[i]);                                                              \
+                    VEC b = LOAD(&buf[i + j]);                                                          \
+                    VEC lo = MIN(a, b);                                                                 \
+                    VEC hi = MAX(a, b);                                                                 \
+                    STORE(&buf[i], (i & k) ? hi : lo);                                                  \
+                    STORE(&buf[i + j], (i & k) ? lo : hi);                                              \
+                }                                                                                       \
+            } else {                                                                                    \
+                VEC index = LANE_INDEX((int) j);                                                        \
+                MASK up = LANE_MASK((int) j, (int) k);                                                  \
+                MASK down = INVERT_MASK(up);                                                            \
+                for (ptrdiff_t i = 0; i < size; i += LANES) {                                           \
+                    STORE(&buf[i], EXCHANGE_LANES(LOAD(&buf[i]), index, (i & k) ? down : up));         \
+                }                                                                                       \
+            }                                                                                           \
+        }                                                                                               \
+    }                                                                                                   \
+}
+
+/*
+ * The input is padded with the largest key up to a power of two, which the network moves past the real keys.
+ */
+#define SMALL_SORT_SIMD(NAME, T, KEY, LANES, BITONIC, KEY_MAX, TO_KEY)                                  \
+void NAME(T * data, ptrdiff_t n){                                                                       \
+    KEY buf[VVECTOR_SMALL_SORT_MAX] __attribute__((aligned(64)));                                       \
+    ptrdiff_t size = LANES;                                                                             \
+                                                                                                        \
+    if (n < 2) return;                                                                                  \
+    while (size < n) size <<= 1;                                                                        \
+                                                                                                        \
+    memcpy(buf, data, n * sizeof(KEY));                                                                 \
+    for (ptrdiff_t i = 0; i < n; i++) buf[i] = TO_KEY(buf[i]);                                          \
+    for (ptrdiff_t i = n; i < size; i++) buf[i] = KEY_MAX;                                              \
+                                                                                                        \
+    BITONIC(buf, size);                                                                                 \
+                                                                                                        \
+    for (ptrdiff_t i = 0; i < n; i++) buf[i] = TO_KEY(buf[i]);                                          \
+    memcpy(data, buf, n * sizeof(KEY));                                                                 \
+}
+
+#define AVX2_STORE_SI256(p, v) _mm256_storeu_si256((__m256i *) (p), (v))
+#define AVX2_INVERT_MASK(m) _mm256_xor_si256((m), _mm256_set1_epi32(-1))
+
+VVECTOR_AVX2
+static inline __m256i lane_index_i32_avx2(int j){
+    return _mm256_xor_si256(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(j));
+}
+
+VVECTOR_AVX2
+static inline __m256i lane_mask_i32_avx2(int j, int k){
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i zero = _mm256_setzero_si256();
+
+    return _mm256_xor_si256(_mm256_cmpeq_epi32(_mm256_and_si256(lane, _mm256_set1_epi32(j)), zero),
+                            _mm256_cmpeq_epi32(_mm256_and_si256(lane, _mm256_set1_epi32(k)), zero));
+}
+
+VVECTOR_AVX2
+static inline __m256i exchange_lanes_i32_avx2(__m256i x, __m256i index, __m256i take_max){
+    __m256i y = _mm256_permutevar8x32_epi32(x, index);
+
+    return _mm256_blendv_epi8(_mm256_min_epi32(x, y), _mm256_max_epi32(x, y), take_max);
+}
+
+// AVX2 has no 64 bit min and max, they are a signed compare and a blend.
+VVECTOR_AVX2
+static inline __m256i min_i64_avx2(__m256i a, __m256i b){
+    return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+}
+
+VVECTOR_AVX2
+static inline __m256i max_i64_avx2(__m256i a, __m256i b){
+    return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b));
+}
+
+// Lane q is dwords 2q and 2q + 1, so lane q ^ j is dwords (2q) ^ 2j and (2q + 1) ^ 2j.
+VVECTOR_AVX2
+static inline __m256i lane_index_i64_avx2(int j){
+    return lane_index_i32_avx2(2 * j);
+}
+
+VVECTOR_AVX2
+static inline __m256i lane_mask_i64_avx2(int j, int k){
+    const __m256i lane = _mm256_setr_epi64x(0, 1, 2, 3);
+    const __m256i zero = _mm256_setzero_si256();
+
+    return _mm256_xor_si256(_mm256_cmpeq_epi64(_mm256_and_si256(lane, _mm256_set1_epi64x(j)), zero),
+                            _mm256_cmpeq_epi64(_mm256_and_si256(lane, _mm256_set1_epi64x(k)), zero));
+}
+
+VVECTOR_AVX2
+static inline __m256i exchange_lanes_i64_avx2(__m256i x, __m256i index, __m256i take_max){
+    __m256i y = _mm256_permutevar8x32_epi32(x, index);
+    __m256i greater = _mm256_cmpgt_epi64(x, y);
+
+    // The lanes taking the maximum keep x where it is greater, the others where it is not.
+    return _mm256_blendv_epi8(y, x, _mm256_xor_si256(greater, AVX2_INVERT_MASK(take_max)));
+}
+
+VVECTOR_AVX2 BITONIC_SIMD(bitonic_i32_avx2, int32_t, __m256i, __m256i, 8, AVX2_LOAD_SI256, AVX2_STORE_SI256, _mm256_min_epi32, _mm256_max_epi32,
+                          lane_index_i32_avx2, lane_mask_i32_avx2, AVX2_INVERT_MASK, exchange_lanes_i32_avx2)
+VVECTOR_AVX2 BITONIC_SIMD(bitonic_i64_avx2, int64_t, __m256i, __m256i, 4, AVX2_LOAD_SI256, AVX2_STORE_SI256, min_i64_avx2, max_i64_avx2,
+                          lane_index_i64_avx2, lane_mask_i64_avx2, AVX2_INVERT_MASK, exchange_lanes_i64_avx2)
+
+VVECTOR_AVX2 SMALL_SORT_SIMD(vvector_sort_i32_avx2_, int32_t, int32_t, 8, bitonic_i32_avx2, INT32_MAX, SORT_KEY_SAME)
+VVECTOR_AVX2 SMALL_SORT_SIMD(vvector_sort_i64_avx2_, int64_t, int64_t, 4, bitonic_i64_avx2, INT64_MAX, SORT_KEY_SAME)
+VVECTOR_AVX2 SMALL_SORT_SIMD(vvector_sort_f32_avx2_, float, int32_t, 8, bitonic_i32_avx2, INT32_MAX, sort_key_f32)
+VVECTOR_AVX2 SMALL_SORT_SIMD(vvector_sort_f64_avx2_, double, int64_t, 4, bitonic_i64_avx2, INT64_MAX, sort_key_f64)
+
+#define AVX512_STORE_SI512(p, v) _mm512_storeu_si512((void *) (p), (v))
+
+#define AVX512_INVERT_MASK(m) (~(m))
+
+VVECTOR_AVX512
+static inline __m512i lane_index_i32_avx512(int j){
+    return _mm512_xor_si512(_mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0), _mm512_set1_epi32(j));
+}
+
+VVECTOR_AVX512
+static inline __mmask16 lane_mask_i32_avx512(int j, int k){
+    const __m512i lane = _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+
+    return _mm512_test_epi32_mask(lane, _mm512_set1_epi32(j)) ^ _mm512_test_epi32_mask(lane, _mm512_set1_epi32(k));
+}
+
+VVECTOR_AVX512
+static inline __m512i exchange_lanes_i32_avx512(__m512i x, __m512i index, __mmask16 take_max){
+    __m512i y = _mm512_permutexvar_epi32(index, x);
+
+    return _mm512_mask_blend_epi32(take_max, _mm512_min_epi32(x, y), _mm512_max_epi32(x, y));
+}
+
+VVECTOR_AVX512
+static inline __m512i lane_index_i64_avx512(int j){
+    return _mm512_xor_si512(_mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0), _mm512_set1_epi64(j));
+}
+
+VVECTOR_AVX512
+static inline __mmask8 lane_mask_i64_avx512(int j, int k){
+    const __m512i lane = _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0);
+
+    return _mm512_test_epi64_mask(lane, _mm512_set1_epi64(j)) ^ _mm512_test_epi64_mask(lane, _mm512_set1_epi64(k));
+}
+
+VVECTOR_AVX512
+static inline __m512i exchange_lanes_i64_avx512(__m512i x, __m512i index, __mmask8 take_max){
+    __m512i y = _mm512_permutexvar_epi64(index, x);
+
+    return _mm512_mask_blend_epi64(take_max, _mm512_min_epi64(x, y), _mm512_max_epi64(x, y));
+}
+
+VVECTOR_AVX512 BITONIC_SIMD(bitonic_i32_avx512, int32_t, __m512i, __mmask16, 16, AVX512_LOAD_SI512, AVX512_STORE_SI512, _mm512_min_epi32, _mm512_max_epi32,
+                            lane_index_i32_avx512, lane_mask_i32_avx512, AVX512_INVERT_MASK, exchange_lanes_i32_avx512)
+VVECTOR_AVX512 BITONIC_SIMD(bitonic_i64_avx512, int64_t, __m512i, __mmask8, 8, AVX512_LOAD_SI512, AVX512_STORE_SI512, _mm512_min_epi64, _mm512_max_epi64,
+                            lane_index_i64_avx512, lane_mask_i64_avx512, AVX512_INVERT_MASK, exchange_lanes_i64_avx512)
+
+VVECTOR_AVX512 SMALL_SORT_SIMD(vvector_sort_i32_avx512_, int32_t, int32_t, 16, bitonic_i32_avx512, INT32_MAX, SORT_KEY_SAME)
+VVECTOR_AVX512 SMALL_SORT_SIMD(vvector_sort_i64_avx512_, int64_t, int64_t, 8, bitonic_i64_avx512, INT64_MAX, SORT_KEY_SAME)
+VVECTOR_AVX512 SMALL_SORT_SIMD(vvector_sort_f32_avx512_, float, int32_t, 16, bitonic_i32_avx512, INT32_MAX, sort_key_f32)
+VVECTOR_AVX512 SMALL_SORT_SIMD(vvector_sort_f64_avx512_, double, int64_t, 8, bitonic_i64_avx512, INT64_MAX, sort_key_f64)
+
+#endif // VVECTOR_X86
@@ -0,0 +1,340 @@
+/*
+    Copyright 2024 I. Laurentiu
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "vvector_matrix.h"
+#include "vvector_dispatch.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/// @file vvector_matrix.c
+
+#define VEC_ENOVEC 1        /**< Indicates that the provided matrix or vector argument is NULL. */
+#define VEC_EBADINDEX 2     /**< Indicates that the provided index or dimension is invalid. */
+#define VEC_ENOVALUE 3      /**< Indicates that the provided output pointer is NULL. */
+#define VEC_EMISMATCH 4     /**< Indicates that matrix shapes or element sizes do not fit together. */
+
+#define TRANSPOSE_BLOCK 32  /**< Transpose works on 32 x 32 element tiles, 4 KB (8 KB) for 4 (8) byte elements. Two tiles fit in L1. */
+#define MULTIPLY_BLOCK_K 128    /**< Rows of 'b' per panel. */
+#define MULTIPLY_BLOCK_M 256    /**< Columns of 'b' and 'c' per panel. A 128 x 256 panel of 'b' stays in L2. */
+
+/* Helpers */
+
+static int is_valid(struct vvectorMatrix * matrix){
+    return matrix && matrix->data && *matrix->data && vvectorGetLength(matrix->data) == matrix->rows * matrix->cols;
+}
+
+/**
+ * @internal
+ * @brief Distance, in elements, between (r, c) and (r + 1, c).
+ */
+static ptrdiff_t row_step(struct vvectorMatrix * matrix){
+    return (matrix->order == VVECTOR_ROW_MAJOR) ? matrix->cols : 1;
+}
+
+/**
+ * @internal
+ * @brief Distance, in elements, between (r, c) and (r, c + 1).
+ */
+static ptrdiff_t col_step(struct vvectorMatrix * matrix){
+    return (matrix->order == VVECTOR_ROW_MAJOR) ? 1 : matrix->rows;
+}
+
+// << TRANSPOSE >>
+
+/*
+ * Both orders reduce to the same problem: the buffer is a p x q row major array, which becomes a q x p one.
+ * For VVECTOR_ROW_MAJOR p = rows, for VVECTOR_COL_MAJOR p = cols.
+ */
+
+#define TRANSPOSE_TILES(TYPE)                                                               \
+    do {                                                                                    \
+        const TYPE * s = (const TYPE *) src;                                                \
+        TYPE * d = (TYPE *) dst;                                                            \
+        for (ptrdiff_t ii = 0; ii < p; ii += TRANSPOSE_BLOCK) {                             \
+            ptrdiff_t i_end = (ii + TRANSPOSE_BLOCK < p) ? ii + TRANSPOSE_BLOCK : p;        \
+            for (ptrdiff_t jj = 0; jj < q; jj += TRANSPOSE_BLOCK) {                         \
+                ptrdiff_t j_end = (jj + TRANSPOSE_BLOCK < q) ? jj + TRANSPOSE_BLOCK : q;    \
+                for (ptrdiff_t i = ii; i < i_end; i++) {                                    \
+                    for (ptrdiff_t j = jj; j < j_end; j++) {                                \
+                        d[j * p + i] = s[i * q + j];                                        \
+                    }                                                                       \
+                }                                                                           \
+            }                                                                               \
+        }                                                                                   \
+    } while (0)
+
+/**
+ * @internal
+ * @brief Transpose the p x q row major array 'src' into the q x p row major array 'dst', one tile at a time.
+ */
+static void transpose_copy(uint8_t * dst, const uint8_t * src, ptrdiff_t p, ptrdiff_t q, ptrdiff_t element_size){
+    switch (element_size) {
+        case 1: TRANSPOSE_TILES(uint8_t); return;
+        case 2: TRANSPOSE_TILES(uint16_t); return;
+        case 4: TRANSPOSE_TILES(uint32_t); return;
+        case 8: TRANSPOSE_TILES(uint64_t); return;
+        default: break;
+    }
+
+    for (ptrdiff_t ii = 0; ii < p; ii += TRANSPOSE_BLOCK) {
+        ptrdiff_t i_end = (ii + TRANSPOSE_BLOCK < p) ? ii + TRANSPOSE_BLOCK : p;
+        for (ptrdiff_t jj = 0; jj < q; jj += TRANSPOSE_BLOCK) {
+            ptrdiff_t j_end = (jj + TRANSPOSE_BLOCK < q) ? jj + TRANSPOSE_BLOCK : q;
+            for (ptrdiff_t i = ii; i < i_end; i++) {
+                for (ptrdiff_t j = jj; j < j_end; j++) {
+                    memcpy(&dst[(j * p + i) * element_size], &src[(i * q + j) * element_size], element_size);
+                }
+            }
+        }
+    }
+}
+
+#define TRANSPOSE_SWAP(TYPE, A, B)  \
+    do {                            \
+        TYPE t_ = (A);              \
+        (A) = (B);                  \
+        (B) = t_;                   \
+    } while (0)
+
+// Tiles on the diagonal are transposed in place, every other tile is swapped with its mirror.
+#define TRANSPOSE_SQUARE_TILES(TYPE)                                                        \
+    do {                                                                                    \
+        TYPE * d = (TYPE *) data;                                                           \
+        for (ptrdiff_t ii = 0; ii < n; ii += TRANSPOSE_BLOCK) {                             \
+            ptrdiff_t i_end = (ii + TRANSPOSE_BLOCK < n) ? ii + TRANSPOSE_BLOCK : n;        \
+            for (ptrdiff_t jj = ii; jj < n; jj += TRANSPOSE_BLOCK) {                        \
+                ptrdiff_t j_end = (jj + TRANSPOSE_BLOCK < n) ? jj + TRANSPOSE_BLOCK : n;    \
+                for (ptrdiff_t i = ii; i < i_end; i++) {                                    \
+                    for (ptrdiff_t j = (ii == jj) ? i + 1 : jj; j < j_end; j++) {           \
+                        TRANSPOSE_SWAP(TYPE, d[i * n + j], d[j * n + i]);                   \
+                    }                                                                       \
+                }                                                                           \
+            }                                                                               \
+        }                                                                                   \
+    } while (0)
+
+/**
+ * @internal
+ * @brief Transpose the n x n array 'data' in place, one pair of tiles at a time.
+ */
+static void transpose_square(uint8_t * data, ptrdiff_t n, ptrdiff_t element_size){
+    switch (element_size) {
+        case 1: TRANSPOSE_SQUARE_TILES(uint8_t); return;
+        case 2: TRANSPOSE_SQUARE_TILES(uint16_t); return;
+        case 4: TRANSPOSE_SQUARE_TILES(uint32_t); return;
+        case 8: TRANSPOSE_SQUARE_TILES(uint64_t); return;
+        default: break;
+    }
+
+    uint8_t tmp[256];
+
+    for (ptrdiff_t ii = 0; ii < n; ii += TRANSPOSE_BLOCK) {
+        ptrdiff_t i_end = (ii + TRANSPOSE_BLOCK < n) ? ii + TRANSPOSE_BLOCK : n;
+        for (ptrdiff_t jj = ii; jj < n; jj += TRANSPOSE_BLOCK) {
+            ptrdiff_t j_end = (jj + TRANSPOSE_BLOCK < n) ? jj + TRANSPOSE_BLOCK : n;
+            for (ptrdiff_t i = ii; i < i_end; i++) {
+                for (ptrdiff_t j = (ii == jj) ? i + 1 : jj; j < j_end; j++) {
+                    uint8_t * a = &data[(i * n + j) * element_size];
+                    uint8_t * b = &data[(j * n + i) * element_size];
+
+                    // Swap through a small buffer, in pieces for large elements.
+                    for (ptrdiff_t offset = 0; offset < element_size; offset += (ptrdiff_t) sizeof(tmp)) {
+                        ptrdiff_t size = (element_size - offset < (ptrdiff_t) sizeof(tmp)) ? element_size - offset : (ptrdiff_t) sizeof(tmp);
+                        memcpy(tmp, a + offset, size);
+                        memcpy(a + offset, b + offset, size);
+                        memcpy(b + offset, tmp, size);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* Matrix functions */
+
+int vvectorMatrixInit(struct vvectorMatrix * matrix, vvector data, ptrdiff_t rows, ptrdiff_t cols, enum vvectorMatrixOrder order){
+    if (!matrix || !data || !*data) return VEC_ENOVEC;
+
+    if (rows < 0 || cols < 0 || vvectorGetLength(data) != rows * cols) return VEC_EBADINDEX;
+
+    if (order != VVECTOR_ROW_MAJOR && order != VVECTOR_COL_MAJOR) return VEC_EBADINDEX;
+
+    matrix->data = data;
+    matrix->rows = rows;
+    matrix->cols = cols;
+    matrix->order = order;
+
+    return 0;
+}
+
+void * vvectorMatrixGetAt(struct vvectorMatrix * matrix, ptrdiff_t row, ptrdiff_t col){
+    if (!is_valid(matrix)) return 0;
+
+    if (row < 0 || row >= matrix->rows || col < 0 || col >= matrix->cols) return 0;
+
+    return vvectorGetAt(matrix->data, row * row_step(matrix) + col * col_step(matrix));
+}
+
+int vvectorMatrixGetRow(struct vvectorMatrix * matrix, ptrdiff_t row, struct vvectorStrided * out){
+    if (!is_valid(matrix)) return VEC_ENOVEC;
+
+    if (!out) return VEC_ENOVALUE;
+
+    if (row < 0 || row >= matrix->rows) return VEC_EBADINDEX;
+
+    out->length = matrix->cols;
+    out->stride = col_step(matrix) * vvectorGetElementSize(matrix->data);
+    out->data = (matrix->cols > 0) ? vvectorGetAt(matrix->data, row * row_step(matrix)) : 0;
+
+    return 0;
+}
+
+int vvectorMatrixGetCol(struct vvectorMatrix * matrix, ptrdiff_t col, struct vvectorStrided * out){
+    if (!is_valid(matrix)) return VEC_ENOVEC;
+
+    if (!out) return VEC_ENOVALUE;
+
+    if (col < 0 || col >= matrix->cols) return VEC_EBADINDEX;
+
+    out->length = matrix->rows;
+    out->stride = row_step(matrix) * vvectorGetElementSize(matrix->data);
+    out->data = (matrix->rows > 0) ? vvectorGetAt(matrix->data, col * col_step(matrix)) : 0;
+
+    return 0;
+}
+
+int vvectorMatrixTranspose(struct vvectorMatrix * matrix){
+    if (!is_valid(matrix)) return VEC_ENOVEC;
+
+    ptrdiff_t element_size = vvectorGetElementSize(matrix->data);
+    ptrdiff_t p = (matrix->order == VVECTOR_ROW_MAJOR) ? matrix->rows : matrix->cols;
+    ptrdiff_t q = (matrix->order == VVECTOR_ROW_MAJOR) ? matrix->cols : matrix->rows;
+
+    if (p == q) {
+        if (p > 0) transpose_square(vvectorGetFront(matrix->data), p, element_size);
+    } else if (p > 1 && q > 1) {
+        // The clone uses the same allocator as the matrix.
+        vvector copy = vvectorClone(matrix->data, VVECTOR_COPY_CACHED);
+        if (!copy) return VEC_ENOVEC;
+
+        transpose_copy(vvectorGetFront(matrix->data), vvectorGetFront(copy), p, q, element_size);
+        vvectorFree(copy);
+    }
+    // A single row or column has the same layout as its transpose.
+
+    ptrdiff_t rows = matrix->rows;
+    matrix->rows = matrix->cols;
+    matrix->cols = rows;
+
+    return 0;
+}
+
+int vvectorMatrixTransposeTo(struct vvectorMatrix * src, struct vvectorMatrix * dst){
+    if (!is_valid(src) || !is_valid(dst)) return VEC_ENOVEC;
+
+    ptrdiff_t element_size = vvectorGetElementSize(src->data);
+
+    if (dst->rows != src->cols || dst->cols != src->rows || vvectorGetElementSize(dst->data) != element_size) {
+        return VEC_EMISMATCH;
+    }
+
+    if (src->rows * src->cols == 0) return 0;
+
+    if (src->order != dst->order) {
+        memcpy(vvectorGetFront(dst->data), vvectorGetFront(src->data), src->rows * src->cols * element_size);
+        return 0;
+    }
+
+    ptrdiff_t p = (src->order == VVECTOR_ROW_MAJOR) ? src->rows : src->cols;
+    ptrdiff_t q = (src->order == VVECTOR_ROW_MAJOR) ? src->cols : src->rows;
+
+    transpose_copy(vvectorGetFront(dst->data), vvectorGetFront(src->data), p, q, element_size);
+
+    return 0;
+}
+
+// << MULTIPLY >>
+
+/**
+ * @internal
+ * @brief Check that a, b and c are valid, of 'element_size' and of matching shapes.
+ */
+static int check_multiply(struct vvectorMatrix * a, struct vvectorMatrix * b, struct vvectorMatrix * c, ptrdiff_t element_size){
+    if (!is_valid(a) || !is_valid(b) || !is_valid(c)) return VEC_ENOVEC;
+
+    if (vvectorGetElementSize(a->data) != element_size || vvectorGetElementSize(b->data) != element_size || vvectorGetElementSize(c->data) != element_size) {
+        return VEC_EMISMATCH;
+    }
+
+    if (a->cols != b->rows || c->rows != a->rows || c->cols != b->cols) return VEC_EMISMATCH;
+
+    if (c->data == a->data || c->data == b->data) return VEC_EMISMATCH;
+
+    return 0;
+}
+
+/*
+ * c is zeroed, then for each panel of 'b' (MULTIPLY_BLOCK_K x MULTIPLY_BLOCK_M), every row of 'a' adds
+ * a[i][k] * b[k][jj..] to c[i][jj..]. The panel is reused by every row of 'a' while it is in cache.
+ * With row major 'b' and 'c', the update is the dispatched axpy kernel.
+ */
+#define MATRIX_MULTIPLY(TYPE, AXPY)                                                                                     \
+    do {                                                                                                                \
+        int err = check_multiply(a, b, c, sizeof(TYPE));                                                                \
+        if (err) return err;                                                                                            \
+                                                                                                                        \
+        ptrdiff_t n = a->rows, k = a->cols, m = b->cols;                                                                \
+        if (n * m == 0) return 0;                                                                                       \
+                                                                                                                        \
+        TYPE * c_data = vvectorGetFront(c->data);                                                                       \
+        memset(c_data, 0, n * m * sizeof(TYPE));                                                                        \
+        if (k == 0) return 0;                                                                                           \
+                                                                                                                        \
+        const TYPE * a_data = vvectorGetFront(a->data);                                                                 \
+        const TYPE * b_data = vvectorGetFront(b->data);                                                                 \
+        ptrdiff_t a_rs = row_step(a), a_cs = col_step(a);                                                               \
+        ptrdiff_t b_rs = row_step(b), b_cs = col_step(b);                                                               \
+        ptrdiff_t c_rs = row_step(c), c_cs = col_step(c);                                                               \
+                                                                                                                        \
+        for (ptrdiff_t kk = 0; kk < k; kk += MULTIPLY_BLOCK_K) {                                                        \
+            ptrdiff_t k_end = (kk + MULTIPLY_BLOCK_K < k) ? kk + MULTIPLY_BLOCK_K : k;                                  \
+            for (ptrdiff_t jj = 0; jj < m; jj += MULTIPLY_BLOCK_M) {                                                    \
+                ptrdiff_t j_len = (jj + MULTIPLY_BLOCK_M < m) ? MULTIPLY_BLOCK_M : m - jj;                              \
+                for (ptrdiff_t i = 0; i < n; i++) {                                                                     \
+                    TYPE * c_row = &c_data[i * c_rs + jj * c_cs];                                                       \
+                    for (ptrdiff_t kx = kk; kx < k_end; kx++) {                                                         \
+                        TYPE scale = a_data[i * a_rs + kx * a_cs];                                                      \
+                        const TYPE * b_row = &b_data[kx * b_rs + jj * b_cs];                                            \
+                        if (b_cs == 1 && c_cs == 1) {                                                                   \
+                            AXPY(scale, b_row, c_row, j_len);                                                           \
+                        } else {                                                                                        \
+                            for (ptrdiff_t j = 0; j < j_len; j++) c_row[j * c_cs] += scale * b_row[j * b_cs];           \
+                        }                                                                                               \
+                    }                                                                                                   \
+                }                                                                                                       \
+            }                                                                                                           \
+        }                                                                                                               \
+                                                                                                                        \
+        return 0;                                                                                                       \
+    } while (0)
+
+int vvectorMatrixMultiplyFloat(struct vvectorMatrix * a, struct vvectorMatrix * b, struct vvectorMatrix * c){
+    MATRIX_MULTIPLY(float, vvector_kernels_.axpy_f32);
+}
+
+int vvectorMatrixMultiplyDouble(struct vvectorMatrix * a, struct vvectorMatrix * b, struct vvectorMatrix * c){
+    MATRIX_MULTIPLY(double, vvector_kernels_.axpy_f64);
+}
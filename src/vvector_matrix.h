@@ -0,0 +1,156 @@
+/*
+    Copyright 2024 I. Laurentiu
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef VVECTOR_MATRIX_H
+#define VVECTOR_MATRIX_H
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+#include "vvector.h"
+
+#include <stddef.h>
+
+/// @file vvector_matrix.h
+
+/**
+ * @brief How the elements of a matrix are laid out in its vvector.
+ */
+enum vvectorMatrixOrder {
+    VVECTOR_ROW_MAJOR = 0,  /**< Element (r, c) is at index r * cols + c. */
+    VVECTOR_COL_MAJOR,      /**< Element (r, c) is at index c * rows + r. */
+};
+
+/**
+ * @struct vvectorMatrix
+ *
+ * @brief   A 2D view over a vvector of rows * cols elements.
+ *
+ * The view owns nothing: the elements stay in 'data', which can be used with every other vvector function.
+ * Set it up with 'vvectorMatrixInit'. Functions which change the shape (e.g. 'vvectorMatrixTranspose') update the view.
+ *
+ * @code
+ * vvector storage = vvectorNewZeroed(double, 3 * 4, 0);
+ * struct vvectorMatrix m;
+ * vvectorMatrixInit(&m, storage, 3, 4, VVECTOR_ROW_MAJOR);
+ * *(double *) vvectorMatrixGetAt(&m, 2, 1) = 1.0;
+ * @endcode
+ */
+struct vvectorMatrix {
+    vvector data;
+    ptrdiff_t rows;
+    ptrdiff_t cols;
+    enum vvectorMatrixOrder order;
+};
+
+/**
+ * @struct vvectorStrided
+ *
+ * @brief   A row or column of a matrix: 'length' elements, 'stride' bytes apart.
+ *
+ * Element 'i' is at (uint8_t *) data + i * stride. Invalidated when the vvector reallocates.
+ */
+struct vvectorStrided {
+    void * data;
+    ptrdiff_t length;
+    ptrdiff_t stride;
+};
+
+/**
+ * @brief Set up a matrix view over 'data'.
+ *
+ * @param   matrix  The view to initialize.
+ * @param   data    The vvector holding the elements. Its length must be rows * cols.
+ * @param   rows    Number of rows.
+ * @param   cols    Number of columns.
+ * @param   order   Layout of the elements. @see vvectorMatrixOrder
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorMatrixInit(struct vvectorMatrix * matrix, vvector data, ptrdiff_t rows, ptrdiff_t cols, enum vvectorMatrixOrder order);
+
+/**
+ * @brief Get a pointer to element (row, col).
+ *
+ * @param   matrix  The matrix.
+ * @param   row     Row index.
+ * @param   col     Column index.
+ * @return  Pointer to the element or NULL on error.
+ */
+void * vvectorMatrixGetAt(struct vvectorMatrix * matrix, ptrdiff_t row, ptrdiff_t col);
+
+/**
+ * @brief Get a row of the matrix.
+ *
+ * @param   matrix  The matrix.
+ * @param   row     Row index.
+ * @param   out     Set to the row. Its stride is the element size for VVECTOR_ROW_MAJOR.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorMatrixGetRow(struct vvectorMatrix * matrix, ptrdiff_t row, struct vvectorStrided * out);
+
+/**
+ * @brief Get a column of the matrix.
+ *
+ * @param   matrix  The matrix.
+ * @param   col     Column index.
+ * @param   out     Set to the column. Its stride is the element size for VVECTOR_COL_MAJOR.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorMatrixGetCol(struct vvectorMatrix * matrix, ptrdiff_t col, struct vvectorStrided * out);
+
+/**
+ * @brief Transpose the matrix, keeping its order. Rows and cols of the view are swapped.
+ *
+ * Square matrices are transposed in place, block by block. Other shapes are transposed into a temporary copy.
+ *
+ * @param   matrix  The matrix.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorMatrixTranspose(struct vvectorMatrix * matrix);
+
+/**
+ * @brief Write the transpose of 'src' into 'dst'.
+ *
+ * The matrices may have different orders: transposing a row major matrix into a column major one is a plain copy.
+ *
+ * @param   src     Matrix to transpose.
+ * @param   dst     A src->cols x src->rows matrix with the same element size. Must not share storage with 'src'.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorMatrixTransposeTo(struct vvectorMatrix * src, struct vvectorMatrix * dst);
+
+/**
+ * @brief c = a * b for matrices of float, with cache blocking.
+ *
+ * Any mix of orders works, but row major 'b' and 'c' are fastest: the inner loop then runs over contiguous memory.
+ *
+ * @param   a   An n x k matrix.
+ * @param   b   A k x m matrix.
+ * @param   c   An n x m matrix, overwritten with the product. Must not share storage with 'a' or 'b'.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorMatrixMultiplyFloat(struct vvectorMatrix * a, struct vvectorMatrix * b, struct vvectorMatrix * c);
+
+/**
+ * @brief c = a * b for matrices of double, with cache blocking. @see vvectorMatrixMultiplyFloat
+ */
+int vvectorMatrixMultiplyDouble(struct vvectorMatrix * a, struct vvectorMatrix * b, struct vvectorMatrix * c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VVECTOR_MATRIX_H
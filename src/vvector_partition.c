@@ -0,0 +1,482 @@
+/*
+    Copyright 2024 I. Laurentiu
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+// pthread_*
+#define _POSIX_C_SOURCE 200809L
+
+#include "vvector_partition.h"
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// @file vvector_partition.c
+
+#define VEC_ENOVEC 1        /**< Indicates that a vector argument is NULL or an allocation failed. */
+#define VEC_EBADINDEX 2     /**< Indicates that the key or the number of bits is invalid. */
+#define VEC_EMISMATCH 4     /**< Indicates that an output's element size does not match the input's. */
+
+#define MAX_RADIX_BITS 16
+#define MAX_PASS_BITS 8             /**< 256 partitions per pass: 32 KB of buffers, which stay in L1/L2. */
+#define MAX_PASS_PARTITIONS (1 << MAX_PASS_BITS)
+#define WC_BYTES 128                /**< Write-combining buffer per partition: two cache lines. */
+#define MIN_ROWS_PER_THREAD 65536
+
+/**
+ * @internal
+ * @struct partition_pass_
+ * @brief Where keys are and which hash bits pick the partition, for one pass.
+ */
+struct partition_pass_ {
+    const uint8_t * src;
+    ptrdiff_t size;         /**< Element size. */
+    ptrdiff_t key_offset;
+    ptrdiff_t key_size;
+    int shift;              /**< partition = (hash >> shift) & mask */
+    uint64_t mask;
+};
+
+/**
+ * @internal
+ * @struct partition_target_
+ * @brief Final destination: one contiguous vvector with offsets, or one vvector per partition.
+ */
+struct partition_target_ {
+    ptrdiff_t size;
+    uint8_t * out;          /**< Contiguous output, or NULL. */
+    ptrdiff_t * offsets;    /**< Partition offsets into 'out'. */
+    vvector * outputs;      /**< Separate outputs, if 'out' is NULL. */
+};
+
+/**
+ * @internal
+ * @struct partition_task_
+ * @brief One thread's rows and scratch: counters, write cursors and write-combining buffers.
+ */
+struct partition_task_ {
+    struct partition_pass_ pass;
+    ptrdiff_t first;
+    ptrdiff_t last;
+
+    ptrdiff_t * counts;     /**< MAX_PASS_PARTITIONS counters. */
+    uint8_t ** cursors;     /**< MAX_PASS_PARTITIONS write positions. */
+    uint8_t * buffers;      /**< MAX_PASS_PARTITIONS buffers of WC_BYTES, 64 byte aligned. */
+    uint8_t * fill;         /**< Number of elements in each buffer. */
+
+    // Second pass of two: chunks 'c' with c % nr_tasks == this task's index.
+    const ptrdiff_t * chunk_offsets;
+    int nr_chunks;
+    int chunk_bits;
+    struct partition_target_ * target;
+    struct partition_task_ * all;
+    int nr_tasks;
+
+    int err;
+    pthread_t thread;
+    int started;
+};
+
+/* Helpers */
+
+static void * partition_malloc(struct vvectorAlloc * alloc, ptrdiff_t size){
+    if (alloc && alloc->malloc_fn) return alloc->malloc_fn(size, alloc->ctx);
+
+    return malloc(size);
+}
+
+static void partition_free(struct vvectorAlloc * alloc, void * ptr, ptrdiff_t size){
+    if (alloc && alloc->free_fn) {
+        alloc->free_fn(ptr, size, alloc->ctx);
+        return;
+    }
+
+    free(ptr);
+}
+
+// Finalizer of MurmurHash3: every key bit affects the top bits.
+static inline uint64_t hash_key(uint64_t key){
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ull;
+    key ^= key >> 33;
+
+    return key;
+}
+
+uint64_t vvectorPartitionHash(uint64_t key){
+    return hash_key(key);
+}
+
+static inline uint64_t read_key(const uint8_t * element, ptrdiff_t key_size){
+    switch (key_size) {
+        case 1: return *element;
+        case 2: { uint16_t k; memcpy(&k, element, 2); return k; }
+        case 4: { uint32_t k; memcpy(&k, element, 4); return k; }
+        default: { uint64_t k; memcpy(&k, element, 8); return k; }
+    }
+}
+
+static inline ptrdiff_t partition_of(const struct partition_pass_ * pass, const uint8_t * element){
+    return (ptrdiff_t) ((hash_key(read_key(element + pass->key_offset, pass->key_size)) >> pass->shift) & pass->mask);
+}
+
+static void histogram(const struct partition_pass_ * pass, ptrdiff_t first, ptrdiff_t last, ptrdiff_t * counts){
+    memset(counts, 0, (pass->mask + 1) * sizeof(ptrdiff_t));
+
+    for (ptrdiff_t i = first; i < last; i++) counts[partition_of(pass, pass->src + i * pass->size)]++;
+}
+
+/**
+ * @internal
+ * @brief Copy rows [first, last) to cursors[partition], through the write-combining buffers. 'size' is a constant at each call site.
+ */
+static inline void scatter_rows(const struct partition_pass_ * pass, ptrdiff_t first, ptrdiff_t last, uint8_t ** cursors,
+                                uint8_t * buffers, uint8_t * fill, ptrdiff_t size){
+    ptrdiff_t slots = WC_BYTES / size;
+    const uint8_t * src = pass->src;
+
+    // Elements over half a buffer gain nothing from buffering.
+    if (slots < 2) {
+        for (ptrdiff_t i = first; i < last; i++) {
+            ptrdiff_t p = partition_of(pass, src + i * size);
+            memcpy(cursors[p], src + i * size, size);
+            cursors[p] += size;
+        }
+        return;
+    }
+
+    memset(fill, 0, pass->mask + 1);
+
+    for (ptrdiff_t i = first; i < last; i++) {
+        ptrdiff_t p = partition_of(pass, src + i * size);
+        uint8_t * buffer = buffers + p * WC_BYTES;
+
+        memcpy(buffer + fill[p] * size, src + i * size, size);
+
+        if (++fill[p] == slots) {
+            memcpy(cursors[p], buffer, slots * size);
+            cursors[p] += slots * size;
+            fill[p] = 0;
+        }
+    }
+
+    for (ptrdiff_t p = 0; p <= (ptrdiff_t) pass->mask; p++) {
+        if (fill[p] == 0) continue;
+
+        memcpy(cursors[p], buffers + p * WC_BYTES, fill[p] * size);
+        cursors[p] += fill[p] * size;
+    }
+}
+
+static void scatter(const struct partition_pass_ * pass, ptrdiff_t first, ptrdiff_t last, uint8_t ** cursors, uint8_t * buffers, uint8_t * fill){
+    // Fixed size copies compile to a single move.
+    switch (pass->size) {
+        case 4: scatter_rows(pass, first, last, cursors, buffers, fill, 4); break;
+        case 8: scatter_rows(pass, first, last, cursors, buffers, fill, 8); break;
+        case 16: scatter_rows(pass, first, last, cursors, buffers, fill, 16); break;
+        default: scatter_rows(pass, first, last, cursors, buffers, fill, pass->size); break;
+    }
+}
+
+/**
+ * @internal
+ * @brief Size the final partitions [first_part, first_part + n), which receive counts[i] elements, and point bases[i] at their first element.
+ *
+ * For a contiguous target the partitions are laid out from element 'start'.
+ */
+static int open_partitions(struct partition_target_ * target, ptrdiff_t first_part, ptrdiff_t n, const ptrdiff_t * counts, ptrdiff_t start, uint8_t ** bases){
+    if (target->out) {
+        for (ptrdiff_t i = 0; i < n; i++) {
+            target->offsets[first_part + i] = start;
+            bases[i] = target->out + start * target->size;
+            start += counts[i];
+        }
+        return 0;
+    }
+
+    for (ptrdiff_t i = 0; i < n; i++) {
+        vvector output = target->outputs[first_part + i];
+        ptrdiff_t old_length = vvectorGetLength(output);
+        bases[i] = 0;
+
+        if (counts[i] == 0) continue;
+
+        int err = vvectorResizeUninit(output, old_length + counts[i]);
+        if (err) return err;
+
+        bases[i] = vvectorGetAt(output, old_length);
+    }
+
+    return 0;
+}
+
+/* Threads */
+
+static void * partition_count(void * arg){
+    struct partition_task_ * task = arg;
+
+    histogram(&task->pass, task->first, task->last, task->counts);
+
+    return 0;
+}
+
+static void * partition_scatter(void * arg){
+    struct partition_task_ * task = arg;
+
+    scatter(&task->pass, task->first, task->last, task->cursors, task->buffers, task->fill);
+
+    return 0;
+}
+
+// Second pass: each chunk of the first pass is split on its own, into final partitions no other chunk writes to.
+static void * partition_refine(void * arg){
+    struct partition_task_ * task = arg;
+    ptrdiff_t nr_sub = (ptrdiff_t) 1 << task->chunk_bits;
+
+    for (int c = (int) (task - task->all); c < task->nr_chunks; c += task->nr_tasks) {
+        ptrdiff_t first = task->chunk_offsets[c];
+        ptrdiff_t last = task->chunk_offsets[c + 1];
+
+        histogram(&task->pass, first, last, task->counts);
+
+        task->err = open_partitions(task->target, c * nr_sub, nr_sub, task->counts, first, task->cursors);
+        if (task->err) return 0;
+
+        if (first < last) scatter(&task->pass, first, last, task->cursors, task->buffers, task->fill);
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Run 'fn' on every task, tasks[0] on the calling thread. Falls back to the calling thread if a thread can't be started.
+ */
+static void run_tasks(void * (*fn)(void *), struct partition_task_ * tasks, int nr_tasks){
+    for (int t = 1; t < nr_tasks; t++) {
+        tasks[t].started = (pthread_create(&tasks[t].thread, 0, fn, &tasks[t]) == 0);
+        if (!tasks[t].started) fn(&tasks[t]);
+    }
+
+    fn(&tasks[0]);
+
+    for (int t = 1; t < nr_tasks; t++) {
+        if (tasks[t].started) pthread_join(tasks[t].thread, 0);
+    }
+}
+
+/**
+ * @internal
+ * @brief One parallel pass over every row of 'pass->src' into 'target', partitioned on 'pass->mask + 1' partitions.
+ */
+static int partition_pass(struct partition_task_ * tasks, int nr_tasks, ptrdiff_t n, struct partition_target_ * target){
+    ptrdiff_t nr_parts = (ptrdiff_t) tasks[0].pass.mask + 1;
+    ptrdiff_t totals[MAX_PASS_PARTITIONS];
+    uint8_t * bases[MAX_PASS_PARTITIONS];
+
+    run_tasks(partition_count, tasks, nr_tasks);
+
+    for (ptrdiff_t p = 0; p < nr_parts; p++) {
+        totals[p] = 0;
+        for (int t = 0; t < nr_tasks; t++) totals[p] += tasks[t].counts[p];
+    }
+
+    int err = open_partitions(target, 0, nr_parts, totals, 0, bases);
+    if (err) return err;
+
+    if (target->out) target->offsets[nr_parts] = n;
+
+    // Thread 't' writes partition 'p' after threads 0..t-1, which keeps the input order.
+    for (ptrdiff_t p = 0; p < nr_parts; p++) {
+        uint8_t * cursor = bases[p];
+
+        for (int t = 0; t < nr_tasks; t++) {
+            tasks[t].cursors[p] = cursor;
+            if (cursor) cursor += tasks[t].counts[p] * target->size;
+        }
+    }
+
+    if (n > 0) run_tasks(partition_scatter, tasks, nr_tasks);
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Shared implementation of 'vvectorRadixPartition' and 'vvectorPartition', for a non-empty 'vec'.
+ */
+static int partition(vvector vec, ptrdiff_t key_offset, ptrdiff_t key_size, int radix_bits, int nr_threads,
+                     struct partition_target_ * target, struct vvectorAlloc * allocator){
+    ptrdiff_t n = vvectorGetLength(vec);
+    ptrdiff_t size = target->size;
+
+    if (nr_threads < 1) nr_threads = 1;
+    if (nr_threads > 1 && n / nr_threads < MIN_ROWS_PER_THREAD) nr_threads = (int) (n / MIN_ROWS_PER_THREAD);
+    if (nr_threads < 1) nr_threads = 1;
+
+    // Up to 8 bits in one pass, else the top half of the bits first and the rest within each chunk.
+    int first_bits = (radix_bits <= MAX_PASS_BITS) ? radix_bits : (radix_bits + 1) / 2;
+    int second_bits = radix_bits - first_bits;
+
+    // Scratch: the tasks, then per task the counters, cursors, fill counts and 64 byte aligned buffers.
+    ptrdiff_t per_task = MAX_PASS_PARTITIONS * (ptrdiff_t) (sizeof(ptrdiff_t) + sizeof(uint8_t *) + 1 + WC_BYTES);
+    ptrdiff_t scratch_size = nr_threads * ((ptrdiff_t) sizeof(struct partition_task_) + per_task) + 64;
+    uint8_t * scratch = partition_malloc(allocator, scratch_size);
+    if (!scratch) return VEC_ENOVEC;
+
+    memset(scratch, 0, nr_threads * sizeof(struct partition_task_));
+
+    struct partition_task_ * tasks = (struct partition_task_ *) scratch;
+    uint8_t * area = scratch + nr_threads * sizeof(struct partition_task_);
+    uint8_t * buffers = (uint8_t *) (((uintptr_t) area + 63) & ~(uintptr_t) 63);
+    area = buffers + nr_threads * MAX_PASS_PARTITIONS * WC_BYTES;
+
+    for (int t = 0; t < nr_threads; t++) {
+        tasks[t].pass.src = vvectorGetFront(vec);
+        tasks[t].pass.size = size;
+        tasks[t].pass.key_offset = key_offset;
+        tasks[t].pass.key_size = key_size;
+        tasks[t].pass.shift = 64 - first_bits;
+        tasks[t].pass.mask = ((uint64_t) 1 << first_bits) - 1;
+        tasks[t].first = n * t / nr_threads;
+        tasks[t].last = n * (t + 1) / nr_threads;
+        tasks[t].buffers = buffers + t * MAX_PASS_PARTITIONS * WC_BYTES;
+        tasks[t].counts = (ptrdiff_t *) area;
+        area += MAX_PASS_PARTITIONS * sizeof(ptrdiff_t);
+        tasks[t].cursors = (uint8_t **) area;
+        area += MAX_PASS_PARTITIONS * sizeof(uint8_t *);
+        tasks[t].fill = area;
+        area += MAX_PASS_PARTITIONS;
+        tasks[t].all = tasks;
+        tasks[t].nr_tasks = nr_threads;
+    }
+
+    int err = 0;
+
+    if (second_bits == 0) {
+        err = partition_pass(tasks, nr_threads, n, target);
+    } else {
+        // First pass into a temporary vvector, partitioned on the top 'first_bits' bits.
+        ptrdiff_t chunk_offsets[MAX_PASS_PARTITIONS + 1];
+        vvector temp = vec_new_(size, allocator);
+
+        struct partition_target_ chunks;
+        chunks.size = size;
+        chunks.offsets = chunk_offsets;
+        chunks.outputs = 0;
+
+        err = temp ? vvectorResizeUninit(temp, n) : VEC_ENOVEC;
+
+        if (!err) {
+            chunks.out = vvectorGetFront(temp);
+            err = partition_pass(tasks, nr_threads, n, &chunks);
+        }
+
+        if (!err) {
+            for (int t = 0; t < nr_threads; t++) {
+                tasks[t].pass.src = vvectorGetFront(temp);
+                tasks[t].pass.shift = 64 - radix_bits;
+                tasks[t].pass.mask = ((uint64_t) 1 << second_bits) - 1;
+                tasks[t].chunk_offsets = chunk_offsets;
+                tasks[t].nr_chunks = 1 << first_bits;
+                tasks[t].chunk_bits = second_bits;
+                tasks[t].target = target;
+            }
+
+            run_tasks(partition_refine, tasks, nr_threads);
+            for (int t = 0; t < nr_threads; t++) err = err ? err : tasks[t].err;
+
+            if (target->out) target->offsets[(ptrdiff_t) 1 << radix_bits] = n;
+        }
+
+        if (temp) vvectorFree(temp);
+    }
+
+    partition_free(allocator, scratch, scratch_size);
+
+    return err;
+}
+
+static int check_key(vvector vec, ptrdiff_t key_offset, ptrdiff_t key_size, int radix_bits){
+    if (key_size != 1 && key_size != 2 && key_size != 4 && key_size != 8) return VEC_EBADINDEX;
+
+    if (key_offset < 0 || key_offset + key_size > vvectorGetElementSize(vec)) return VEC_EBADINDEX;
+
+    if (radix_bits < 1 || radix_bits > MAX_RADIX_BITS) return VEC_EBADINDEX;
+
+    return 0;
+}
+
+/* Partitioning */
+
+int vvectorRadixPartition(vvector vec, ptrdiff_t key_offset, ptrdiff_t key_size, int radix_bits, int nr_threads,
+                          vvector out, vvector offsets, struct vvectorAlloc * allocator){
+    if (!vec || !*vec || !out || !*out || !offsets || !*offsets) return VEC_ENOVEC;
+
+    int err = check_key(vec, key_offset, key_size, radix_bits);
+    if (err) return err;
+
+    if (out == vec || out == offsets) return VEC_EBADINDEX;
+
+    ptrdiff_t size = vvectorGetElementSize(vec);
+
+    if (vvectorGetElementSize(out) != size || vvectorGetElementSize(offsets) != sizeof(ptrdiff_t)) return VEC_EMISMATCH;
+
+    err = vvectorResizeUninit(out, vvectorGetLength(vec));
+    if (!err) err = vvectorResizeUninit(offsets, ((ptrdiff_t) 1 << radix_bits) + 1);
+    if (err) return err;
+
+    struct partition_target_ target;
+    target.size = size;
+    target.out = vvectorGetFront(out);
+    target.offsets = vvectorGetFront(offsets);
+    target.outputs = 0;
+
+    if (!target.out) {
+        // Empty input: every partition is empty.
+        memset(target.offsets, 0, (((ptrdiff_t) 1 << radix_bits) + 1) * sizeof(ptrdiff_t));
+        return 0;
+    }
+
+    return partition(vec, key_offset, key_size, radix_bits, nr_threads, &target, allocator);
+}
+
+int vvectorPartition(vvector vec, ptrdiff_t key_offset, ptrdiff_t key_size, int radix_bits, int nr_threads,
+                     vvector * outputs, struct vvectorAlloc * allocator){
+    if (!vec || !*vec || !outputs) return VEC_ENOVEC;
+
+    int err = check_key(vec, key_offset, key_size, radix_bits);
+    if (err) return err;
+
+    ptrdiff_t size = vvectorGetElementSize(vec);
+
+    for (ptrdiff_t p = 0; p < ((ptrdiff_t) 1 << radix_bits); p++) {
+        if (!outputs[p] || !*outputs[p]) return VEC_ENOVEC;
+        if (outputs[p] == vec) return VEC_EBADINDEX;
+        if (vvectorGetElementSize(outputs[p]) != size) return VEC_EMISMATCH;
+    }
+
+    if (vvectorGetLength(vec) == 0) return 0;
+
+    struct partition_target_ target;
+    target.size = size;
+    target.out = 0;
+    target.offsets = 0;
+    target.outputs = outputs;
+
+    return partition(vec, key_offset, key_size, radix_bits, nr_threads, &target, allocator);
+}
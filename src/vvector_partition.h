@@ -0,0 +1,96 @@
+/*
+    Copyright 2024 I. Laurentiu
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef VVECTOR_PARTITION_H
+#define VVECTOR_PARTITION_H
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+#include "vvector.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @file vvector_partition.h
+
+/*
+ * Radix partitioning splits the elements of a vvector into 2^radix_bits partitions by the hash of a key inside each element.
+ * The key is 'key_size' bytes (1, 2, 4 or 8) at byte 'key_offset' of the element, read as an unsigned integer;
+ * its partition is given by the top 'radix_bits' bits of 'vvectorPartitionHash(key)'.
+ *
+ * Partitioning is done in two passes over the input instead of one vvectorPushBack per element:
+ *
+ *      1. A histogram counts the elements of every partition, so every output is sized exactly, once.
+ *      2. Elements are scattered through small per-partition buffers, which are copied to the outputs a cache line or two at a time.
+ *         Writes to thousands of different pages become a few streams of full-line copies.
+ *
+ * More than 8 bits are split into two passes of at most 8 bits, each of which keeps its buffers in the L1/L2 cache.
+ * Up to 16 bits (65536 partitions) are supported. Elements keep their input order within a partition.
+ *
+ * @code
+ * // Split orders by customer id (an int64_t at offsetof(struct order, customer)) into 64 partitions.
+ * vvector partitions[64];
+ * for (int p = 0; p < 64; p++) partitions[p] = vvectorNew(struct order, 0);
+ *
+ * vvectorPartition(orders, offsetof(struct order, customer), sizeof(int64_t), 6, 4, partitions, 0);
+ * @endcode
+ */
+
+/**
+ * @brief The hash partitions are taken from. Also usable to build hash tables consistent with a partitioning.
+ *
+ * @param   key     The key, zero extended to 64 bits.
+ * @return  The hash.
+ */
+uint64_t vvectorPartitionHash(uint64_t key);
+
+/**
+ * @brief Partition 'vec' into one contiguous vvector, partition after partition.
+ *
+ * @param   vec         The source vvector.
+ * @param   key_offset  Offset of the key inside an element, in bytes.
+ * @param   key_size    Size of the key: 1, 2, 4 or 8 bytes.
+ * @param   radix_bits  Number of hash bits used, from 1 to 16, for 2^radix_bits partitions.
+ * @param   nr_threads  Number of threads, including the calling one. Small inputs use fewer.
+ * @param   out         vvector with the element size of 'vec', resized to hold every element. Must not be 'vec'.
+ * @param   offsets     vvector of ptrdiff_t, resized to 2^radix_bits + 1 offsets: partition 'p' is out[offsets[p]] to out[offsets[p + 1] - 1].
+ * @param   allocator   Allocator for temporary buffers, or NULL for defaults. @see vvectorAlloc.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorRadixPartition(vvector vec, ptrdiff_t key_offset, ptrdiff_t key_size, int radix_bits, int nr_threads,
+                          vvector out, vvector offsets, struct vvectorAlloc * allocator);
+
+/**
+ * @brief Partition 'vec' into 2^radix_bits vvectors, appending the elements of partition 'p' to outputs[p].
+ *
+ * @param   vec         The source vvector.
+ * @param   key_offset  Offset of the key inside an element, in bytes.
+ * @param   key_size    Size of the key: 1, 2, 4 or 8 bytes.
+ * @param   radix_bits  Number of hash bits used, from 1 to 16, for 2^radix_bits partitions.
+ * @param   nr_threads  Number of threads, including the calling one. Small inputs use fewer.
+ * @param   outputs     Array of 2^radix_bits distinct vvectors with the element size of 'vec'.
+ * @param   allocator   Allocator for temporary buffers, or NULL for defaults. @see vvectorAlloc.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorPartition(vvector vec, ptrdiff_t key_offset, ptrdiff_t key_size, int radix_bits, int nr_threads,
+                     vvector * outputs, struct vvectorAlloc * allocator);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VVECTOR_PARTITION_H
@@ -0,0 +1,336 @@
+/*
+    Copyright 2024 I. Laurentiu
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+// pthread_*
+#define _POSIX_C_SOURCE 200809L
+
+#include "vvector_pool.h"
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// @file vvector_pool.c
+
+#define VEC_ENOVEC 1        /**< Indicates that the provided vector or pool argument is NULL. */
+#define VEC_EMISMATCH 4     /**< Indicates that the vector's element size or allocator does not match the pool's. */
+
+#define MIN_CLASS 5         /**< Smallest class, 1 << 5 = 32 elements. Matches the library's page size. */
+#define NR_CLASSES 48       /**< Classes are indexed by log2 of the capacity, so they go up to 1 << 47 elements. Larger vvectors share the last one. */
+#define TCACHE_SLOTS 4      /**< vvectors per class in each thread's private cache. */
+
+/**
+ * @internal
+ * @struct vvector_pool_tcache_
+ * @brief A thread's private cache for one pool.
+ */
+struct vvector_pool_tcache_ {
+    struct vvector_pool_tcache_ * next;     /**< Registry of every thread's cache, so vvectorPoolFree can reach them. */
+    struct vvector_pool_tcache_ * prev;
+    struct vvectorPool * pool;
+    int counts[NR_CLASSES];
+    vvector slots[NR_CLASSES][TCACHE_SLOTS];
+};
+
+struct vvectorPool {
+    ptrdiff_t element_size;
+    struct vvectorAlloc alloc;
+    int has_alloc;
+
+    ptrdiff_t max_retained_bytes;
+    ptrdiff_t retained_bytes;                   /**< Accessed atomically. */
+
+    pthread_mutex_t lock;                       /**< Protects 'shared' and 'tcaches'. */
+    vvector shared[NR_CLASSES];                 /**< vvectors of cached vvector handles. Created on first use. */
+    struct vvector_pool_tcache_ * tcaches;
+
+    pthread_key_t key;                          /**< Maps threads to their 'vvector_pool_tcache_'. */
+};
+
+/* Helpers */
+
+// The pool's own memory comes from the allocator too, with the C library standing in for missing functions like in 'vec_new_'.
+
+static void * pool_malloc(struct vvectorPool * pool, ptrdiff_t size){
+    if (pool->alloc.malloc_fn) return pool->alloc.malloc_fn(size, pool->alloc.ctx);
+
+    return malloc(size);
+}
+
+static void pool_free(struct vvectorPool * pool, void * ptr, ptrdiff_t size){
+    if (pool->alloc.free_fn) {
+        pool->alloc.free_fn(ptr, size, pool->alloc.ctx);
+        return;
+    }
+
+    free(ptr);
+}
+
+/**
+ * @internal
+ * @brief The class a vvector with room for 'capacity' elements is filed under, i.e. floor(log2(capacity)).
+ *
+ * @return The class, or -1 if 'capacity' is too small to be pooled.
+ */
+static int class_of_capacity(ptrdiff_t capacity){
+    if (capacity < ((ptrdiff_t) 1 << MIN_CLASS)) return -1;
+
+    int cls = 63 - __builtin_clzll((unsigned long long) capacity);
+
+    return (cls < NR_CLASSES) ? cls : NR_CLASSES - 1;
+}
+
+/**
+ * @internal
+ * @brief The smallest class whose vvectors all hold at least 'capacity' elements, i.e. ceil(log2(capacity)).
+ */
+static int class_for_request(ptrdiff_t capacity){
+    if (capacity <= ((ptrdiff_t) 1 << MIN_CLASS)) return MIN_CLASS;
+
+    return 64 - __builtin_clzll((unsigned long long) (capacity - 1));
+}
+
+/**
+ * @internal
+ * @brief Runs when a thread exits: hands its cached vvectors to the shared lists.
+ */
+static void tcache_destroy(void * arg){
+    struct vvector_pool_tcache_ * tcache = arg;
+    struct vvectorPool * pool = tcache->pool;
+
+    pthread_mutex_lock(&pool->lock);
+
+    for (int cls = 0; cls < NR_CLASSES; cls++) {
+        for (int i = 0; i < tcache->counts[cls]; i++) {
+            vvector vec = tcache->slots[cls][i];
+
+            if (!pool->shared[cls] || vvectorPushBack(pool->shared[cls], &vec)) {
+                __atomic_fetch_sub(&pool->retained_bytes, vvectorGetCapacity(vec) * pool->element_size, __ATOMIC_RELAXED);
+                vvectorFree(vec);
+            }
+        }
+    }
+
+    if (tcache->prev) tcache->prev->next = tcache->next;
+    else pool->tcaches = tcache->next;
+    if (tcache->next) tcache->next->prev = tcache->prev;
+
+    pthread_mutex_unlock(&pool->lock);
+
+    pool_free(pool, tcache, sizeof(struct vvector_pool_tcache_));
+}
+
+/**
+ * @internal
+ * @brief Returns the calling thread's cache for 'pool', creating it if needed.
+ *
+ * @return The cache, or NULL if out of memory.
+ */
+static struct vvector_pool_tcache_ * get_tcache(struct vvectorPool * pool){
+    struct vvector_pool_tcache_ * tcache = pthread_getspecific(pool->key);
+    if (tcache) return tcache;
+
+    tcache = pool_malloc(pool, sizeof(struct vvector_pool_tcache_));
+    if (!tcache) return 0;
+
+    memset(tcache, 0, sizeof(struct vvector_pool_tcache_));
+    tcache->pool = pool;
+
+    if (pthread_setspecific(pool->key, tcache)) {
+        pool_free(pool, tcache, sizeof(struct vvector_pool_tcache_));
+        return 0;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    tcache->next = pool->tcaches;
+    if (pool->tcaches) pool->tcaches->prev = tcache;
+    pool->tcaches = tcache;
+    pthread_mutex_unlock(&pool->lock);
+
+    return tcache;
+}
+
+/* Pool functions */
+
+struct vvectorPool * vvectorPoolNew(ptrdiff_t element_size, struct vvectorAlloc * allocator, ptrdiff_t max_retained_bytes){
+    if (element_size <= 0 || max_retained_bytes < 0) return 0;
+
+    // Allocate through a stack copy first, the pool does not exist yet.
+    struct vvectorPool tmp;
+    memset(&tmp, 0, sizeof(struct vvectorPool));
+    if (allocator) {
+        tmp.alloc = *allocator;
+        tmp.has_alloc = 1;
+    }
+
+    struct vvectorPool * pool = pool_malloc(&tmp, sizeof(struct vvectorPool));
+    if (!pool) return 0;
+
+    memcpy(pool, &tmp, sizeof(struct vvectorPool));
+    pool->element_size = element_size;
+    pool->max_retained_bytes = max_retained_bytes;
+
+    if (pthread_mutex_init(&pool->lock, 0)) {
+        pool_free(&tmp, pool, sizeof(struct vvectorPool));
+        return 0;
+    }
+
+    if (pthread_key_create(&pool->key, tcache_destroy)) {
+        pthread_mutex_destroy(&pool->lock);
+        pool_free(&tmp, pool, sizeof(struct vvectorPool));
+        return 0;
+    }
+
+    return pool;
+}
+
+vvector vvectorPoolAcquire(struct vvectorPool * pool, ptrdiff_t capacity){
+    if (!pool || capacity < 0) return 0;
+
+    int cls = class_for_request(capacity);
+
+    // Also accept the next class up, so a slightly bigger request does not always miss.
+    int last_cls = (cls + 1 < NR_CLASSES) ? cls + 1 : cls;
+
+    if (cls < NR_CLASSES) {
+        struct vvector_pool_tcache_ * tcache = get_tcache(pool);
+
+        for (int c = cls; tcache && c <= last_cls; c++) {
+            if (tcache->counts[c] > 0) {
+                vvector vec = tcache->slots[c][--tcache->counts[c]];
+                __atomic_fetch_sub(&pool->retained_bytes, vvectorGetCapacity(vec) * pool->element_size, __ATOMIC_RELAXED);
+
+                return vec;
+            }
+        }
+
+        pthread_mutex_lock(&pool->lock);
+
+        for (int c = cls; c <= last_cls; c++) {
+            if (!vvectorIsEmpty(pool->shared[c])) {
+                vvector vec = *(vvector *) vvectorGetBack(pool->shared[c]);
+                vvectorRemoveBack(pool->shared[c]);
+
+                pthread_mutex_unlock(&pool->lock);
+
+                __atomic_fetch_sub(&pool->retained_bytes, vvectorGetCapacity(vec) * pool->element_size, __ATOMIC_RELAXED);
+
+                return vec;
+            }
+        }
+
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    // Miss: create one which fills its class exactly, so it comes back to the same class.
+    vvector vec = vec_new_(pool->element_size, (pool->has_alloc) ? &pool->alloc : 0);
+    if (!vec) return 0;
+
+    ptrdiff_t reserve = (cls < NR_CLASSES) ? ((ptrdiff_t) 1 << cls) : capacity;
+    if (vvectorReserve(vec, reserve)) {
+        vvectorFree(vec);
+        return 0;
+    }
+
+    return vec;
+}
+
+int vvectorPoolRelease(struct vvectorPool * pool, vvector vec){
+    if (!pool || !vec || !*vec) return VEC_ENOVEC;
+
+    if (vvectorGetElementSize(vec) != pool->element_size) return VEC_EMISMATCH;
+
+    // Cached vvectors are handed out as if 'vvectorPoolAcquire' created them, with the pool's allocator.
+    if (!vvectorUsesAllocator(vec, (pool->has_alloc) ? &pool->alloc : 0)) return VEC_EMISMATCH;
+
+    ptrdiff_t capacity = vvectorGetCapacity(vec);
+    ptrdiff_t bytes = capacity * pool->element_size;
+    int cls = class_of_capacity(capacity);
+
+    ptrdiff_t retained = __atomic_add_fetch(&pool->retained_bytes, bytes, __ATOMIC_RELAXED);
+
+    if (cls < 0 || retained > pool->max_retained_bytes) {
+        __atomic_fetch_sub(&pool->retained_bytes, bytes, __ATOMIC_RELAXED);
+        return vvectorFree(vec);
+    }
+
+    vvectorClear(vec);
+
+    struct vvector_pool_tcache_ * tcache = get_tcache(pool);
+    if (tcache && tcache->counts[cls] < TCACHE_SLOTS) {
+        tcache->slots[cls][tcache->counts[cls]++] = vec;
+        return 0;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+
+    if (!pool->shared[cls]) {
+        pool->shared[cls] = vec_new_(sizeof(vvector), (pool->has_alloc) ? &pool->alloc : 0);
+    }
+
+    int err = (pool->shared[cls]) ? vvectorPushBack(pool->shared[cls], &vec) : VEC_ENOVEC;
+
+    pthread_mutex_unlock(&pool->lock);
+
+    if (err) {
+        __atomic_fetch_sub(&pool->retained_bytes, bytes, __ATOMIC_RELAXED);
+        return vvectorFree(vec);
+    }
+
+    return 0;
+}
+
+ptrdiff_t vvectorPoolGetRetainedBytes(struct vvectorPool * pool){
+    if (!pool) return 0;
+
+    return __atomic_load_n(&pool->retained_bytes, __ATOMIC_RELAXED);
+}
+
+int vvectorPoolFree(struct vvectorPool * pool){
+    if (!pool) return VEC_ENOVEC;
+
+    // Stops tcache_destroy from running for threads which exit later.
+    pthread_key_delete(pool->key);
+
+    struct vvector_pool_tcache_ * tcache = pool->tcaches;
+    while (tcache) {
+        struct vvector_pool_tcache_ * next = tcache->next;
+
+        for (int cls = 0; cls < NR_CLASSES; cls++) {
+            for (int i = 0; i < tcache->counts[cls]; i++) {
+                vvectorFree(tcache->slots[cls][i]);
+            }
+        }
+        pool_free(pool, tcache, sizeof(struct vvector_pool_tcache_));
+
+        tcache = next;
+    }
+
+    for (int cls = 0; cls < NR_CLASSES; cls++) {
+        if (!pool->shared[cls]) continue;
+
+        ptrdiff_t length = vvectorGetLength(pool->shared[cls]);
+        for (ptrdiff_t i = 0; i < length; i++) {
+            vvectorFree(*(vvector *) vvectorGetAt(pool->shared[cls], i));
+        }
+        vvectorFree(pool->shared[cls]);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pool_free(pool, pool, sizeof(struct vvectorPool));
+
+    return 0;
+}
@@ -0,0 +1,107 @@
+/*
+    Copyright 2024 I. Laurentiu
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef VVECTOR_POOL_H
+#define VVECTOR_POOL_H
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+#include "vvector.h"
+
+#include <stddef.h>
+
+/// @file vvector_pool.h
+
+/**
+ * @struct vvectorPool
+ *
+ * @brief   A cache of empty vvectors, sorted into power of two capacity classes.
+ *
+ * Code which creates and frees vvectors of similar sizes in a loop can acquire them from a pool instead.
+ * Released vvectors keep their memory, so once the pool is warm, acquiring and releasing never allocates.
+ *
+ * Every thread has a small private cache per pool, which is used before the shared, mutex protected lists.
+ * A global cap limits how many bytes the pool keeps around; vvectors released beyond it are freed.
+ *
+ * @code
+ * struct vvectorPool * pool = vvectorPoolNew(sizeof(float), 0, 64 << 20);
+ * for (int frame = 0; frame < nr_frames; frame++) {
+ *      vvector samples = vvectorPoolAcquire(pool, 4096);
+ *      // Fill and use samples...
+ *      vvectorPoolRelease(pool, samples);
+ * }
+ * vvectorPoolFree(pool);
+ * @endcode
+ */
+struct vvectorPool;
+
+/**
+ * @brief Create a new pool.
+ *
+ * @param   element_size        Element size of every vvector in this pool.
+ * @param   allocator           Allocator for the pooled vvectors and the pool itself, or NULL for defaults. @see vvectorAlloc.
+ * @param   max_retained_bytes  Upper bound on the element memory the pool keeps cached.
+ * @return  The new pool or NULL.
+ */
+struct vvectorPool * vvectorPoolNew(ptrdiff_t element_size, struct vvectorAlloc * allocator, ptrdiff_t max_retained_bytes);
+
+/**
+ * @brief Get an empty vvector with room for at least 'capacity' elements.
+ *
+ * Thread safe.
+ *
+ * @param   pool        The pool.
+ * @param   capacity    Minimum number of elements the vvector must hold without reallocating.
+ * @return  An empty vvector or NULL.
+ */
+vvector vvectorPoolAcquire(struct vvectorPool * pool, ptrdiff_t capacity);
+
+/**
+ * @brief Give a vvector back to the pool. It is cleared and kept for reuse, or freed if the pool is full.
+ *
+ * The vvector does not have to come from 'vvectorPoolAcquire', but must match the pool's element size and allocator.
+ * It must not be used afterwards. Thread safe.
+ *
+ * @param   pool    The pool.
+ * @param   vec     The vvector to release.
+ * @return  Returns 0 on success or a positive, non-zero value on error (the vvector is left untouched then).
+ */
+int vvectorPoolRelease(struct vvectorPool * pool, vvector vec);
+
+/**
+ * @brief Get the number of bytes of element memory currently cached by the pool.
+ *
+ * @param   pool    The pool.
+ * @return  The number of bytes, or 0 on error.
+ */
+ptrdiff_t vvectorPoolGetRetainedBytes(struct vvectorPool * pool);
+
+/**
+ * @brief Free the pool and every vvector cached in it, including those in other threads' caches.
+ *
+ * @warning No other thread may use the pool while, or after, this runs.
+ *
+ * @param   pool    The pool.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorPoolFree(struct vvectorPool * pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VVECTOR_POOL_H
@@ -0,0 +1,475 @@
+/*
+    Copyright 2024 I. Laurentiu
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "vvector_series.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// @file vvector_series.c
+
+#define VEC_ENOVEC 1        /**< Indicates that the provided series or vector argument is NULL. */
+#define VEC_EBADINDEX 2     /**< Indicates an invalid block index, or a timestamp older than the last one. */
+
+#define DEFAULT_BLOCK_POINTS 1024
+#define DECODE_CHUNK 256    /**< Points decoded on the stack before they are appended to the output vvectors. */
+
+/*
+ * Point encoding. The first point of a block is stored as 64 bit timestamp + 64 bit value.
+ *
+ * Timestamp, with dod = (t[i] - t[i-1]) - (t[i-1] - t[i-2]) (the first delta of a block is compared to 0):
+ *      '0'                         dod == 0
+ *      '10'   +  7 bit dod         dod in [-64, 63]
+ *      '110'  +  9 bit dod         dod in [-256, 255]
+ *      '1110' + 12 bit dod         dod in [-2048, 2047]
+ *      '1111' + 64 bit dod         anything else
+ *
+ * Value, with x = bits(v[i]) ^ bits(v[i-1]):
+ *      '0'                                                 x == 0
+ *      '10' + meaningful bits of x                         x fits in the previous leading/trailing zero window
+ *      '11' + 6 bit leading zeros + 6 bit (length - 1) + length meaningful bits
+ */
+
+/**
+ * @internal
+ * @struct series_block_
+ * @brief Index entry of one block.
+ */
+struct series_block_ {
+    int64_t first_timestamp;
+    int64_t last_timestamp;
+    ptrdiff_t bit_offset;       /**< Start of the block in the bit stream. */
+    ptrdiff_t count;            /**< Number of points in the block. */
+};
+
+/**
+ * @internal
+ * @struct series_state_
+ * @brief What encoding (and decoding) the next point depends on.
+ */
+struct series_state_ {
+    uint64_t timestamp;
+    uint64_t delta;
+    uint64_t value_bits;
+    int leading;                /**< Window of the last value written with the '11' header. */
+    int trailing;
+};
+
+struct vvectorSeries {
+    vvector words;              /**< uint64_t, the bit stream, most significant bit first. */
+    ptrdiff_t bit_length;
+    vvector blocks;             /**< struct series_block_ */
+    ptrdiff_t block_points;
+    ptrdiff_t length;
+    struct series_state_ state; /**< Encoder state after the last point. */
+    struct vvectorAlloc alloc;  /**< Used for this struct. Missing functions fall back to the C library. */
+};
+
+/* Helpers */
+
+static void * series_malloc(struct vvectorAlloc * alloc, ptrdiff_t size){
+    if (alloc && alloc->malloc_fn) return alloc->malloc_fn(size, alloc->ctx);
+
+    return malloc(size);
+}
+
+static void series_free(struct vvectorAlloc * alloc, void * ptr, ptrdiff_t size){
+    if (alloc && alloc->free_fn) {
+        alloc->free_fn(ptr, size, alloc->ctx);
+        return;
+    }
+
+    free(ptr);
+}
+
+static uint64_t double_to_bits(double value){
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    return bits;
+}
+
+static double bits_to_double(uint64_t bits){
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+
+    return value;
+}
+
+/**
+ * @internal
+ * @brief Sign extend the low 'nr_bits' bits of 'value'.
+ */
+static uint64_t sign_extend(uint64_t value, int nr_bits){
+    uint64_t sign = (uint64_t) 1 << (nr_bits - 1);
+
+    return (value ^ sign) - sign;
+}
+
+// << BIT STREAM >>
+
+/**
+ * @internal
+ * @brief Append the low 'nr_bits' (1 to 64) bits of 'value' to the bit stream.
+ */
+static int write_bits(struct vvectorSeries * series, uint64_t value, int nr_bits){
+    if (nr_bits < 64) value &= ((uint64_t) 1 << nr_bits) - 1;
+
+    int offset = (int) (series->bit_length % 64);
+    int free_bits = 64 - offset;
+
+    if (offset == 0) {
+        uint64_t zero = 0;
+        int err = vvectorPushBack(series->words, &zero);
+        if (err) return err;
+    }
+
+    uint64_t * word = vvectorGetBack(series->words);
+
+    if (nr_bits <= free_bits) {
+        *word |= value << (free_bits - nr_bits);
+    } else {
+        int spill = nr_bits - free_bits;
+        *word |= value >> spill;
+
+        uint64_t next = value << (64 - spill);
+        int err = vvectorPushBack(series->words, &next);
+        if (err) return err;
+    }
+
+    series->bit_length += nr_bits;
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @struct series_reader_
+ */
+struct series_reader_ {
+    const uint64_t * words;
+    ptrdiff_t position;
+};
+
+/**
+ * @internal
+ * @brief Read the next 'nr_bits' (1 to 64) bits.
+ */
+static uint64_t read_bits(struct series_reader_ * reader, int nr_bits){
+    ptrdiff_t index = reader->position / 64;
+    int offset = (int) (reader->position % 64);
+    int available = 64 - offset;
+
+    reader->position += nr_bits;
+
+    uint64_t head = reader->words[index] << offset;
+
+    if (nr_bits <= available) {
+        return head >> (64 - nr_bits);
+    }
+
+    // 'head' has its 'available' bits at the top, the rest comes from the next word.
+    int rest = nr_bits - available;
+
+    return (head >> (64 - nr_bits)) | (reader->words[index + 1] >> (64 - rest));
+}
+
+static int read_bit(struct series_reader_ * reader){
+    return (int) read_bits(reader, 1);
+}
+
+// << ENCODE >>
+
+static int encode_timestamp(struct vvectorSeries * series, uint64_t timestamp){
+    struct series_state_ * state = &series->state;
+
+    uint64_t delta = timestamp - state->timestamp;
+    int64_t dod = (int64_t) (delta - state->delta);
+
+    state->timestamp = timestamp;
+    state->delta = delta;
+
+    if (dod == 0) return write_bits(series, 0, 1);
+    if (dod >= -64 && dod <= 63) return write_bits(series, 2, 2) || write_bits(series, (uint64_t) dod, 7);
+    if (dod >= -256 && dod <= 255) return write_bits(series, 6, 3) || write_bits(series, (uint64_t) dod, 9);
+    if (dod >= -2048 && dod <= 2047) return write_bits(series, 14, 4) || write_bits(series, (uint64_t) dod, 12);
+
+    return write_bits(series, 15, 4) || write_bits(series, (uint64_t) dod, 64);
+}
+
+static int encode_value(struct vvectorSeries * series, uint64_t bits){
+    struct series_state_ * state = &series->state;
+
+    uint64_t x = bits ^ state->value_bits;
+    state->value_bits = bits;
+
+    if (x == 0) return write_bits(series, 0, 1);
+
+    int leading = __builtin_clzll(x);
+    int trailing = __builtin_ctzll(x);
+
+    if (leading >= state->leading && trailing >= state->trailing) {
+        int length = 64 - state->leading - state->trailing;
+        return write_bits(series, 2, 2) || write_bits(series, x >> state->trailing, length);
+    }
+
+    int length = 64 - leading - trailing;
+    state->leading = leading;
+    state->trailing = trailing;
+
+    return write_bits(series, 3, 2) || write_bits(series, (uint64_t) leading, 6) || write_bits(series, (uint64_t) (length - 1), 6)
+        || write_bits(series, x >> trailing, length);
+}
+
+/**
+ * @internal
+ * @brief Start a new block with an uncompressed point.
+ */
+static int start_block(struct vvectorSeries * series, int64_t timestamp, double value){
+    struct series_block_ block;
+    block.first_timestamp = timestamp;
+    block.last_timestamp = timestamp;
+    block.bit_offset = series->bit_length;
+    block.count = 1;
+
+    int err = write_bits(series, (uint64_t) timestamp, 64) || write_bits(series, double_to_bits(value), 64);
+    if (err) return err;
+
+    err = vvectorPushBack(series->blocks, &block);
+    if (err) return err;
+
+    series->state.timestamp = (uint64_t) timestamp;
+    series->state.delta = 0;
+    series->state.value_bits = double_to_bits(value);
+    // No window yet: the first non zero XOR of a block always writes one.
+    series->state.leading = 65;
+    series->state.trailing = 65;
+
+    return 0;
+}
+
+// << DECODE >>
+
+/**
+ * @internal
+ * @brief Decode block 'index', appending points with 'from' <= timestamp <= 'to'.
+ *
+ * @return 0 on success, with 'done' set if a timestamp past 'to' was seen. Non-zero on error.
+ */
+static int decode_block(struct vvectorSeries * series, ptrdiff_t index, int64_t from, int64_t to,
+                        vvector timestamps, vvector values, int * done){
+    const struct series_block_ * block = vvectorGetAt(series->blocks, index);
+
+    struct series_reader_ reader;
+    reader.words = vvectorGetFront(series->words);
+    reader.position = block->bit_offset;
+
+    struct series_state_ state;
+    state.timestamp = read_bits(&reader, 64);
+    state.delta = 0;
+    state.value_bits = read_bits(&reader, 64);
+    state.leading = 0;
+    state.trailing = 0;
+
+    int64_t ts_chunk[DECODE_CHUNK];
+    double value_chunk[DECODE_CHUNK];
+    ptrdiff_t nr_chunk = 0;
+
+    ptrdiff_t count = block->count;
+    int err = 0;
+    *done = 0;
+
+    for (ptrdiff_t i = 0; i < count; i++) {
+        if (i > 0) {
+            uint64_t dod;
+
+            if (!read_bit(&reader)) dod = 0;
+            else if (!read_bit(&reader)) dod = sign_extend(read_bits(&reader, 7), 7);
+            else if (!read_bit(&reader)) dod = sign_extend(read_bits(&reader, 9), 9);
+            else if (!read_bit(&reader)) dod = sign_extend(read_bits(&reader, 12), 12);
+            else dod = read_bits(&reader, 64);
+
+            state.delta += dod;
+            state.timestamp += state.delta;
+
+            if (read_bit(&reader)) {
+                if (read_bit(&reader)) {
+                    state.leading = (int) read_bits(&reader, 6);
+                    int length = (int) read_bits(&reader, 6) + 1;
+                    state.trailing = 64 - state.leading - length;
+                }
+
+                int length = 64 - state.leading - state.trailing;
+                state.value_bits ^= read_bits(&reader, length) << state.trailing;
+            }
+        }
+
+        int64_t timestamp = (int64_t) state.timestamp;
+
+        if (timestamp > to) {
+            *done = 1;
+            break;
+        }
+        if (timestamp < from) continue;
+
+        ts_chunk[nr_chunk] = timestamp;
+        value_chunk[nr_chunk] = bits_to_double(state.value_bits);
+
+        if (++nr_chunk == DECODE_CHUNK) {
+            if (timestamps) err = vvectorAppend(timestamps, ts_chunk, nr_chunk, VVECTOR_COPY_CACHED);
+            if (!err && values) err = vvectorAppend(values, value_chunk, nr_chunk, VVECTOR_COPY_CACHED);
+            if (err) return err;
+
+            nr_chunk = 0;
+        }
+    }
+
+    if (timestamps) err = vvectorAppend(timestamps, ts_chunk, nr_chunk, VVECTOR_COPY_CACHED);
+    if (!err && values) err = vvectorAppend(values, value_chunk, nr_chunk, VVECTOR_COPY_CACHED);
+
+    return err;
+}
+
+static int check_outputs(vvector timestamps, vvector values){
+    if (timestamps && (!*timestamps || vvectorGetElementSize(timestamps) != sizeof(int64_t))) return VEC_ENOVEC;
+    if (values && (!*values || vvectorGetElementSize(values) != sizeof(double))) return VEC_ENOVEC;
+
+    return 0;
+}
+
+/* Series functions */
+
+struct vvectorSeries * vvectorSeriesNew(ptrdiff_t block_points, struct vvectorAlloc * allocator){
+    if (block_points < 0) return 0;
+
+    struct vvectorSeries * series = series_malloc(allocator, sizeof(struct vvectorSeries));
+    if (!series) return 0;
+
+    memset(series, 0, sizeof(struct vvectorSeries));
+    if (allocator) series->alloc = *allocator;
+    series->block_points = (block_points > 0) ? block_points : DEFAULT_BLOCK_POINTS;
+
+    series->words = vec_new_(sizeof(uint64_t), allocator);
+    series->blocks = vec_new_(sizeof(struct series_block_), allocator);
+
+    if (!series->words || !series->blocks) {
+        vvectorSeriesFree(series);
+        return 0;
+    }
+
+    return series;
+}
+
+int vvectorSeriesFree(struct vvectorSeries * series){
+    if (!series) return VEC_ENOVEC;
+
+    if (series->words) vvectorFree(series->words);
+    if (series->blocks) vvectorFree(series->blocks);
+
+    struct vvectorAlloc alloc = series->alloc;
+    series_free(&alloc, series, sizeof(struct vvectorSeries));
+
+    return 0;
+}
+
+int vvectorSeriesAppend(struct vvectorSeries * series, int64_t timestamp, double value){
+    if (!series) return VEC_ENOVEC;
+
+    struct series_block_ * block = vvectorGetBack(series->blocks);
+
+    if (block && timestamp < block->last_timestamp) return VEC_EBADINDEX;
+
+    int err;
+
+    if (!block || block->count == series->block_points) {
+        err = start_block(series, timestamp, value);
+    } else {
+        err = encode_timestamp(series, (uint64_t) timestamp) || encode_value(series, double_to_bits(value));
+
+        if (!err) {
+            block->last_timestamp = timestamp;
+            block->count++;
+        }
+    }
+
+    // A failed write leaves the stream unusable, like any other out of memory error in the library.
+    if (err) return err;
+
+    series->length++;
+
+    return 0;
+}
+
+int vvectorSeriesQuery(struct vvectorSeries * series, int64_t from, int64_t to, vvector timestamps, vvector values){
+    if (!series) return VEC_ENOVEC;
+
+    int err = check_outputs(timestamps, values);
+    if (err) return err;
+
+    ptrdiff_t nr_blocks = vvectorGetLength(series->blocks);
+    if (nr_blocks == 0 || from > to) return 0;
+
+    const struct series_block_ * blocks = vvectorGetFront(series->blocks);
+
+    // First block which ends at or after 'from'. Blocks are sorted, as are timestamps.
+    ptrdiff_t low = 0;
+    ptrdiff_t high = nr_blocks;
+    while (low < high) {
+        ptrdiff_t middle = low + (high - low) / 2;
+
+        if (blocks[middle].last_timestamp < from) low = middle + 1;
+        else high = middle;
+    }
+
+    int done = 0;
+    for (ptrdiff_t i = low; i < nr_blocks && !done; i++) {
+        err = decode_block(series, i, from, to, timestamps, values, &done);
+        if (err) return err;
+    }
+
+    return 0;
+}
+
+int vvectorSeriesDecodeBlock(struct vvectorSeries * series, ptrdiff_t block, vvector timestamps, vvector values){
+    if (!series) return VEC_ENOVEC;
+
+    if (block < 0 || block >= vvectorGetLength(series->blocks)) return VEC_EBADINDEX;
+
+    int err = check_outputs(timestamps, values);
+    if (err) return err;
+
+    int done;
+
+    return decode_block(series, block, INT64_MIN, INT64_MAX, timestamps, values, &done);
+}
+
+ptrdiff_t vvectorSeriesGetLength(struct vvectorSeries * series){
+    if (!series) return 0;
+
+    return series->length;
+}
+
+ptrdiff_t vvectorSeriesGetNrBlocks(struct vvectorSeries * series){
+    if (!series) return 0;
+
+    return vvectorGetLength(series->blocks);
+}
+
+ptrdiff_t vvectorSeriesGetCompressedSize(struct vvectorSeries * series){
+    if (!series) return 0;
+
+    return (series->bit_length + 7) / 8 + vvectorGetLength(series->blocks) * (ptrdiff_t) sizeof(struct series_block_);
+}
@@ -0,0 +1,133 @@
+/*
+    Copyright 2024 I. Laurentiu
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef VVECTOR_SERIES_H
+#define VVECTOR_SERIES_H
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+#include "vvector.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @file vvector_series.h
+
+/**
+ * @struct vvectorSeries
+ *
+ * @brief   A compressed list of (timestamp, value) points, in timestamp order.
+ *
+ * Points are compressed like in Facebook's Gorilla: timestamps as the difference between consecutive deltas
+ * (0 bits + 1 for regular intervals), values as the XOR with the previous value (1 bit if unchanged).
+ * Typical telemetry needs 1 to 2 bytes per point instead of 16.
+ *
+ * The bit stream is split into blocks of a fixed number of points, each starting with an uncompressed point.
+ * A small index of blocks (first and last timestamp, bit offset) lets range queries skip straight to the first block they need.
+ *
+ * @code
+ * struct vvectorSeries * cpu = vvectorSeriesNew(0, 0);
+ * vvectorSeriesAppend(cpu, now, load);
+ *
+ * vvector timestamps = vvectorNew(int64_t, 0);
+ * vvector values = vvectorNew(double, 0);
+ * vvectorSeriesQuery(cpu, now - 3600, now, timestamps, values);
+ * @endcode
+ */
+struct vvectorSeries;
+
+/**
+ * @brief Create a new, empty series.
+ *
+ * @param   block_points    Number of points per block, or 0 for the default (1024). Smaller blocks make range queries seek closer to their start, but compress slightly worse.
+ * @param   allocator       Allocator for the series' storage, or NULL for defaults. @see vvectorAlloc.
+ * @return  The new series or NULL.
+ */
+struct vvectorSeries * vvectorSeriesNew(ptrdiff_t block_points, struct vvectorAlloc * allocator);
+
+/**
+ * @brief Free the series.
+ *
+ * @param   series  The series.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorSeriesFree(struct vvectorSeries * series);
+
+/**
+ * @brief Add a point at the end, in O(1) amortized time.
+ *
+ * @param   series      The series.
+ * @param   timestamp   Timestamp of the point. Must not be smaller than the last appended one.
+ * @param   value       Value of the point.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorSeriesAppend(struct vvectorSeries * series, int64_t timestamp, double value);
+
+/**
+ * @brief Decode every point with 'from' <= timestamp <= 'to', appending them to two vvectors.
+ *
+ * Blocks which end before 'from' are never decoded.
+ *
+ * @param   series      The series.
+ * @param   from        First timestamp of the range.
+ * @param   to          Last timestamp of the range.
+ * @param   timestamps  vvector of int64_t which receives the timestamps, or NULL.
+ * @param   values      vvector of double which receives the values, or NULL.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorSeriesQuery(struct vvectorSeries * series, int64_t from, int64_t to, vvector timestamps, vvector values);
+
+/**
+ * @brief Decode one block, appending its points to two vvectors.
+ *
+ * @param   series      The series.
+ * @param   block       Index of the block, in [0, vvectorSeriesGetNrBlocks).
+ * @param   timestamps  vvector of int64_t which receives the timestamps, or NULL.
+ * @param   values      vvector of double which receives the values, or NULL.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorSeriesDecodeBlock(struct vvectorSeries * series, ptrdiff_t block, vvector timestamps, vvector values);
+
+/**
+ * @brief Get the number of points.
+ *
+ * @param   series  The series.
+ * @return  The number of points, or 0 on error.
+ */
+ptrdiff_t vvectorSeriesGetLength(struct vvectorSeries * series);
+
+/**
+ * @brief Get the number of blocks.
+ *
+ * @param   series  The series.
+ * @return  The number of blocks, or 0 on error.
+ */
+ptrdiff_t vvectorSeriesGetNrBlocks(struct vvectorSeries * series);
+
+/**
+ * @brief Get the size of the compressed points, including the block index.
+ *
+ * @param   series  The series.
+ * @return  The size in bytes, or 0 on error.
+ */
+ptrdiff_t vvectorSeriesGetCompressedSize(struct vvectorSeries * series);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VVECTOR_SERIES_H
@@ -0,0 +1,904 @@
+/*
+    Copyright 2024 I. Laurentiu
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+// pthread_*
+#define _POSIX_C_SOURCE 200809L
+
+#include "vvector_sort.h"
+#include "vvector_dispatch.h"
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// @file vvector_sort.c
+
+#define VEC_ENOVEC 1        /**< Indicates that a vector argument is NULL or an allocation failed. */
+#define VEC_EBADINDEX 2     /**< Indicates that a type or a permutation is invalid. */
+#define VEC_ENOVALUE 3      /**< Indicates that the comparison callback is NULL. */
+#define VEC_EMISMATCH 4     /**< Indicates that element sizes or lengths do not match. */
+
+#define RADIX_BITS 11
+#define RADIX_SIZE (1 << RADIX_BITS)
+#define INSERTION_RUN 32            /**< Merge sort starts from insertion sorted runs of this length. */
+#define MIN_ROWS_PER_THREAD 65536
+#define MSD_BUCKETS 256
+#define MSD_INSERTION_MAX 32        /**< Byte key buckets up to this size are insertion sorted. */
+
+/**
+ * @internal
+ * @struct sort_pair_
+ * @brief A key, transformed so unsigned order is the key's order, and the index it came from.
+ */
+struct sort_pair_ {
+    uint64_t key;
+    ptrdiff_t index;
+};
+
+/**
+ * @internal
+ * @struct permute_task_
+ * @brief One thread's slice of 'vvectorApplyPermutationTo'.
+ */
+struct permute_task_ {
+    vvector vec;
+    const ptrdiff_t * permutation;
+    uint8_t * out;
+    ptrdiff_t first;
+    ptrdiff_t last;
+    ptrdiff_t element_size;
+    int err;
+    pthread_t thread;
+    int started;
+};
+
+/**
+ * @internal
+ * @struct msd_sort_
+ * @brief Layout of the elements and one thread's scratch for the byte key sort.
+ */
+struct msd_sort_ {
+    ptrdiff_t size;         /**< Element size. */
+    ptrdiff_t key_offset;
+    ptrdiff_t key_size;
+    ptrdiff_t * counts;     /**< MSD_BUCKETS counters per key byte, so every level of the recursion keeps its own. */
+    ptrdiff_t * cursors;    /**< MSD_BUCKETS write positions. */
+    uint8_t * tmp;          /**< One element. */
+};
+
+/**
+ * @internal
+ * @struct msd_bucket_
+ * @brief A top level bucket of the byte key sort.
+ */
+struct msd_bucket_ {
+    ptrdiff_t first;
+    ptrdiff_t count;
+};
+
+/**
+ * @internal
+ * @struct msd_task_
+ * @brief One thread of 'vvectorSortBytes': a slice of rows for the top level pass, then whole buckets.
+ */
+struct msd_task_ {
+    struct msd_sort_ sort;
+    uint8_t * data;
+    uint8_t * scratch;
+    ptrdiff_t first;
+    ptrdiff_t last;
+    ptrdiff_t depth;
+    ptrdiff_t counts[MSD_BUCKETS];      /**< Histogram of the slice, then its write positions in 'scratch'. */
+
+    const struct msd_bucket_ * buckets;
+    int nr_buckets;
+    int * next_bucket;                  /**< Shared by all tasks, buckets are taken in order. */
+
+    pthread_t thread;
+    int started;
+};
+
+/* Helpers */
+
+static void * sort_malloc(struct vvectorAlloc * alloc, ptrdiff_t size){
+    if (alloc && alloc->malloc_fn) return alloc->malloc_fn(size, alloc->ctx);
+
+    return malloc(size);
+}
+
+static void sort_free(struct vvectorAlloc * alloc, void * ptr, ptrdiff_t size){
+    if (alloc && alloc->free_fn) {
+        alloc->free_fn(ptr, size, alloc->ctx);
+        return;
+    }
+
+    free(ptr);
+}
+
+static ptrdiff_t type_size(enum vvectorScalarType type){
+    switch (type) {
+        case VVECTOR_INT8: return sizeof(int8_t);
+        case VVECTOR_INT16: return sizeof(int16_t);
+        case VVECTOR_INT32: return sizeof(int32_t);
+        case VVECTOR_INT64: return sizeof(int64_t);
+        case VVECTOR_FLOAT: return sizeof(float);
+        case VVECTOR_DOUBLE: return sizeof(double);
+        default: return 0;
+    }
+}
+
+/**
+ * @internal
+ * @brief Fill 'pairs' with keys whose unsigned order is the numeric order: signed integers get their sign bit flipped,
+ * negative floats all their bits, positive floats their sign bit.
+ */
+static void load_pairs(const void * keys, enum vvectorScalarType type, ptrdiff_t n, struct sort_pair_ * pairs){
+    for (ptrdiff_t i = 0; i < n; i++) pairs[i].index = i;
+
+    switch (type) {
+        case VVECTOR_INT8:
+            for (ptrdiff_t i = 0; i < n; i++) pairs[i].key = (uint8_t) ((const int8_t *) keys)[i] ^ 0x80u;
+            break;
+        case VVECTOR_INT16:
+            for (ptrdiff_t i = 0; i < n; i++) pairs[i].key = (uint16_t) ((const int16_t *) keys)[i] ^ 0x8000u;
+            break;
+        case VVECTOR_INT32:
+            for (ptrdiff_t i = 0; i < n; i++) pairs[i].key = (uint32_t) ((const int32_t *) keys)[i] ^ 0x80000000u;
+            break;
+        case VVECTOR_INT64:
+            for (ptrdiff_t i = 0; i < n; i++) pairs[i].key = (uint64_t) ((const int64_t *) keys)[i] ^ ((uint64_t) 1 << 63);
+            break;
+        case VVECTOR_FLOAT:
+            for (ptrdiff_t i = 0; i < n; i++) {
+                uint32_t bits;
+                memcpy(&bits, (const float *) keys + i, 4);
+                pairs[i].key = (bits >> 31) ? ~bits : (bits | 0x80000000u);
+            }
+            break;
+        default:
+            for (ptrdiff_t i = 0; i < n; i++) {
+                uint64_t bits;
+                memcpy(&bits, (const double *) keys + i, 8);
+                pairs[i].key = (bits >> 63) ? ~bits : (bits | ((uint64_t) 1 << 63));
+            }
+            break;
+    }
+}
+
+/**
+ * @internal
+ * @brief Inverse of 'load_pairs': write the numbers the sorted keys came from to 'values'.
+ */
+static void store_keys(const struct sort_pair_ * pairs, enum vvectorScalarType type, ptrdiff_t n, void * values){
+    switch (type) {
+        case VVECTOR_INT8:
+            for (ptrdiff_t i = 0; i < n; i++) ((int8_t *) values)[i] = (int8_t) (pairs[i].key ^ 0x80u);
+            break;
+        case VVECTOR_INT16:
+            for (ptrdiff_t i = 0; i < n; i++) ((int16_t *) values)[i] = (int16_t) (pairs[i].key ^ 0x8000u);
+            break;
+        case VVECTOR_INT32:
+            for (ptrdiff_t i = 0; i < n; i++) ((int32_t *) values)[i] = (int32_t) (pairs[i].key ^ 0x80000000u);
+            break;
+        case VVECTOR_INT64:
+            for (ptrdiff_t i = 0; i < n; i++) ((int64_t *) values)[i] = (int64_t) (pairs[i].key ^ ((uint64_t) 1 << 63));
+            break;
+        case VVECTOR_FLOAT:
+            for (ptrdiff_t i = 0; i < n; i++) {
+                uint32_t key = (uint32_t) pairs[i].key;
+                uint32_t bits = (key >> 31) ? (key & 0x7FFFFFFFu) : ~key;
+                memcpy((float *) values + i, &bits, 4);
+            }
+            break;
+        default:
+            for (ptrdiff_t i = 0; i < n; i++) {
+                uint64_t key = pairs[i].key;
+                uint64_t bits = (key >> 63) ? (key & ~((uint64_t) 1 << 63)) : ~key;
+                memcpy((double *) values + i, &bits, 8);
+            }
+            break;
+    }
+}
+
+/**
+ * @internal
+ * @brief Stable LSD radix sort of 'pairs' by their low 'key_bits' bits.
+ *
+ * @param   pairs       The pairs to sort.
+ * @param   scratch     Space for 'n' more pairs.
+ * @param   counts      Space for one histogram per digit.
+ * @return  Either 'pairs' or 'scratch', whichever holds the sorted result.
+ */
+static struct sort_pair_ * radix_sort_pairs(struct sort_pair_ * pairs, struct sort_pair_ * scratch, ptrdiff_t n, int key_bits, ptrdiff_t * counts){
+    int nr_digits = (key_bits + RADIX_BITS - 1) / RADIX_BITS;
+
+    // Every histogram in one read of the keys.
+    memset(counts, 0, nr_digits * RADIX_SIZE * sizeof(ptrdiff_t));
+
+    for (ptrdiff_t i = 0; i < n; i++) {
+        uint64_t key = pairs[i].key;
+        for (int d = 0; d < nr_digits; d++) counts[d * RADIX_SIZE + ((key >> (d * RADIX_BITS)) & (RADIX_SIZE - 1))]++;
+    }
+
+    for (int d = 0; d < nr_digits; d++) {
+        ptrdiff_t * digit_counts = &counts[d * RADIX_SIZE];
+        int shift = d * RADIX_BITS;
+
+        // Every key has the same digit: the pass would not move anything.
+        if (digit_counts[(pairs[0].key >> shift) & (RADIX_SIZE - 1)] == n) continue;
+
+        ptrdiff_t sum = 0;
+        for (ptrdiff_t b = 0; b < RADIX_SIZE; b++) {
+            ptrdiff_t count = digit_counts[b];
+            digit_counts[b] = sum;
+            sum += count;
+        }
+
+        for (ptrdiff_t i = 0; i < n; i++) {
+            scratch[digit_counts[(pairs[i].key >> shift) & (RADIX_SIZE - 1)]++] = pairs[i];
+        }
+
+        struct sort_pair_ * tmp = pairs;
+        pairs = scratch;
+        scratch = tmp;
+    }
+
+    return pairs;
+}
+
+static int check_permutation_output(vvector permutation){
+    if (!permutation || !*permutation) return VEC_ENOVEC;
+
+    return (vvectorGetElementSize(permutation) == sizeof(ptrdiff_t)) ? 0 : VEC_EMISMATCH;
+}
+
+/**
+ * @internal
+ * @brief Sort at most VVECTOR_SMALL_SORT_MAX numbers with the small sort kernels. 8 and 16 bit integers are widened to 32 bits.
+ */
+static void sort_small(void * data, enum vvectorScalarType type, ptrdiff_t n){
+    int32_t wide[VVECTOR_SMALL_SORT_MAX];
+
+    switch (type) {
+        case VVECTOR_INT8:
+            for (ptrdiff_t i = 0; i < n; i++) wide[i] = ((int8_t *) data)[i];
+            vvector_kernels_.sort_i32(wide, n);
+            for (ptrdiff_t i = 0; i < n; i++) ((int8_t *) data)[i] = (int8_t) wide[i];
+            break;
+        case VVECTOR_INT16:
+            for (ptrdiff_t i = 0; i < n; i++) wide[i] = ((int16_t *) data)[i];
+            vvector_kernels_.sort_i32(wide, n);
+            for (ptrdiff_t i = 0; i < n; i++) ((int16_t *) data)[i] = (int16_t) wide[i];
+            break;
+        case VVECTOR_INT32: vvector_kernels_.sort_i32(data, n); break;
+        case VVECTOR_INT64: vvector_kernels_.sort_i64(data, n); break;
+        case VVECTOR_FLOAT: vvector_kernels_.sort_f32(data, n); break;
+        default: vvector_kernels_.sort_f64(data, n); break;
+    }
+}
+
+/**
+ * @internal
+ * @brief Argsort of at most VVECTOR_SMALL_SORT_MAX keys of up to 32 bits with the 64 bit small sort kernel.
+ *
+ * Every key is packed with its index into one integer, key in the high half, so equal keys stay in index order.
+ */
+static void argsort_small(const void * keys, enum vvectorScalarType type, ptrdiff_t n, ptrdiff_t * out){
+    struct sort_pair_ pairs[VVECTOR_SMALL_SORT_MAX];
+    int64_t packed[VVECTOR_SMALL_SORT_MAX];
+
+    load_pairs(keys, type, n, pairs);
+
+    // Flipping the top bit turns the unsigned order of the packed keys into the kernel's signed order.
+    for (ptrdiff_t i = 0; i < n; i++) packed[i] = (int64_t) (((pairs[i].key << 32) | (uint64_t) i) ^ ((uint64_t) 1 << 63));
+
+    vvector_kernels_.sort_i64(packed, n);
+
+    for (ptrdiff_t i = 0; i < n; i++) out[i] = (ptrdiff_t) (uint32_t) packed[i];
+}
+
+// << SORT >>
+
+int vvectorSort(vvector vec, enum vvectorScalarType type, struct vvectorAlloc * allocator){
+    if (!vec || !*vec) return VEC_ENOVEC;
+
+    ptrdiff_t size = type_size(type);
+    if (size == 0) return VEC_EBADINDEX;
+
+    if (vvectorGetElementSize(vec) != size) return VEC_EMISMATCH;
+
+    ptrdiff_t n = vvectorGetLength(vec);
+    if (n < 2) return 0;
+
+    if (n <= VVECTOR_SMALL_SORT_MAX) {
+        sort_small(vvectorGetFront(vec), type, n);
+        return 0;
+    }
+
+    int key_bits = (int) size * 8;
+    ptrdiff_t counts_size = ((key_bits + RADIX_BITS - 1) / RADIX_BITS) * RADIX_SIZE * (ptrdiff_t) sizeof(ptrdiff_t);
+    ptrdiff_t scratch_size = 2 * n * (ptrdiff_t) sizeof(struct sort_pair_) + counts_size;
+    uint8_t * scratch = sort_malloc(allocator, scratch_size);
+    if (!scratch) return VEC_ENOVEC;
+
+    struct sort_pair_ * pairs = (struct sort_pair_ *) scratch;
+    ptrdiff_t * counts = (ptrdiff_t *) (scratch + 2 * n * sizeof(struct sort_pair_));
+
+    load_pairs(vvectorGetFront(vec), type, n, pairs);
+    store_keys(radix_sort_pairs(pairs, pairs + n, n, key_bits, counts), type, n, vvectorGetFront(vec));
+
+    sort_free(allocator, scratch, scratch_size);
+
+    return 0;
+}
+
+// << ARGSORT >>
+
+int vvectorArgsort(vvector keys, enum vvectorScalarType type, vvector permutation, struct vvectorAlloc * allocator){
+    if (!keys || !*keys) return VEC_ENOVEC;
+
+    int err = check_permutation_output(permutation);
+    if (err) return err;
+
+    ptrdiff_t size = type_size(type);
+    if (size == 0) return VEC_EBADINDEX;
+
+    if (vvectorGetElementSize(keys) != size) return VEC_EMISMATCH;
+
+    ptrdiff_t n = vvectorGetLength(keys);
+
+    err = vvectorResizeUninit(permutation, n);
+    if (err || n == 0) return err;
+
+    if (n <= VVECTOR_SMALL_SORT_MAX && size <= 4) {
+        argsort_small(vvectorGetFront(keys), type, n, vvectorGetFront(permutation));
+        return 0;
+    }
+
+    // Scratch: the pairs, as many again to scatter into, and the histograms.
+    int key_bits = (int) size * 8;
+    ptrdiff_t counts_size = ((key_bits + RADIX_BITS - 1) / RADIX_BITS) * RADIX_SIZE * (ptrdiff_t) sizeof(ptrdiff_t);
+    ptrdiff_t scratch_size = 2 * n * (ptrdiff_t) sizeof(struct sort_pair_) + counts_size;
+    uint8_t * scratch = sort_malloc(allocator, scratch_size);
+    if (!scratch) return VEC_ENOVEC;
+
+    struct sort_pair_ * pairs = (struct sort_pair_ *) scratch;
+    ptrdiff_t * counts = (ptrdiff_t *) (scratch + 2 * n * sizeof(struct sort_pair_));
+
+    load_pairs(vvectorGetFront(keys), type, n, pairs);
+
+    struct sort_pair_ * sorted = radix_sort_pairs(pairs, pairs + n, n, key_bits, counts);
+
+    ptrdiff_t * out = vvectorGetFront(permutation);
+    for (ptrdiff_t i = 0; i < n; i++) out[i] = sorted[i].index;
+
+    sort_free(allocator, scratch, scratch_size);
+
+    return 0;
+}
+
+int vvectorArgsortBy(vvector vec, vvectorCompareFn compare, void * ctx, vvector permutation, struct vvectorAlloc * allocator){
+    if (!vec || !*vec) return VEC_ENOVEC;
+
+    if (!compare) return VEC_ENOVALUE;
+
+    int err = check_permutation_output(permutation);
+    if (err) return err;
+
+    ptrdiff_t n = vvectorGetLength(vec);
+
+    err = vvectorResizeUninit(permutation, n);
+    if (err || n == 0) return err;
+
+    ptrdiff_t scratch_size = n * (ptrdiff_t) sizeof(ptrdiff_t);
+    ptrdiff_t * scratch = sort_malloc(allocator, scratch_size);
+    if (!scratch) return VEC_ENOVEC;
+
+    const uint8_t * data = vvectorGetFront(vec);
+    ptrdiff_t size = vvectorGetElementSize(vec);
+    ptrdiff_t * from = vvectorGetFront(permutation);
+    ptrdiff_t * to = scratch;
+
+    // Insertion sorted runs; moving only on 'greater than' keeps equal elements in order.
+    for (ptrdiff_t run = 0; run < n; run += INSERTION_RUN) {
+        ptrdiff_t end = (run + INSERTION_RUN < n) ? run + INSERTION_RUN : n;
+
+        for (ptrdiff_t i = run; i < end; i++) {
+            ptrdiff_t j = i;
+
+            while (j > run && compare(data + from[j - 1] * size, data + i * size, ctx) > 0) {
+                from[j] = from[j - 1];
+                j--;
+            }
+            from[j] = i;
+        }
+    }
+
+    // Bottom up merges, taking from the left run on ties.
+    for (ptrdiff_t width = INSERTION_RUN; width < n; width *= 2) {
+        for (ptrdiff_t left = 0; left < n; left += 2 * width) {
+            ptrdiff_t middle = (left + width < n) ? left + width : n;
+            ptrdiff_t right = (left + 2 * width < n) ? left + 2 * width : n;
+            ptrdiff_t i = left;
+            ptrdiff_t j = middle;
+            ptrdiff_t k = left;
+
+            while (i < middle && j < right) {
+                if (compare(data + from[j] * size, data + from[i] * size, ctx) < 0) to[k++] = from[j++];
+                else to[k++] = from[i++];
+            }
+            while (i < middle) to[k++] = from[i++];
+            while (j < right) to[k++] = from[j++];
+        }
+
+        ptrdiff_t * tmp = from;
+        from = to;
+        to = tmp;
+    }
+
+    if (from != (ptrdiff_t *) vvectorGetFront(permutation)) memcpy(vvectorGetFront(permutation), from, n * sizeof(ptrdiff_t));
+
+    sort_free(allocator, scratch, scratch_size);
+
+    return 0;
+}
+
+// << PERMUTATIONS >>
+
+/**
+ * @internal
+ * @brief Move every element along its cycle: data[j] = data[permutation[j]], until the cycle returns to its start.
+ * 'size' is a constant at each call site.
+ */
+static inline void apply_cycles(uint8_t * data, const ptrdiff_t * permutation, uint64_t * visited, ptrdiff_t n, ptrdiff_t size, uint8_t * tmp){
+    for (ptrdiff_t start = 0; start < n; start++) {
+        if (visited[start / 64] & ((uint64_t) 1 << (start % 64))) continue;
+
+        if (permutation[start] == start) continue;
+
+        memcpy(tmp, data + start * size, size);
+        ptrdiff_t j = start;
+
+        for (;;) {
+            visited[j / 64] |= (uint64_t) 1 << (j % 64);
+
+            ptrdiff_t k = permutation[j];
+            if (k == start) break;
+
+            memcpy(data + j * size, data + k * size, size);
+            j = k;
+        }
+
+        memcpy(data + j * size, tmp, size);
+    }
+}
+
+int vvectorApplyPermutation(vvector vec, vvector permutation, struct vvectorAlloc * allocator){
+    if (!vec || !*vec) return VEC_ENOVEC;
+
+    int err = check_permutation_output(permutation);
+    if (err) return err;
+
+    ptrdiff_t n = vvectorGetLength(vec);
+
+    if (vvectorGetLength(permutation) != n) return VEC_EMISMATCH;
+
+    if (n == 0) return 0;
+
+    ptrdiff_t size = vvectorGetElementSize(vec);
+    ptrdiff_t bitmap_size = (n + 63) / 64 * (ptrdiff_t) sizeof(uint64_t);
+    ptrdiff_t scratch_size = bitmap_size + size;
+    uint8_t * scratch = sort_malloc(allocator, scratch_size);
+    if (!scratch) return VEC_ENOVEC;
+
+    uint64_t * visited = (uint64_t *) scratch;
+    uint8_t * tmp = scratch + bitmap_size;
+    const ptrdiff_t * order = vvectorGetFront(permutation);
+
+    // A repeated or out of range index would send a cycle through visited positions forever: check first.
+    memset(visited, 0, bitmap_size);
+
+    for (ptrdiff_t i = 0; i < n; i++) {
+        ptrdiff_t p = order[i];
+
+        if (p < 0 || p >= n || (visited[p / 64] & ((uint64_t) 1 << (p % 64)))) {
+            sort_free(allocator, scratch, scratch_size);
+            return VEC_EBADINDEX;
+        }
+
+        visited[p / 64] |= (uint64_t) 1 << (p % 64);
+    }
+
+    memset(visited, 0, bitmap_size);
+
+    uint8_t * data = vvectorGetFront(vec);
+
+    // Fixed size copies compile to a single move.
+    switch (size) {
+        case 4: apply_cycles(data, order, visited, n, 4, tmp); break;
+        case 8: apply_cycles(data, order, visited, n, 8, tmp); break;
+        case 16: apply_cycles(data, order, visited, n, 16, tmp); break;
+        default: apply_cycles(data, order, visited, n, size, tmp); break;
+    }
+
+    sort_free(allocator, scratch, scratch_size);
+
+    return 0;
+}
+
+static void * permute_slice(void * arg){
+    struct permute_task_ * task = arg;
+
+    if (task->first < task->last) {
+        task->err = vvectorGather(task->vec, task->permutation + task->first, task->last - task->first,
+                                  task->out + task->first * task->element_size);
+    }
+
+    return 0;
+}
+
+int vvectorApplyPermutationTo(vvector vec, vvector permutation, vvector out, int nr_threads, struct vvectorAlloc * allocator){
+    if (!vec || !*vec || !out || !*out) return VEC_ENOVEC;
+
+    int err = check_permutation_output(permutation);
+    if (err) return err;
+
+    if (out == vec || out == permutation) return VEC_EBADINDEX;
+
+    ptrdiff_t size = vvectorGetElementSize(vec);
+
+    if (vvectorGetElementSize(out) != size) return VEC_EMISMATCH;
+
+    ptrdiff_t n = vvectorGetLength(permutation);
+
+    err = vvectorResizeUninit(out, n);
+    if (err || n == 0) return err;
+
+    if (nr_threads < 1) nr_threads = 1;
+    if (nr_threads > 1 && n / nr_threads < MIN_ROWS_PER_THREAD) nr_threads = (int) (n / MIN_ROWS_PER_THREAD);
+    if (nr_threads < 1) nr_threads = 1;
+
+    struct permute_task_ tasks_on_stack[16];
+    ptrdiff_t tasks_size = nr_threads * (ptrdiff_t) sizeof(struct permute_task_);
+    struct permute_task_ * tasks = (nr_threads <= 16) ? tasks_on_stack : sort_malloc(allocator, tasks_size);
+    if (!tasks) return VEC_ENOVEC;
+
+    for (int t = 0; t < nr_threads; t++) {
+        tasks[t].vec = vec;
+        tasks[t].permutation = vvectorGetFront(permutation);
+        tasks[t].out = vvectorGetFront(out);
+        tasks[t].first = n * t / nr_threads;
+        tasks[t].last = n * (t + 1) / nr_threads;
+        tasks[t].element_size = size;
+        tasks[t].err = 0;
+    }
+
+    for (int t = 1; t < nr_threads; t++) {
+        tasks[t].started = (pthread_create(&tasks[t].thread, 0, permute_slice, &tasks[t]) == 0);
+        if (!tasks[t].started) permute_slice(&tasks[t]);
+    }
+
+    permute_slice(&tasks[0]);
+
+    for (int t = 1; t < nr_threads; t++) {
+        if (tasks[t].started) pthread_join(tasks[t].thread, 0);
+    }
+
+    for (int t = 0; t < nr_threads; t++) err = err ? err : tasks[t].err;
+
+    if (tasks != tasks_on_stack) sort_free(allocator, tasks, tasks_size);
+
+    return err;
+}
+
+// << BYTE KEYS >>
+
+/**
+ * @internal
+ * @brief Insertion sort of 'n' elements whose keys agree on the bytes before 'depth'. Stable.
+ */
+static void msd_insertion_sort(const struct msd_sort_ * s, uint8_t * data, ptrdiff_t n, ptrdiff_t depth){
+    ptrdiff_t size = s->size;
+    ptrdiff_t offset = s->key_offset + depth;
+    size_t len = (size_t) (s->key_size - depth);
+
+    for (ptrdiff_t i = 1; i < n; i++) {
+        uint8_t * element = data + i * size;
+        if (memcmp(element - size + offset, element + offset, len) <= 0) continue;
+
+        memcpy(s->tmp, element, size);
+
+        ptrdiff_t j = i;
+        do {
+            memcpy(data + j * size, data + (j - 1) * size, size);
+            j--;
+        } while (j > 0 && memcmp(data + (j - 1) * size + offset, s->tmp + offset, len) > 0);
+
+        memcpy(data + j * size, s->tmp, size);
+    }
+}
+
+/**
+ * @internal
+ * @brief Histogram of byte 'depth' of the keys of 'n' > 0 elements.
+ * @return The byte if all keys have the same one, -1 otherwise.
+ */
+static int msd_histogram(const struct msd_sort_ * s, const uint8_t * data, ptrdiff_t n, ptrdiff_t depth, ptrdiff_t * counts){
+    const uint8_t * bytes = data + s->key_offset + depth;
+
+    memset(counts, 0, MSD_BUCKETS * sizeof(ptrdiff_t));
+    for (ptrdiff_t i = 0; i < n; i++) counts[bytes[i * s->size]]++;
+
+    return (counts[bytes[0]] == n) ? bytes[0] : -1;
+}
+
+static void msd_prefix(const ptrdiff_t * counts, ptrdiff_t * cursors){
+    ptrdiff_t sum = 0;
+    for (int b = 0; b < MSD_BUCKETS; b++) {
+        cursors[b] = sum;
+        sum += counts[b];
+    }
+}
+
+static inline void scatter_elements(const uint8_t * src, uint8_t * dst, ptrdiff_t n, ptrdiff_t key_byte, ptrdiff_t * cursors, ptrdiff_t size){
+    for (ptrdiff_t i = 0; i < n; i++) {
+        const uint8_t * element = src + i * size;
+        memcpy(dst + cursors[element[key_byte]]++ * size, element, size);
+    }
+}
+
+/**
+ * @internal
+ * @brief Copy every element of 'src' to its bucket of byte 'depth' in 'dst', at the element index 'cursors' holds for the bucket.
+ */
+static void msd_scatter(const struct msd_sort_ * s, const uint8_t * src, uint8_t * dst, ptrdiff_t n, ptrdiff_t depth, ptrdiff_t * cursors){
+    ptrdiff_t key_byte = s->key_offset + depth;
+
+    // Constant sizes turn the copies into a few moves.
+    switch (s->size) {
+        case 4: scatter_elements(src, dst, n, key_byte, cursors, 4); break;
+        case 8: scatter_elements(src, dst, n, key_byte, cursors, 8); break;
+        case 16: scatter_elements(src, dst, n, key_byte, cursors, 16); break;
+        case 32: scatter_elements(src, dst, n, key_byte, cursors, 32); break;
+        default: scatter_elements(src, dst, n, key_byte, cursors, s->size); break;
+    }
+}
+
+static void msd_sort_in_place(const struct msd_sort_ * s, uint8_t * data, uint8_t * scratch, ptrdiff_t n, ptrdiff_t depth);
+
+/**
+ * @internal
+ * @brief Sort the 'n' elements of 'src' into 'dst', overwriting 'src'. The keys agree on the bytes before 'depth'.
+ */
+static void msd_sort_into(const struct msd_sort_ * s, uint8_t * src, uint8_t * dst, ptrdiff_t n, ptrdiff_t depth){
+    ptrdiff_t * counts;
+
+    // Bytes every key shares need no pass.
+    for (;; depth++) {
+        if (n <= MSD_INSERTION_MAX || depth == s->key_size) {
+            memcpy(dst, src, n * s->size);
+            if (depth < s->key_size) msd_insertion_sort(s, dst, n, depth);
+            return;
+        }
+
+        counts = s->counts + depth * MSD_BUCKETS;
+        if (msd_histogram(s, src, n, depth, counts) < 0) break;
+    }
+
+    msd_prefix(counts, s->cursors);
+    msd_scatter(s, src, dst, n, depth, s->cursors);
+
+    ptrdiff_t first = 0;
+    for (int b = 0; b < MSD_BUCKETS; b++) {
+        if (counts[b] > 1) msd_sort_in_place(s, dst + first * s->size, src + first * s->size, counts[b], depth + 1);
+        first += counts[b];
+    }
+}
+
+/**
+ * @internal
+ * @brief Sort the 'n' elements of 'data', with as many bytes of 'scratch'. The keys agree on the bytes before 'depth'.
+ */
+static void msd_sort_in_place(const struct msd_sort_ * s, uint8_t * data, uint8_t * scratch, ptrdiff_t n, ptrdiff_t depth){
+    ptrdiff_t * counts;
+
+    for (;; depth++) {
+        if (depth == s->key_size) return;
+
+        if (n <= MSD_INSERTION_MAX) {
+            msd_insertion_sort(s, data, n, depth);
+            return;
+        }
+
+        counts = s->counts + depth * MSD_BUCKETS;
+        if (msd_histogram(s, data, n, depth, counts) < 0) break;
+    }
+
+    msd_prefix(counts, s->cursors);
+    msd_scatter(s, data, scratch, n, depth, s->cursors);
+
+    ptrdiff_t first = 0;
+    for (int b = 0; b < MSD_BUCKETS; b++) {
+        if (counts[b] > 0) msd_sort_into(s, scratch + first * s->size, data + first * s->size, counts[b], depth + 1);
+        first += counts[b];
+    }
+}
+
+static void * msd_count(void * arg){
+    struct msd_task_ * task = arg;
+
+    msd_histogram(&task->sort, task->data + task->first * task->sort.size, task->last - task->first, task->depth, task->counts);
+
+    return 0;
+}
+
+static void * msd_distribute(void * arg){
+    struct msd_task_ * task = arg;
+
+    msd_scatter(&task->sort, task->data + task->first * task->sort.size, task->scratch, task->last - task->first, task->depth, task->counts);
+
+    return 0;
+}
+
+static void * msd_sort_buckets(void * arg){
+    struct msd_task_ * task = arg;
+    ptrdiff_t size = task->sort.size;
+
+    for (;;) {
+        int b = __atomic_fetch_add(task->next_bucket, 1, __ATOMIC_RELAXED);
+        if (b >= task->nr_buckets) break;
+
+        const struct msd_bucket_ * bucket = &task->buckets[b];
+        msd_sort_into(&task->sort, task->scratch + bucket->first * size, task->data + bucket->first * size, bucket->count, task->depth + 1);
+    }
+
+    return 0;
+}
+
+static void run_msd_tasks(void * (*fn)(void *), struct msd_task_ * tasks, int nr_tasks){
+    for (int t = 1; t < nr_tasks; t++) {
+        tasks[t].started = (pthread_create(&tasks[t].thread, 0, fn, &tasks[t]) == 0);
+        if (!tasks[t].started) fn(&tasks[t]);
+    }
+
+    fn(&tasks[0]);
+
+    for (int t = 1; t < nr_tasks; t++) {
+        if (tasks[t].started) pthread_join(tasks[t].thread, 0);
+    }
+}
+
+/**
+ * @internal
+ * @brief Top level pass on all threads: partition 'data' into 'scratch' on the first byte where keys differ,
+ *        then sort the buckets back into 'data', largest first, each on whichever thread is free.
+ */
+static void msd_sort_parallel(struct msd_task_ * tasks, int nr_tasks, ptrdiff_t n){
+    const struct msd_sort_ * s = &tasks[0].sort;
+    uint8_t first_key_byte;
+    ptrdiff_t totals[MSD_BUCKETS];
+    ptrdiff_t depth = 0;
+
+    for (;; depth++) {
+        if (depth == s->key_size) return;
+
+        for (int t = 0; t < nr_tasks; t++) tasks[t].depth = depth;
+        run_msd_tasks(msd_count, tasks, nr_tasks);
+
+        memset(totals, 0, sizeof(totals));
+        for (int t = 0; t < nr_tasks; t++) {
+            for (int b = 0; b < MSD_BUCKETS; b++) totals[b] += tasks[t].counts[b];
+        }
+
+        first_key_byte = tasks[0].data[s->key_offset + depth];
+        if (totals[first_key_byte] != n) break;
+    }
+
+    // Bucket-major, then thread-major write positions keep the pass stable.
+    ptrdiff_t position = 0;
+    for (int b = 0; b < MSD_BUCKETS; b++) {
+        for (int t = 0; t < nr_tasks; t++) {
+            ptrdiff_t count = tasks[t].counts[b];
+            tasks[t].counts[b] = position;
+            position += count;
+        }
+    }
+
+    run_msd_tasks(msd_distribute, tasks, nr_tasks);
+
+    struct msd_bucket_ buckets[MSD_BUCKETS];
+    int nr_buckets = 0;
+    position = 0;
+
+    for (int b = 0; b < MSD_BUCKETS; b++) {
+        if (totals[b] == 0) continue;
+
+        // Insert by descending size, so the large buckets do not end up last on one thread.
+        int i = nr_buckets++;
+        while (i > 0 && buckets[i - 1].count < totals[b]) {
+            buckets[i] = buckets[i - 1];
+            i--;
+        }
+        buckets[i].first = position;
+        buckets[i].count = totals[b];
+        position += totals[b];
+    }
+
+    int next_bucket = 0;
+    for (int t = 0; t < nr_tasks; t++) {
+        tasks[t].buckets = buckets;
+        tasks[t].nr_buckets = nr_buckets;
+        tasks[t].next_bucket = &next_bucket;
+    }
+
+    run_msd_tasks(msd_sort_buckets, tasks, nr_tasks);
+}
+
+int vvectorSortBytes(vvector vec, ptrdiff_t key_offset, ptrdiff_t key_size, int nr_threads, struct vvectorAlloc * allocator){
+    if (!vec || !*vec) return VEC_ENOVEC;
+
+    ptrdiff_t size = vvectorGetElementSize(vec);
+
+    if (key_offset < 0 || key_size < 1 || key_offset > size - key_size) return VEC_EBADINDEX;
+
+    ptrdiff_t n = vvectorGetLength(vec);
+    if (n < 2) return 0;
+
+    if (nr_threads < 1) nr_threads = 1;
+    if (nr_threads > 1 && n / nr_threads < MIN_ROWS_PER_THREAD) nr_threads = (int) (n / MIN_ROWS_PER_THREAD);
+    if (nr_threads < 1) nr_threads = 1;
+
+    // Per thread: the counters of every key byte, write positions and one element; then the scratch copy of the data.
+    ptrdiff_t words = (key_size + 1) * MSD_BUCKETS + (size + (ptrdiff_t) sizeof(ptrdiff_t) - 1) / (ptrdiff_t) sizeof(ptrdiff_t);
+    ptrdiff_t bytes = nr_threads * words * (ptrdiff_t) sizeof(ptrdiff_t) + n * size;
+
+    ptrdiff_t * arena = sort_malloc(allocator, bytes);
+    if (!arena) return VEC_ENOVEC;
+
+    uint8_t * data = vvectorGetFront(vec);
+    uint8_t * scratch = (uint8_t *) (arena + nr_threads * words);
+
+    struct msd_task_ task_on_stack;
+    ptrdiff_t tasks_size = nr_threads * (ptrdiff_t) sizeof(struct msd_task_);
+    struct msd_task_ * tasks = (nr_threads == 1) ? &task_on_stack : sort_malloc(allocator, tasks_size);
+    if (!tasks) {
+        sort_free(allocator, arena, bytes);
+        return VEC_ENOVEC;
+    }
+
+    for (int t = 0; t < nr_threads; t++) {
+        ptrdiff_t * own = arena + t * words;
+
+        tasks[t].sort.size = size;
+        tasks[t].sort.key_offset = key_offset;
+        tasks[t].sort.key_size = key_size;
+        tasks[t].sort.counts = own;
+        tasks[t].sort.cursors = own + key_size * MSD_BUCKETS;
+        tasks[t].sort.tmp = (uint8_t *) (own + (key_size + 1) * MSD_BUCKETS);
+        tasks[t].data = data;
+        tasks[t].scratch = scratch;
+        tasks[t].first = n * t / nr_threads;
+        tasks[t].last = n * (t + 1) / nr_threads;
+    }
+
+    if (nr_threads == 1) msd_sort_in_place(&tasks[0].sort, data, scratch, n, 0);
+    else msd_sort_parallel(tasks, nr_threads, n);
+
+    if (tasks != &task_on_stack) sort_free(allocator, tasks, tasks_size);
+    sort_free(allocator, arena, bytes);
+
+    return 0;
+}
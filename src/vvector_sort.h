@@ -0,0 +1,144 @@
+/*
+    Copyright 2024 I. Laurentiu
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef VVECTOR_SORT_H
+#define VVECTOR_SORT_H
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+#include "vvector.h"
+#include "vvector_filter.h"
+
+#include <stddef.h>
+
+/// @file vvector_sort.h
+
+/*
+ * A permutation is a vvector of ptrdiff_t where element 'i' is the index of the element which goes to position 'i'.
+ * Sorting several parallel vvectors (the columns of a table) by one of them is one argsort and one permutation per column:
+ *
+ * @code
+ * vvector order = vvectorNew(ptrdiff_t, 0);
+ * vvectorArgsort(timestamps, VVECTOR_INT64, order, 0);
+ *
+ * vvectorApplyPermutation(timestamps, order, 0);
+ * vvectorApplyPermutation(prices, order, 0);
+ * vvectorApplyPermutation(volumes, order, 0);
+ * @endcode
+ */
+
+/**
+ * @brief Comparison callback, like qsort's, with a context pointer.
+ *
+ * @param   a       Pointer to the first element.
+ * @param   b       Pointer to the second element.
+ * @param   ctx     The 'ctx' passed to the sort.
+ * @return  A negative value if a goes before b, a positive one if after, 0 if they are equivalent.
+ */
+typedef int (*vvectorCompareFn)(const void * a, const void * b, void * ctx);
+
+/**
+ * @brief Sort a vvector of numbers in place, in ascending order.
+ *
+ * Up to 256 elements are sorted by a branch free bitonic sorting network, with AVX2 or AVX-512 when the CPU has them.
+ * Longer vvectors get the radix sort of 'vvectorArgsort'. Floats are ordered like 'vvectorArgsort' orders them.
+ *
+ * @param   vec         vvector of 'type' elements.
+ * @param   type        Element type. Its size must match the element size of 'vec'.
+ * @param   allocator   Allocator for temporary buffers, or NULL for defaults. @see vvectorAlloc.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorSort(vvector vec, enum vvectorScalarType type, struct vvectorAlloc * allocator);
+
+/**
+ * @brief Compute the permutation which sorts a vvector of numbers in ascending order.
+ *
+ * LSD radix sort of (key, index) pairs, 11 bits per pass, with every histogram computed in one read of the keys.
+ * Passes where every key has the same digit are skipped. The sort is stable. Floats order -0.0 before +0.0
+ * and NaNs with the sign bit clear after +inf. Up to 256 keys of 32 bits or fewer are sorted together with their index
+ * by the sorting network of 'vvectorSort' instead.
+ *
+ * @param   keys        vvector of 'type' elements.
+ * @param   type        Element type. Its size must match the element size of 'keys'.
+ * @param   permutation vvector of ptrdiff_t, resized to the length of 'keys'.
+ * @param   allocator   Allocator for temporary buffers, or NULL for defaults. @see vvectorAlloc.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorArgsort(vvector keys, enum vvectorScalarType type, vvector permutation, struct vvectorAlloc * allocator);
+
+/**
+ * @brief Compute the permutation which sorts a vvector of any element type with a comparison callback.
+ *
+ * Stable merge sort of the indices, O(n log n) comparisons.
+ *
+ * @param   vec         The vvector.
+ * @param   compare     Comparison callback, called with pointers to two elements of 'vec'.
+ * @param   ctx         Passed to 'compare'.
+ * @param   permutation vvector of ptrdiff_t, resized to the length of 'vec'.
+ * @param   allocator   Allocator for temporary buffers, or NULL for defaults. @see vvectorAlloc.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorArgsortBy(vvector vec, vvectorCompareFn compare, void * ctx, vvector permutation, struct vvectorAlloc * allocator);
+
+/**
+ * @brief Reorder a vvector in place so that new element 'i' is old element permutation[i].
+ *
+ * Follows the permutation's cycles, moving every element once, with one bit of scratch per element to mark visited positions.
+ *
+ * @param   vec         The vvector.
+ * @param   permutation vvector of ptrdiff_t, a permutation of [0, length of 'vec').
+ * @param   allocator   Allocator for the visited bitmap, or NULL for defaults. @see vvectorAlloc.
+ * @return  Returns 0 on success or a positive, non-zero value on error, e.g. if 'permutation' repeats an index.
+ */
+int vvectorApplyPermutation(vvector vec, vvector permutation, struct vvectorAlloc * allocator);
+
+/**
+ * @brief Write the elements of 'vec' to 'out' in permutation order, out[i] = vec[permutation[i]], on several threads.
+ *
+ * Faster than the in place version when the memory is available: every thread gathers a contiguous slice of 'out'.
+ *
+ * @param   vec         The source vvector.
+ * @param   permutation vvector of ptrdiff_t, indices into 'vec'.
+ * @param   out         vvector with the element size of 'vec', resized to the length of 'permutation'. Must not be 'vec'.
+ * @param   nr_threads  Number of threads, including the calling one. Small inputs use fewer.
+ * @param   allocator   Allocator for the per thread bookkeeping, or NULL for defaults. @see vvectorAlloc.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorApplyPermutationTo(vvector vec, vvector permutation, vvector out, int nr_threads, struct vvectorAlloc * allocator);
+
+/**
+ * @brief Sort a vvector of any element type in place by a byte range of its elements, compared like memcmp.
+ *
+ * For fixed width binary keys: hashes, UUIDs, big endian integers and composite keys. MSD radix sort, one key byte
+ * per level, which skips bytes all keys of a bucket share and insertion sorts buckets of 32 elements or fewer.
+ * With several threads, the first level is partitioned on all of them and its buckets are sorted in parallel.
+ * The sort is stable. Needs a temporary copy of the vvector.
+ *
+ * @param   vec         The vvector.
+ * @param   key_offset  Offset of the key inside an element, in bytes.
+ * @param   key_size    Size of the key in bytes. The key must fit inside the element.
+ * @param   nr_threads  Number of threads, including the calling one. Small inputs use fewer.
+ * @param   allocator   Allocator for temporary buffers, or NULL for defaults. @see vvectorAlloc.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorSortBytes(vvector vec, ptrdiff_t key_offset, ptrdiff_t key_size, int nr_threads, struct vvectorAlloc * allocator);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VVECTOR_SORT_H
@@ -0,0 +1,286 @@
+/*
+    Copyright 2024 I. Laurentiu
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "vvector_window.h"
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// @file vvector_window.c
+
+#define VEC_ENOVEC 1        /**< Indicates that the provided window argument is NULL. */
+#define VEC_EBADINDEX 2     /**< Indicates that the provided count is negative. */
+#define VEC_ENOVALUE 3      /**< Indicates that the provided value pointer is NULL. */
+
+/**
+ * @internal
+ * @struct vvector_deque_
+ * @brief A monotonic deque of sample sequence numbers, in a ring of 'size' slots.
+ *
+ * 'head' and 'tail' only grow; slot = counter % size. Never holds more than 'size' entries, one per sample in the window.
+ */
+struct vvector_deque_ {
+    vvector storage;
+    ptrdiff_t * slots;
+    ptrdiff_t head;
+    ptrdiff_t tail;
+};
+
+struct vvectorWindow {
+    ptrdiff_t size;
+    ptrdiff_t next;                 /**< Sequence number of the next sample, i.e. the number of samples pushed since the last clear. */
+
+    vvector storage;                /**< 'size' doubles, sample 'seq' is at seq % size. */
+    double * samples;
+
+    struct vvector_deque_ min;      /**< Increasing values, the front is the minimum. */
+    struct vvector_deque_ max;      /**< Decreasing values, the front is the maximum. */
+
+    double sum;
+    ptrdiff_t since_recompute;      /**< Samples added to 'sum' incrementally since it was last recomputed. */
+
+    struct vvectorAlloc alloc;      /**< Used for this struct. Missing functions fall back to the C library. */
+};
+
+/* Helpers */
+
+static void * window_malloc(struct vvectorAlloc * alloc, ptrdiff_t size){
+    if (alloc && alloc->malloc_fn) return alloc->malloc_fn(size, alloc->ctx);
+
+    return malloc(size);
+}
+
+static void window_free(struct vvectorAlloc * alloc, void * ptr, ptrdiff_t size){
+    if (alloc && alloc->free_fn) {
+        alloc->free_fn(ptr, size, alloc->ctx);
+        return;
+    }
+
+    free(ptr);
+}
+
+/**
+ * @internal
+ * @brief Create a vvector of 'length' uninitialized elements, which is never resized afterwards.
+ *
+ * @return The vvector and its data in 'data', or NULL.
+ */
+static vvector new_fixed(ptrdiff_t element_size, ptrdiff_t length, struct vvectorAlloc * allocator, void ** data){
+    vvector vec = vec_new_(element_size, allocator);
+    if (!vec) return 0;
+
+    if (vvectorResizeUninit(vec, length)) {
+        vvectorFree(vec);
+        return 0;
+    }
+
+    *data = vvectorGetFront(vec);
+
+    return vec;
+}
+
+static double sample_at(struct vvectorWindow * window, ptrdiff_t seq){
+    return window->samples[seq % window->size];
+}
+
+/**
+ * @internal
+ * @brief Add sample 'seq' to a deque, after dropping every sample at the back which it BEATS (<= for min, >= for max)
+ *        and the sample at the front if it leaves the window.
+ *
+ * The deque has one slot per sample in the window, so the front must be dropped before writing 'seq':
+ * when the deque is full, the front shares its ring slot with the new sample.
+ */
+#define DEQUE_PUSH(WINDOW, DEQUE, SEQ, VALUE, BEATS)                                        \
+    do {                                                                                    \
+        struct vvector_deque_ * d_ = (DEQUE);                                               \
+        while (d_->tail > d_->head) {                                                       \
+            double back_ = sample_at((WINDOW), d_->slots[(d_->tail - 1) % (WINDOW)->size]); \
+            if (!((VALUE) BEATS back_)) break;                                              \
+            d_->tail--;                                                                     \
+        }                                                                                   \
+        if (d_->tail > d_->head &&                                                          \
+            d_->slots[d_->head % (WINDOW)->size] <= (SEQ) - (WINDOW)->size) d_->head++;     \
+        d_->slots[d_->tail++ % (WINDOW)->size] = (SEQ);                                     \
+    } while (0)
+
+/**
+ * @internal
+ * @brief Recompute the sum exactly, from the samples in the window.
+ */
+static void recompute_sum(struct vvectorWindow * window){
+    ptrdiff_t length = vvectorWindowGetLength(window);
+    double sum = 0;
+
+    for (ptrdiff_t i = 0; i < length; i++) {
+        sum += window->samples[i];
+    }
+
+    window->sum = sum;
+    window->since_recompute = 0;
+}
+
+/**
+ * @internal
+ * @brief Push one sample. The sum is recomputed after 'size' incremental updates, O(1) amortized.
+ */
+static void push_one(struct vvectorWindow * window, double value){
+    ptrdiff_t seq = window->next++;
+    ptrdiff_t slot = seq % window->size;
+
+    double evicted = (seq >= window->size) ? window->samples[slot] : 0;
+    window->samples[slot] = value;
+
+    // Equal values replace older ones: the newer one stays in the window longer.
+    DEQUE_PUSH(window, &window->min, seq, value, <=);
+    DEQUE_PUSH(window, &window->max, seq, value, >=);
+
+    window->sum += value - evicted;
+
+    if (++window->since_recompute >= window->size) {
+        recompute_sum(window);
+    }
+}
+
+/* Create and destroy */
+
+struct vvectorWindow * vvectorWindowNew(ptrdiff_t size, struct vvectorAlloc * allocator){
+    if (size <= 0) return 0;
+
+    struct vvectorWindow * window = window_malloc(allocator, sizeof(struct vvectorWindow));
+    if (!window) return 0;
+
+    memset(window, 0, sizeof(struct vvectorWindow));
+    if (allocator) window->alloc = *allocator;
+    window->size = size;
+
+    void * samples = 0;
+    void * min_slots = 0;
+    void * max_slots = 0;
+
+    window->storage = new_fixed(sizeof(double), size, allocator, &samples);
+    window->min.storage = new_fixed(sizeof(ptrdiff_t), size, allocator, &min_slots);
+    window->max.storage = new_fixed(sizeof(ptrdiff_t), size, allocator, &max_slots);
+
+    if (!window->storage || !window->min.storage || !window->max.storage) {
+        vvectorWindowFree(window);
+        return 0;
+    }
+
+    window->samples = samples;
+    window->min.slots = min_slots;
+    window->max.slots = max_slots;
+
+    return window;
+}
+
+int vvectorWindowFree(struct vvectorWindow * window){
+    if (!window) return VEC_ENOVEC;
+
+    if (window->storage) vvectorFree(window->storage);
+    if (window->min.storage) vvectorFree(window->min.storage);
+    if (window->max.storage) vvectorFree(window->max.storage);
+
+    struct vvectorAlloc alloc = window->alloc;
+    window_free(&alloc, window, sizeof(struct vvectorWindow));
+
+    return 0;
+}
+
+/* Update */
+
+int vvectorWindowPush(struct vvectorWindow * window, double value){
+    if (!window) return VEC_ENOVEC;
+
+    push_one(window, value);
+
+    return 0;
+}
+
+int vvectorWindowPushMany(struct vvectorWindow * window, const double * values, ptrdiff_t count){
+    if (!window) return VEC_ENOVEC;
+
+    if (count < 0) return VEC_EBADINDEX;
+
+    if (count == 0) return 0;
+
+    if (!values) return VEC_ENOVALUE;
+
+    // Samples older than the last 'size' would be evicted by this same batch.
+    if (count > window->size) {
+        ptrdiff_t skipped = count - window->size;
+
+        vvectorWindowClear(window);
+        // Keep sequence numbers, and so ring slots, the same as if every sample had been pushed.
+        window->next = skipped;
+        window->min.head = window->min.tail = skipped;
+        window->max.head = window->max.tail = skipped;
+
+        values += skipped;
+        count = window->size;
+    }
+
+    for (ptrdiff_t i = 0; i < count; i++) {
+        push_one(window, values[i]);
+    }
+
+    return 0;
+}
+
+int vvectorWindowClear(struct vvectorWindow * window){
+    if (!window) return VEC_ENOVEC;
+
+    window->next = 0;
+    window->min.head = window->min.tail = 0;
+    window->max.head = window->max.tail = 0;
+    window->sum = 0;
+    window->since_recompute = 0;
+
+    return 0;
+}
+
+/* Queries */
+
+ptrdiff_t vvectorWindowGetLength(struct vvectorWindow * window){
+    if (!window) return 0;
+
+    return (window->next < window->size) ? window->next : window->size;
+}
+
+double vvectorWindowGetMin(struct vvectorWindow * window){
+    if (!window || window->next == 0) return NAN;
+
+    return sample_at(window, window->min.slots[window->min.head % window->size]);
+}
+
+double vvectorWindowGetMax(struct vvectorWindow * window){
+    if (!window || window->next == 0) return NAN;
+
+    return sample_at(window, window->max.slots[window->max.head % window->size]);
+}
+
+double vvectorWindowGetSum(struct vvectorWindow * window){
+    if (!window) return NAN;
+
+    return window->sum;
+}
+
+double vvectorWindowGetMean(struct vvectorWindow * window){
+    if (!window || window->next == 0) return NAN;
+
+    return window->sum / vvectorWindowGetLength(window);
+}
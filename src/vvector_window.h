@@ -0,0 +1,141 @@
+/*
+    Copyright 2024 I. Laurentiu
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef VVECTOR_WINDOW_H
+#define VVECTOR_WINDOW_H
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+#include "vvector.h"
+
+#include <stddef.h>
+
+/// @file vvector_window.h
+
+/**
+ * @struct vvectorWindow
+ *
+ * @brief   Min, max, sum and mean of the last N samples, updated in O(1) amortized time per sample.
+ *
+ * Samples are kept in a ring buffer. Min and max come from monotonic deques: a new sample drops every older
+ * sample it beats, since those can never be the answer again. The sum is updated incrementally and recomputed
+ * exactly once every N samples, so floating point error can not build up.
+ *
+ * All storage lives in vvectors allocated once, when the window is created.
+ * Samples must not be NaN.
+ *
+ * @code
+ * struct vvectorWindow * latency = vvectorWindowNew(1000, 0);
+ * for (;;) {
+ *      vvectorWindowPush(latency, next_sample());
+ *      printf("max over the last 1000: %f\n", vvectorWindowGetMax(latency));
+ * }
+ * @endcode
+ */
+struct vvectorWindow;
+
+/**
+ * @brief Create a new, empty window.
+ *
+ * @param   size        Number of samples in a full window.
+ * @param   allocator   Allocator for the window's storage, or NULL for defaults. @see vvectorAlloc.
+ * @return  The new window or NULL.
+ */
+struct vvectorWindow * vvectorWindowNew(ptrdiff_t size, struct vvectorAlloc * allocator);
+
+/**
+ * @brief Free the window.
+ *
+ * @param   window  The window.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorWindowFree(struct vvectorWindow * window);
+
+/**
+ * @brief Add a sample. Once the window is full, the oldest sample leaves it.
+ *
+ * @param   window  The window.
+ * @param   value   The sample.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorWindowPush(struct vvectorWindow * window, double value);
+
+/**
+ * @brief Add 'count' samples, oldest first. Same result as pushing them one by one.
+ *
+ * Only the last 'size' samples can end up in the window, any before them are skipped.
+ *
+ * @param   window  The window.
+ * @param   values  Pointer to 'count' samples.
+ * @param   count   Number of samples.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorWindowPushMany(struct vvectorWindow * window, const double * values, ptrdiff_t count);
+
+/**
+ * @brief Remove every sample.
+ *
+ * @param   window  The window.
+ * @return  Returns 0 on success or a positive, non-zero value on error.
+ */
+int vvectorWindowClear(struct vvectorWindow * window);
+
+/**
+ * @brief Get the number of samples in the window, at most its size.
+ *
+ * @param   window  The window.
+ * @return  The number of samples, or 0 on error.
+ */
+ptrdiff_t vvectorWindowGetLength(struct vvectorWindow * window);
+
+/**
+ * @brief Get the smallest sample in the window.
+ *
+ * @param   window  The window.
+ * @return  The smallest sample, or NaN if the window is empty or on error.
+ */
+double vvectorWindowGetMin(struct vvectorWindow * window);
+
+/**
+ * @brief Get the largest sample in the window.
+ *
+ * @param   window  The window.
+ * @return  The largest sample, or NaN if the window is empty or on error.
+ */
+double vvectorWindowGetMax(struct vvectorWindow * window);
+
+/**
+ * @brief Get the sum of the samples in the window.
+ *
+ * @param   window  The window.
+ * @return  The sum, 0 if the window is empty, or NaN on error.
+ */
+double vvectorWindowGetSum(struct vvectorWindow * window);
+
+/**
+ * @brief Get the mean of the samples in the window.
+ *
+ * @param   window  The window.
+ * @return  The mean, or NaN if the window is empty or on error.
+ */
+double vvectorWindowGetMean(struct vvectorWindow * window);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VVECTOR_WINDOW_H